@@ -3,19 +3,23 @@
 AstPrinter::AstPrinter() {}
 
 void AstPrinter::visit_binary_expr(const Expr::Binary &binary) {
-    parenthesize(binary.op.lexeme, binary.left.get(), binary.right.get());
+    parenthesize(binary.op.lexeme, binary.left, binary.right);
 }
 
 void AstPrinter::visit_grouping_expr(const Expr::Grouping &grouping) {
-    parenthesize("group", grouping.expression.get());
+    parenthesize("group", grouping.expression);
 }
 
 void AstPrinter::visit_literal_expr(const Expr::Literal &literal) {
-    result << literal.value.literal_to_string();
+    if (literal.value.literal.has_value()) {
+        result << literal.value.literal_to_string();
+    } else {
+        result << literal.value.lexeme;
+    }
 }
 
 void AstPrinter::visit_unary_expr(const Expr::Unary &unary) {
-    parenthesize(unary.op.lexeme, unary.right.get());
+    parenthesize(unary.op.lexeme, unary.right);
 }
 
 std::string AstPrinter::get_string() const { return result.str(); }
@@ -18,14 +18,14 @@ struct AstPrinter : ExprVisitor {
   private:
     template <typename... Args>
     requires are_all_eq<Expr, Args...>
-    void parenthesize(const std::string &name, const Args *...exprs) {
+    void parenthesize(std::string_view name, const Args *...exprs) {
         result << "(" << name << " ";
         bool first_iter = true;
         for (const auto &expr : {exprs...}) {
             if (!first_iter) {
                 result << " ";
             }
-            expr->accept(*this);
+            dispatch(*expr, *this);
             first_iter = false;
         }
         result << ")";
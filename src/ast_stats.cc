@@ -0,0 +1,129 @@
+#include "src/ast_stats.h"
+
+#include <fmt/format.h>
+
+AstStats::AstStats() : counts(), specialized() {}
+
+void AstStats::add(const std::pmr::vector<Stmt *> &stmts) {
+    for (const auto &stmt : stmts) {
+        add(stmt);
+    }
+}
+
+void AstStats::add(const Expr *expr) {
+    if (expr != nullptr) {
+        dispatch(*expr, *this);
+    }
+}
+
+void AstStats::add(const Stmt *stmt) {
+    if (stmt != nullptr) {
+        dispatch(*stmt, *this);
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const AstStats &stats) {
+    auto count = [&stats](BinarySpecialization specialization) {
+        return stats.counts[static_cast<size_t>(specialization)];
+    };
+    os << fmt::format(
+        "ast: {} binary nodes: {} number, {} string, {} generic, {} never "
+        "evaluated",
+        stats.specialized.size() + count(BinarySpecialization::UNINITIALIZED),
+        count(BinarySpecialization::NUMBER),
+        count(BinarySpecialization::STRING),
+        count(BinarySpecialization::GENERIC),
+        count(BinarySpecialization::UNINITIALIZED));
+    for (const auto &[line, op, specialization] : stats.specialized) {
+        os << std::endl
+           << fmt::format("[line {}] {} {}", line, op,
+                          to_string(specialization));
+    }
+    return os;
+}
+
+void AstStats::visit_assign_expr(const Expr::Assign &expr) {
+    add(expr.value);
+}
+
+void AstStats::visit_binary_expr(const Expr::Binary &expr) {
+    ++counts[static_cast<size_t>(expr.specialization)];
+    if (expr.specialization != BinarySpecialization::UNINITIALIZED) {
+        specialized.push_back(
+            {expr.op.line, std::string(expr.op.lexeme), expr.specialization});
+    }
+    add(expr.left);
+    add(expr.right);
+}
+
+void AstStats::visit_call_expr(const Expr::Call &expr) {
+    add(expr.callee);
+    for (const auto &argument : expr.arguments) {
+        add(argument);
+    }
+}
+
+void AstStats::visit_get_expr(const Expr::Get &expr) { add(expr.object); }
+
+void AstStats::visit_grouping_expr(const Expr::Grouping &expr) {
+    add(expr.expression);
+}
+
+void AstStats::visit_lambda_expr(const Expr::Lambda &expr) { add(expr.body); }
+
+void AstStats::visit_literal_expr(const Expr::Literal &expr) {}
+
+void AstStats::visit_logical_expr(const Expr::Logical &expr) {
+    add(expr.left);
+    add(expr.right);
+}
+
+void AstStats::visit_set_expr(const Expr::Set &expr) {
+    add(expr.object);
+    add(expr.value);
+}
+
+void AstStats::visit_super_expr(const Expr::Super &expr) {}
+
+void AstStats::visit_this_expr(const Expr::This &expr) {}
+
+void AstStats::visit_unary_expr(const Expr::Unary &expr) { add(expr.right); }
+
+void AstStats::visit_variable_expr(const Expr::Variable &expr) {}
+
+void AstStats::visit_block_stmt(const Stmt::Block &stmt) {
+    add(stmt.statements);
+}
+
+void AstStats::visit_class_stmt(const Stmt::Class &stmt) {
+    for (const auto &method : stmt.methods) {
+        add(method->body);
+    }
+}
+
+void AstStats::visit_expression_stmt(const Stmt::Expression &stmt) {
+    add(stmt.expression);
+}
+
+void AstStats::visit_if_stmt(const Stmt::If &stmt) {
+    add(stmt.condition);
+    add(stmt.then_branch);
+    add(stmt.else_branch);
+}
+
+void AstStats::visit_function_stmt(const Stmt::Function &stmt) {
+    add(stmt.body);
+}
+
+void AstStats::visit_print_stmt(const Stmt::Print &stmt) {
+    add(stmt.expression);
+}
+
+void AstStats::visit_return_stmt(const Stmt::Return &stmt) { add(stmt.value); }
+
+void AstStats::visit_var_stmt(const Stmt::Var &stmt) { add(stmt.initializer); }
+
+void AstStats::visit_while_stmt(const Stmt::While &stmt) {
+    add(stmt.condition);
+    add(stmt.body);
+}
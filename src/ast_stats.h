@@ -0,0 +1,64 @@
+#pragma once
+
+#include "src/syntactics/expr.h"
+#include "src/syntactics/stmt.h"
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Walks programs after they ran and reports what its Binary nodes specialised
+// to, e.g. to confirm that the arithmetic in hot loops runs on numbers.
+struct AstStats final : ExprVisitor, StmtVisitor {
+    AstStats();
+
+    void add(const std::pmr::vector<Stmt *> &stmts);
+
+    friend std::ostream &operator<<(std::ostream &os, const AstStats &stats);
+
+  private:
+    void add(const Expr *expr);
+    void add(const Stmt *stmt);
+
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
+    void visit_assign_expr(const Expr::Assign &expr) override;
+    void visit_binary_expr(const Expr::Binary &expr) override;
+    void visit_call_expr(const Expr::Call &expr) override;
+    void visit_get_expr(const Expr::Get &expr) override;
+    void visit_grouping_expr(const Expr::Grouping &expr) override;
+    void visit_lambda_expr(const Expr::Lambda &expr) override;
+    void visit_literal_expr(const Expr::Literal &expr) override;
+    void visit_logical_expr(const Expr::Logical &expr) override;
+    void visit_set_expr(const Expr::Set &expr) override;
+    void visit_super_expr(const Expr::Super &expr) override;
+    void visit_this_expr(const Expr::This &expr) override;
+    void visit_unary_expr(const Expr::Unary &expr) override;
+    void visit_variable_expr(const Expr::Variable &expr) override;
+
+    void visit_block_stmt(const Stmt::Block &stmt) override;
+    void visit_class_stmt(const Stmt::Class &stmt) override;
+    void visit_expression_stmt(const Stmt::Expression &stmt) override;
+    void visit_if_stmt(const Stmt::If &stmt) override;
+    void visit_function_stmt(const Stmt::Function &stmt) override;
+    void visit_print_stmt(const Stmt::Print &stmt) override;
+    void visit_return_stmt(const Stmt::Return &stmt) override;
+    void visit_var_stmt(const Stmt::Var &stmt) override;
+    void visit_while_stmt(const Stmt::While &stmt) override;
+
+    struct Specialized {
+        int line;
+        std::string op;
+        BinarySpecialization specialization;
+    };
+
+    // Indexed by BinarySpecialization.
+    std::array<size_t, 4> counts;
+    // Copied out of the nodes, which the REPL frees after every line.
+    std::vector<Specialized> specialized;
+};
@@ -19,10 +19,12 @@ std::string report(int line, const std::string &where,
     return full_message;
 }
 
-std::string report_token_error(const Token &token, const std::string &message) {
+std::string report_token_error(const Token &token, const std::string &message,
+                               bool print_message) {
     if (token.type == END_OF_FILE) {
-        return report(token.line, "at end", message);
+        return report(token.line, "at end", message, print_message);
     } else {
-        return report(token.line, "at '" + token.lexeme + "'", message);
+        return report(token.line, fmt::format("at '{}'", token.lexeme),
+                      message, print_message);
     }
 }
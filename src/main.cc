@@ -1,54 +1,91 @@
 #include "src/ast_printer.h"
+#include "src/ast_stats.h"
+#include "src/semantics/closure_interpreter.h"
+#include "src/semantics/flat_interpreter.h"
 #include "src/semantics/interpreter.h"
 #include "src/semantics/object/lox_callable.h"
 #include "src/semantics/object/lox_function.h"
+#include "src/semantics/optimizer.h"
 #include "src/semantics/resolver.h"
 #include "src/syntactics/expr.h"
 #include "src/syntactics/parser.h"
+#include "src/syntactics/program.h"
 #include "src/syntactics/scanner.h"
+#include "src/syntactics/source.h"
 #include "src/syntactics/token.h"
+#include "src/vm/vm.h"
 
-#include <fstream>
+#include <concepts>
 #include <iostream>
 #include <memory>
 #include <optional>
-#include <sstream>
+#include <string_view>
+#include <type_traits>
 
-std::optional<std::vector<std::shared_ptr<Stmt>>>
-parse_stream(std::istream &&is) {
-    Scanner scanner(std::move(is));
+enum class Engine {
+    TREE_WALKER,
+    CLOSURE_COMPILER,
+    FLAT_WALKER,
+    BYTECODE_VM,
+};
 
-    auto tokens = scanner.scan_tokens();
-    if (scanner.had_error) {
-        return std::nullopt;
-    }
+struct Options {
+    Engine engine = Engine::TREE_WALKER;
+    std::optional<std::string> script;
+    // Only used by the tree-walking interpreters.
+    GcSettings gc_settings;
+    bool gc_stats = false;
+    bool ast_stats = false;
+    // Run the script a declaration at a time, as it is parsed.
+    bool stream = false;
+    // Scan a script, unless streamed, on this many threads.
+    size_t scan_threads = 1;
+    // 0 runs programs as parsed, 1 runs them through the Optimizer first.
+    int optimization_level = 1;
+    bool trace_inlining = false;
+};
 
-    Parser parser(std::move(tokens));
+std::optional<Program> parse_source(std::shared_ptr<const Source> source,
+                                    size_t scan_threads) {
+    Scanner scanner(std::move(source));
+    if (scan_threads > 1) {
+        scanner.scan_ahead(scan_threads);
+    }
+    Parser parser(std::move(scanner));
 
-    auto stmts = parser.parse();
+    auto program = parser.parse();
     if (parser.had_error()) {
         return std::nullopt;
     }
 
-    return stmts;
+    return program;
 }
 
-int interpret_stream(Interpreter &interpreter, std::istream &&is,
-                     InterpreterMode mode) {
-    auto stmts_opt = parse_stream(std::move(is));
-    if (!stmts_opt.has_value()) {
-        return 65;
-    }
+// `whole_program` tells whether the program is all the code that can redefine
+// its globals: not so for a line of the REPL, or a declaration of a streamed
+// script.
+OptimizerSettings optimizer_settings(bool whole_program,
+                                     const Options &options) {
+    return {whole_program, options.trace_inlining ? &std::cerr : nullptr};
+}
 
-    auto stmts = stmts_opt.value();
+template <typename Runtime>
+requires std::derived_from<Runtime, AbstractInterpreter>
+int run_program(Runtime &interpreter, Program &program, InterpreterMode mode,
+                bool whole_program, const Options &options) {
     Resolver resolver{interpreter};
-    resolver.resolve(stmts);
+    resolver.resolve(program.statements);
 
     if (resolver.had_error()) {
         return 66;
     }
+    if (options.optimization_level >= 1) {
+        Optimizer(*program.arena, &interpreter,
+                  optimizer_settings(whole_program, options))
+            .optimize(program.statements);
+    }
 
-    interpreter.interpret(stmts, mode);
+    interpreter.interpret(program.statements, mode);
     if (interpreter.had_runtime_error()) {
         return 70;
     }
@@ -56,34 +93,237 @@ int interpret_stream(Interpreter &interpreter, std::istream &&is,
     return 0;
 }
 
-int run_interpreter() {
-    Interpreter interpreter{};
+int run_program(VirtualMachine &vm, Program &program, InterpreterMode mode,
+                bool whole_program, const Options &options) {
+    Resolver resolver{};
+    resolver.resolve(program.statements);
 
+    if (resolver.had_error()) {
+        return 66;
+    }
+    if (options.optimization_level >= 1) {
+        Optimizer(*program.arena, nullptr,
+                  optimizer_settings(whole_program, options))
+            .optimize(program.statements);
+    }
+
+    vm.interpret(program.statements, mode);
+    if (vm.had_compile_error()) {
+        return 65;
+    }
+    if (vm.had_runtime_error()) {
+        return 70;
+    }
+
+    return 0;
+}
+
+// The program is kept in `programs`, since what it declares may still be used
+// by later ones. `ast_stats`, if given, takes in the program once it ran.
+template <typename Runtime>
+int interpret_source(Runtime &engine, std::shared_ptr<const Source> source,
+                     InterpreterMode mode, std::vector<Program> &programs,
+                     AstStats *ast_stats, const Options &options) {
+    auto program = parse_source(std::move(source), options.scan_threads);
+    if (!program.has_value()) {
+        return 65;
+    }
+    Program &kept = programs.emplace_back(std::move(*program));
+
+    int status = run_program(engine, kept, mode,
+                             mode == InterpreterMode::FILE, options);
+    if (ast_stats != nullptr) {
+        ast_stats->add(kept.statements);
+    }
+    return status;
+}
+
+template <typename Runtime>
+int run_interpreter(Runtime &engine, std::vector<Program> &programs,
+                    AstStats *ast_stats, const Options &options) {
     std::string s;
     std::cout << "> ";
     while (std::getline(std::cin, s)) {
-        interpret_stream(interpreter, std::stringstream(s),
-                         InterpreterMode::INTERACTIVE);
+        interpret_source(engine, std::make_unique<Source>(std::move(s)),
+                         InterpreterMode::INTERACTIVE, programs, ast_stats,
+                         options);
         std::cout << "> ";
-        interpreter.reset_runtime_error();
+        engine.reset_runtime_error();
     }
     std::cout << std::endl;
     return 0;
 }
 
-int run_file(char *filename) {
-    Interpreter interpreter;
-    std::ifstream ifs(filename);
-    return interpret_stream(interpreter, std::move(ifs), InterpreterMode::FILE);
+template <typename Runtime>
+int run_file(Runtime &engine, const std::string &filename,
+             std::vector<Program> &programs, AstStats *ast_stats,
+             const Options &options) {
+    return interpret_source(engine, Source::open(filename),
+                            InterpreterMode::FILE, programs, ast_stats,
+                            options);
 }
 
-int main(int argc, char **argv) {
-    if (argc == 1) {
-        return run_interpreter();
-    } else if (argc == 2) {
-        return run_file(argv[1]);
+// Whether a `Runtime` still refers to the nodes of `program` after running it.
+// The VM only needs the bytecode it compiled them to, and the tree-walking
+// interpreter only the functions they declare; the closure and flat engines
+// look up what they compiled by node.
+template <typename Runtime>
+bool refers_to_nodes(const Program &program) {
+    if constexpr (std::is_same_v<Runtime, VirtualMachine>) {
+        return false;
+    } else if constexpr (std::is_same_v<Runtime, Interpreter>) {
+        return program.declares_functions;
     } else {
-        std::cout << "Usage: cpplox [script]" << std::endl;
+        return true;
+    }
+}
+
+// Runs each top-level declaration of the script as soon as it is parsed, and
+// frees it unless the engine still refers to it. Unlike with run_file, the
+// declarations before a syntax error run.
+template <typename Runtime>
+int stream_file(Runtime &engine, const std::string &filename,
+                std::vector<Program> &programs, AstStats *ast_stats,
+                const Options &options) {
+    Parser parser(Scanner(Source::open(filename)));
+    while (auto program = parser.parse_declaration()) {
+        if (parser.had_error()) {
+            return 65;
+        }
+
+        int status = run_program(engine, *program, InterpreterMode::FILE,
+                                 false, options);
+        if (ast_stats != nullptr) {
+            ast_stats->add(program->statements);
+        }
+        if (refers_to_nodes<Runtime>(*program)) {
+            programs.push_back(std::move(*program));
+        } else if constexpr (std::is_same_v<Runtime, Interpreter>) {
+            engine.forget(program->statements);
+        }
+        if (status != 0) {
+            return status;
+        }
+    }
+    return parser.had_error() ? 65 : 0;
+}
+
+template <typename Runtime>
+int run(const Options &options) {
+    // Outlives the engine, which refers to the programs' nodes.
+    std::vector<Program> programs;
+    Runtime engine;
+    AstStats ast_stats;
+    AstStats *stats_sink = nullptr;
+    if constexpr (std::derived_from<Runtime, AbstractInterpreter>) {
+        engine.configure_gc(options.gc_settings);
+    }
+    if constexpr (std::is_same_v<Runtime, Interpreter>) {
+        if (options.ast_stats) {
+            stats_sink = &ast_stats;
+        }
+    }
+
+    int status;
+    if (!options.script.has_value()) {
+        status = run_interpreter(engine, programs, stats_sink, options);
+    } else if (options.stream) {
+        status = stream_file(engine, options.script.value(), programs,
+                             stats_sink, options);
+    } else {
+        status = run_file(engine, options.script.value(), programs, stats_sink,
+                          options);
+    }
+
+    if constexpr (std::derived_from<Runtime, AbstractInterpreter>) {
+        if (options.gc_stats) {
+            std::cerr << engine.gc_stats() << std::endl;
+        }
+    }
+    if constexpr (std::is_same_v<Runtime, Interpreter>) {
+        if (options.ast_stats) {
+            std::cerr << ast_stats << std::endl;
+        }
+    }
+    return status;
+}
+
+// Parses the value of a `--name=N` flag.
+std::optional<size_t> parse_size_flag(std::string_view arg,
+                                      std::string_view name) {
+    if (!arg.starts_with(name)) {
+        return std::nullopt;
+    }
+    std::string value(arg.substr(name.size()));
+    if (value.empty() or
+        value.find_first_not_of("0123456789") != std::string::npos) {
+        return std::nullopt;
+    }
+    return std::stoull(value);
+}
+
+std::optional<Options> parse_options(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--engine=tree") {
+            options.engine = Engine::TREE_WALKER;
+        } else if (arg == "--engine=closure") {
+            options.engine = Engine::CLOSURE_COMPILER;
+        } else if (arg == "--engine=flat") {
+            options.engine = Engine::FLAT_WALKER;
+        } else if (arg == "--engine=vm") {
+            options.engine = Engine::BYTECODE_VM;
+        } else if (arg == "--gc-stats") {
+            options.gc_stats = true;
+        } else if (arg == "--ast-stats") {
+            options.ast_stats = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "-O0") {
+            options.optimization_level = 0;
+        } else if (arg == "-O1") {
+            options.optimization_level = 1;
+        } else if (arg == "--trace-inlining") {
+            options.trace_inlining = true;
+        } else if (auto threshold =
+                       parse_size_flag(arg, "--gc-threshold=")) {
+            options.gc_settings.initial_threshold = threshold.value();
+        } else if (auto growth = parse_size_flag(arg, "--gc-growth=");
+                   growth.has_value() and growth.value() >= 1) {
+            options.gc_settings.growth_factor = growth.value();
+        } else if (auto threads = parse_size_flag(arg, "--scan-threads=");
+                   threads.has_value() and threads.value() >= 1) {
+            options.scan_threads = threads.value();
+        } else if (!arg.starts_with("-") and !options.script.has_value()) {
+            options.script = std::string(arg);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+int main(int argc, char **argv) {
+    auto options = parse_options(argc, argv);
+    if (!options.has_value()) {
+        std::cout << "Usage: cpplox [--engine=tree|closure|flat|vm] "
+                     "[--gc-stats] [--gc-threshold=N] [--gc-growth=N] "
+                     "[--ast-stats] [--stream] [--scan-threads=N] [-O0|-O1] "
+                     "[--trace-inlining] [script]"
+                  << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+
+    switch (options->engine) {
+    case Engine::CLOSURE_COMPILER:
+        return run<ClosureInterpreter>(options.value());
+    case Engine::FLAT_WALKER:
+        return run<FlatInterpreter>(options.value());
+    case Engine::BYTECODE_VM:
+        return run<VirtualMachine>(options.value());
+    case Engine::TREE_WALKER:
+    default:
+        return run<Interpreter>(options.value());
+    }
+}
@@ -1,24 +1,331 @@
 #include "abstract_interpreter.h"
 
-AbstractInterpreter::AbstractInterpreter()
-    : environments(), curr_environment(&environments.globals()), locals() {}
+#include <algorithm>
+#include <cassert>
 
-void AbstractInterpreter::execute(const std::shared_ptr<Stmt> &stmt) {
-    return execute(stmt.get());
+namespace {
+
+// Erases the entries of the nodes it walks from an interpreter's locals, scope
+// sizes, declaration slots and tail calls.
+struct Forgetter final : ExprVisitor, StmtVisitor {
+    using Locals = std::unordered_map<const Expr *, VariableLocation>;
+    using ScopeSizes =
+        std::unordered_map<const std::pmr::vector<Stmt *> *, size_t>;
+    using DeclarationSlots = std::unordered_map<const Token *, size_t>;
+    using TailCalls = std::unordered_set<const Expr *>;
+
+    Forgetter(Locals &locals, ScopeSizes &scope_sizes,
+              DeclarationSlots &declaration_slots, TailCalls &tail_calls)
+        : locals(locals), scope_sizes(scope_sizes),
+          declaration_slots(declaration_slots), tail_calls(tail_calls) {}
+
+    Locals &locals;
+    ScopeSizes &scope_sizes;
+    DeclarationSlots &declaration_slots;
+    TailCalls &tail_calls;
+
+    void forget(const Expr *expr) {
+        if (expr != nullptr) {
+            locals.erase(expr);
+            tail_calls.erase(expr);
+            dispatch(*expr, *this);
+        }
+    }
+
+    void forget(const Stmt *stmt) {
+        if (stmt != nullptr) {
+            dispatch(*stmt, *this);
+        }
+    }
+
+    void forget(const std::pmr::vector<Stmt *> &body) {
+        scope_sizes.erase(&body);
+        for (const Stmt *stmt : body) {
+            forget(stmt);
+        }
+    }
+
+    void visit_assign_expr(const Expr::Assign &expr) override {
+        forget(expr.value);
+    }
+
+    void visit_binary_expr(const Expr::Binary &expr) override {
+        forget(expr.left);
+        forget(expr.right);
+    }
+
+    void visit_call_expr(const Expr::Call &expr) override {
+        forget(expr.callee);
+        for (const Expr *argument : expr.arguments) {
+            forget(argument);
+        }
+    }
+
+    void visit_get_expr(const Expr::Get &expr) override { forget(expr.object); }
+
+    void visit_grouping_expr(const Expr::Grouping &expr) override {
+        forget(expr.expression);
+    }
+
+    void visit_lambda_expr(const Expr::Lambda &expr) override {
+        forget(expr.body);
+    }
+
+    void visit_literal_expr(const Expr::Literal &expr) override {}
+
+    void visit_logical_expr(const Expr::Logical &expr) override {
+        forget(expr.left);
+        forget(expr.right);
+    }
+
+    void visit_set_expr(const Expr::Set &expr) override {
+        forget(expr.object);
+        forget(expr.value);
+    }
+
+    void visit_super_expr(const Expr::Super &expr) override {}
+
+    void visit_this_expr(const Expr::This &expr) override {}
+
+    void visit_unary_expr(const Expr::Unary &expr) override {
+        forget(expr.right);
+    }
+
+    void visit_variable_expr(const Expr::Variable &expr) override {}
+
+    void visit_block_stmt(const Stmt::Block &stmt) override {
+        forget(stmt.statements);
+    }
+
+    void visit_class_stmt(const Stmt::Class &stmt) override {
+        declaration_slots.erase(&stmt.name);
+        forget(stmt.superclass);
+        for (const Stmt::Function *method : stmt.methods) {
+            forget(method->body);
+        }
+    }
+
+    void visit_expression_stmt(const Stmt::Expression &stmt) override {
+        forget(stmt.expression);
+    }
+
+    void visit_if_stmt(const Stmt::If &stmt) override {
+        forget(stmt.condition);
+        forget(stmt.then_branch);
+        forget(stmt.else_branch);
+    }
+
+    void visit_function_stmt(const Stmt::Function &stmt) override {
+        declaration_slots.erase(&stmt.name);
+        forget(stmt.body);
+    }
+
+    void visit_print_stmt(const Stmt::Print &stmt) override {
+        forget(stmt.expression);
+    }
+
+    void visit_return_stmt(const Stmt::Return &stmt) override {
+        forget(stmt.value);
+    }
+
+    void visit_var_stmt(const Stmt::Var &stmt) override {
+        declaration_slots.erase(&stmt.name);
+        forget(stmt.initializer);
+    }
+
+    void visit_while_stmt(const Stmt::While &stmt) override {
+        forget(stmt.condition);
+        forget(stmt.body);
+    }
+};
+
+} // namespace
+
+AbstractInterpreter::AbstractInterpreter(const Natives &natives)
+    : environments(), native_functions(natives), global_table(),
+      curr_environment(&environments.globals()), environment_stack(),
+      temporaries(), constants(), return_value(), locals(), scope_sizes(),
+      declaration_slots(), gc_settings(), m_gc_stats(),
+      next_gc(gc_settings.initial_threshold) {
+    assert(not is_alive and "Only one interpreter may be alive at a time.");
+    is_alive = true;
+    for (const auto &[name, native] : natives) {
+        global_table.define(name, native);
+    }
 }
 
-void AbstractInterpreter::execute_block(
-    const std::vector<std::shared_ptr<Stmt>> &stmts, Environment *environment) {
-    Environment *previous_environment = curr_environment;
-    curr_environment = environment;
+AbstractInterpreter::~AbstractInterpreter() { is_alive = false; }
+
+bool AbstractInterpreter::is_alive = false;
+
+Completion AbstractInterpreter::execute_block(
+    const std::pmr::vector<Stmt *> &stmts, Environment *environment) {
+    EnvironmentScope scope(*this, environment);
     for (const auto &stmt : stmts) {
-        execute(stmt);
+        if (execute(stmt) == Completion::RETURN) {
+            return Completion::RETURN;
+        }
     }
-    curr_environment = previous_environment;
+    return Completion::NORMAL;
+}
+
+Environment *AbstractInterpreter::add_environment(Environment *enclosing,
+                                                  size_t slot_count) {
+    collect_garbage_if_needed(enclosing);
+    return environments.add_environment(enclosing, slot_count);
+}
+
+void AbstractInterpreter::collect_garbage_if_needed(Environment *extra_root) {
+    if (live_count() >= next_gc) {
+        collect_garbage(extra_root);
+    }
+}
+
+void AbstractInterpreter::end_iteration() { collect_garbage_if_needed(); }
+
+void AbstractInterpreter::configure_gc(const GcSettings &settings) {
+    gc_settings = settings;
+    next_gc = settings.initial_threshold;
+}
+
+const GcStats &AbstractInterpreter::gc_stats() const { return m_gc_stats; }
+
+void AbstractInterpreter::collect_garbage(Environment *extra_root) {
+    m_gc_stats.peak_live = std::max(m_gc_stats.peak_live, live_count());
+
+    GarbageCollector collector(environments);
+    mark_roots(collector);
+    collector.mark_environment(extra_root);
+    collector.collect(m_gc_stats);
+
+    next_gc = std::max(live_count() * gc_settings.growth_factor,
+                       gc_settings.initial_threshold);
+}
+
+void AbstractInterpreter::mark_roots(Tracer &tracer) {
+    tracer.mark_environment(globals());
+    global_table.trace(tracer);
+    tracer.mark_environment(curr_environment);
+    for (Environment *environment : environment_stack) {
+        tracer.mark_environment(environment);
+    }
+    for (const auto &[name, native] : native_functions) {
+        tracer.mark_value(native);
+    }
+    for (const LoxObject &temporary : temporaries) {
+        tracer.mark_value(temporary);
+    }
+    for (const LoxObject &constant : constants) {
+        tracer.mark_value(constant);
+    }
+    tracer.mark_value(return_value);
+    if (tail_call.has_value()) {
+        tracer.mark_value(tail_call->function);
+        if (tail_call->this_object.has_value()) {
+            tracer.mark_value(*tail_call->this_object);
+        }
+        for (const LoxObject &argument : tail_call->arguments) {
+            tracer.mark_value(argument);
+        }
+    }
+}
+
+size_t AbstractInterpreter::live_count() const {
+    return environments.size() + Heap::instance().size();
 }
 
 Environment *AbstractInterpreter::globals() { return &environments.globals(); }
 
-void AbstractInterpreter::resolve(const Expr *expr, int depth) {
-    locals[expr] = depth;
+void AbstractInterpreter::resolve(const Expr *expr, int depth, size_t slot) {
+    locals[expr] = {depth, slot};
+}
+
+void AbstractInterpreter::resolve_global(GlobalCache &cache,
+                                         std::string_view name) {
+    cache = {global_table.id(), global_table.slot(name)};
+}
+
+void AbstractInterpreter::resolve_scope(
+    const std::pmr::vector<Stmt *> &body, size_t slot_count) {
+    scope_sizes[&body] = slot_count;
+}
+
+void AbstractInterpreter::resolve_declaration(const Token &name,
+                                              size_t slot) {
+    declaration_slots[&name] = slot;
+}
+
+void AbstractInterpreter::resolve_tail_call(const Expr::Call &call) {
+    tail_calls.insert(&call);
+}
+
+bool AbstractInterpreter::is_tail_call(const Expr *expr) const {
+    return tail_calls.contains(expr);
+}
+
+void AbstractInterpreter::forget(const std::pmr::vector<Stmt *> &stmts) {
+    Forgetter(locals, scope_sizes, declaration_slots, tail_calls)
+        .forget(stmts);
+}
+
+void AbstractInterpreter::forget(const Stmt *stmt) {
+    Forgetter(locals, scope_sizes, declaration_slots, tail_calls)
+        .forget(stmt);
+}
+
+void AbstractInterpreter::forget(const Expr *expr) {
+    Forgetter(locals, scope_sizes, declaration_slots, tail_calls)
+        .forget(expr);
+}
+
+void AbstractInterpreter::resolve_copy(const Expr *copy, const Expr *expr) {
+    if (auto it = locals.find(expr); it != locals.end()) {
+        resolve(copy, it->second.depth, it->second.slot);
+    }
+}
+
+void AbstractInterpreter::resolve_inlined(const Expr *copy,
+                                          const Expr *result,
+                                          const Expr *call) {
+    if (copy->kind == ExprKind::CALL and tail_calls.contains(result) and
+        tail_calls.contains(call)) {
+        resolve_tail_call(static_cast<const Expr::Call &>(*copy));
+    }
+}
+
+size_t AbstractInterpreter::scope_size(
+    const std::pmr::vector<Stmt *> &body) const {
+    auto it = scope_sizes.find(&body);
+    return it != scope_sizes.end() ? it->second : 0;
+}
+
+bool AbstractInterpreter::has_environment(
+    const std::pmr::vector<Stmt *> &block) const {
+    return scope_sizes.contains(&block);
+}
+
+size_t AbstractInterpreter::local_slot(const Token &name) const {
+    return declaration_slots.at(&name);
+}
+
+TemporaryRoots::TemporaryRoots(AbstractInterpreter &interpreter)
+    : temporaries(interpreter.temporaries), base(temporaries.size()) {}
+
+TemporaryRoots::~TemporaryRoots() { temporaries.resize(base); }
+
+LoxObject TemporaryRoots::add(const LoxObject &object) {
+    temporaries.push_back(object);
+    return object;
+}
+
+EnvironmentScope::EnvironmentScope(AbstractInterpreter &interpreter,
+                                   Environment *environment)
+    : interpreter(interpreter) {
+    interpreter.environment_stack.push_back(interpreter.curr_environment);
+    interpreter.curr_environment = environment;
+}
+
+EnvironmentScope::~EnvironmentScope() {
+    interpreter.curr_environment = interpreter.environment_stack.back();
+    interpreter.environment_stack.pop_back();
 }
@@ -1,30 +1,211 @@
 #pragma once
 
 #include "src/semantics/environment.h"
+#include "src/semantics/garbage_collector.h"
+#include "src/semantics/global_table.h"
 #include "src/syntactics/stmt.h"
 
-#include <memory>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Where the Resolver found a local variable: `depth` environments up from the
+// current one, at index `slot` of that environment.
+struct VariableLocation {
+    int depth;
+    size_t slot;
+};
+
+// How a statement finished. A return statement completes with RETURN, which
+// every enclosing statement passes on until the LoxFunction being called
+// picks up `return_value`.
+enum class Completion { NORMAL, RETURN };
+
+// A call in tail position to a LoxFunction, which the function making it
+// leaves to the LoxFunction::invoke() it was called through; see
+// LoxFunction::tail_call().
+struct TailCall {
+    LoxObject function;
+    // The receiver, if a method is called.
+    std::optional<LoxObject> this_object;
+    std::vector<LoxObject> arguments;
+};
+
+// The native functions every engine defines as globals, by name.
+using Natives = std::vector<std::pair<std::string, LoxObject>>;
 
 struct AbstractInterpreter {
-    AbstractInterpreter();
-    virtual ~AbstractInterpreter() = default;
+    // The Heap is shared by the whole process and a collection only marks
+    // the roots of the interpreter collecting, so only one interpreter may be
+    // alive at a time. Asserted here.
+    explicit AbstractInterpreter(const Natives &natives);
+    virtual ~AbstractInterpreter();
+
+    virtual Completion execute(const Stmt *stmt) = 0;
+
+    virtual Completion execute_block(const std::pmr::vector<Stmt *> &stmts,
+                                     Environment *environment);
 
-    virtual void execute(const Stmt *stmt) = 0;
-    virtual void execute(const std::shared_ptr<Stmt> &stmt);
+    // Adds an environment, first collecting garbage if enough was allocated
+    // since the last collection. Every value the caller still needs must be
+    // reachable from an environment or a TemporaryRoots.
+    Environment *add_environment(Environment *enclosing, size_t slot_count);
 
-    virtual void execute_block(const std::vector<std::shared_ptr<Stmt>> &stmts,
-                               Environment *environment);
+    // A safe point: collects if the heap grew past its threshold.
+    // `extra_root` is kept alive along with the interpreter's own roots.
+    void collect_garbage_if_needed(Environment *extra_root = nullptr);
 
+    // Drops what the Resolver recorded about the nodes of `stmts`, which must
+    // not run again, so that their memory can be freed and reused.
+    void forget(const std::pmr::vector<Stmt *> &stmts);
+    void forget(const Stmt *stmt);
+    void forget(const Expr *expr);
+    // Resolves `copy`, a copy of `expr` that is evaluated where `expr` is,
+    // as `expr` was.
+    void resolve_copy(const Expr *copy, const Expr *expr);
+    // Resolves `copy`, the copy of what a function returns that an inlined
+    // `call` to it is replaced by: a call in tail position there stays in
+    // tail position if `call` was in one.
+    void resolve_inlined(const Expr *copy, const Expr *result,
+                         const Expr *call);
+
+    void configure_gc(const GcSettings &settings);
+    const GcStats &gc_stats() const;
+
+    friend struct EnvironmentScope;
     friend struct LoxFunction;
     friend struct Resolver;
+    friend struct TemporaryRoots;
 
     EnvironmentTree environments;
 
   protected:
-    virtual void resolve(const Expr *, int depth);
+    virtual void resolve(const Expr *, int depth, size_t slot);
+    // Called for names the Resolver found in no local scope.
+    virtual void resolve_global(GlobalCache &cache, std::string_view name);
+    // Called for function bodies, and for the blocks that need an
+    // environment of their own. Other blocks run in the environment
+    // enclosing them.
+    virtual void resolve_scope(const std::pmr::vector<Stmt *> &body,
+                               size_t slot_count);
+    // Called for the names of local declarations.
+    virtual void resolve_declaration(const Token &name, size_t slot);
+    // Called for calls in tail position: the value of a return statement in
+    // a function that is not an initializer.
+    virtual void resolve_tail_call(const Expr::Call &call);
+    bool is_tail_call(const Expr *expr) const;
+
+    // The number of slots of the environment of a block or function body.
+    size_t scope_size(const std::pmr::vector<Stmt *> &body) const;
+    bool has_environment(const std::pmr::vector<Stmt *> &block) const;
+    // The slot of the current environment that the local declared by `name`
+    // is defined in.
+    size_t local_slot(const Token &name) const;
+
+    // Runs a CountedLoop whose counter, held by the local `counter`, and
+    // limit are numbers. `run_body` runs the body but its last statement,
+    // whose work is done here: the counter is counted in a double, and
+    // stored in the local for the body to read.
+    template <typename RunBody>
+    Completion count_loop(TokenType comparison, double step,
+                          LoxObject &counter, double limit, RunBody run_body);
+
+    // The safe point engines reach after every iteration of a loop, as loops
+    // whose body opens no environment would otherwise never reach a
+    // collection.
+    void end_iteration();
+    void collect_garbage(Environment *extra_root);
+    virtual void mark_roots(Tracer &tracer);
 
     Environment *globals();
+    // Kept alive even when the program rebinds their names, since every new
+    // interpreter defines them again.
+    const Natives &native_functions;
+    GlobalTable global_table;
     Environment *curr_environment;
-    std::unordered_map<const Expr *, int> locals;
-};
\ No newline at end of file
+    // The environments execute_block will return to.
+    std::vector<Environment *> environment_stack;
+    // Values only held by C++ locals; see TemporaryRoots.
+    std::vector<LoxObject> temporaries;
+    // The values of literals, made once by the engine when it first meets
+    // them.
+    std::vector<LoxObject> constants;
+    // The value of the return statement being completed.
+    LoxObject return_value;
+    std::unordered_map<const Expr *, VariableLocation> locals;
+    std::unordered_map<const std::pmr::vector<Stmt *> *, size_t> scope_sizes;
+    std::unordered_map<const Token *, size_t> declaration_slots;
+    std::unordered_set<const Expr *> tail_calls;
+    // The call in tail position the return being completed makes.
+    std::optional<TailCall> tail_call;
+
+  private:
+    size_t live_count() const;
+
+    static bool is_alive;
+
+    GcSettings gc_settings;
+    GcStats m_gc_stats;
+    size_t next_gc;
+};
+template <typename RunBody>
+Completion AbstractInterpreter::count_loop(TokenType comparison, double step,
+                                           LoxObject &counter, double limit,
+                                           RunBody run_body) {
+    auto count = [&](auto compare) {
+        for (double value = counter.get<double>(); compare(value, limit);) {
+            if (run_body() == Completion::RETURN) {
+                return Completion::RETURN;
+            }
+            value += step;
+            counter = value;
+            end_iteration();
+        }
+        return Completion::NORMAL;
+    };
+    switch (comparison) {
+    case LESS:
+        return count(std::less<double>());
+    case LESS_EQUAL:
+        return count(std::less_equal<double>());
+    case GREATER:
+        return count(std::greater<double>());
+    default:
+        return count(std::greater_equal<double>());
+    }
+}
+
+// Keeps values that are only held by C++ locals of the interpreter alive
+// across collections, until the end of the enclosing scope.
+struct TemporaryRoots {
+    explicit TemporaryRoots(AbstractInterpreter &interpreter);
+    ~TemporaryRoots();
+
+    TemporaryRoots(const TemporaryRoots &) = delete;
+    TemporaryRoots &operator=(const TemporaryRoots &) = delete;
+
+    LoxObject add(const LoxObject &object);
+
+  private:
+    std::vector<LoxObject> &temporaries;
+    size_t base;
+};
+
+// Makes `environment` the interpreter's current one until the end of the
+// enclosing scope, even when a RuntimeError unwinds it.
+struct EnvironmentScope {
+    EnvironmentScope(AbstractInterpreter &interpreter,
+                     Environment *environment);
+    ~EnvironmentScope();
+
+    EnvironmentScope(const EnvironmentScope &) = delete;
+    EnvironmentScope &operator=(const EnvironmentScope &) = delete;
+
+  private:
+    AbstractInterpreter &interpreter;
+};
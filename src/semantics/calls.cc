@@ -0,0 +1,66 @@
+#include "src/semantics/calls.h"
+
+#include "src/semantics/object/lox_callable.h"
+#include "src/semantics/object/lox_class.h"
+#include "src/semantics/object/lox_instance.h"
+#include "src/semantics/operators.h"
+#include "src/semantics/runtime_error.h"
+
+#include <string>
+#include <utility>
+
+LoxFunction *find_method(const Token &name, PropertyCache &cache,
+                         const LoxObject &this_object, LoxObject &field) {
+    auto instance = get_instance(name, this_object);
+    LoxFunction *method = instance->get_method(name, cache);
+    if (method == nullptr) {
+        field = instance->get(name, cache);
+    }
+    return method;
+}
+
+LoxFunction *find_super_method(Environment *environment, int depth,
+                               size_t slot, const Token &method,
+                               LoxObject &this_object) {
+    auto superclass = environment->get_at(depth, slot).get<LoxClass>();
+    // "this" is always slot 0 of the method frame nested in "super"'s scope.
+    this_object = environment->get_at(depth - 1, 0);
+
+    auto found = superclass->find_method(method.lexeme);
+    if (found == nullptr) {
+        throw RuntimeError(method, "Undefined property '" +
+                                      std::string(method.lexeme) + "'.");
+    }
+    return found;
+}
+
+LoxObject call_value(AbstractInterpreter &interpreter, const Token &paren,
+                     const LoxObject &callee, std::vector<LoxObject> arguments,
+                     bool in_tail_position) {
+    if (not callee.holds_alternative<LoxCallable *>()) {
+        throw RuntimeError(paren, "Can only call functions and classes.");
+    }
+    auto function = callee.get<LoxCallable *>();
+    check_arity(paren, function->arity(), arguments.size());
+    if (in_tail_position) {
+        if (auto lox_function = dynamic_cast<LoxFunction *>(function)) {
+            return lox_function->tail_call(interpreter, nullptr,
+                                           std::move(arguments));
+        }
+        if (auto bound_method = dynamic_cast<LoxBoundMethod *>(function)) {
+            return bound_method->tail_call(interpreter, std::move(arguments));
+        }
+    }
+    return function->call(interpreter, arguments);
+}
+
+LoxObject call_method(AbstractInterpreter &interpreter, const Token &paren,
+                      LoxFunction *method, const LoxObject &this_object,
+                      std::vector<LoxObject> arguments, bool in_tail_position) {
+    check_arity(paren, method->arity(), arguments.size());
+    if (in_tail_position) {
+        return method->tail_call(interpreter, &this_object,
+                                 std::move(arguments));
+    }
+    return method->call_method(interpreter, this_object, arguments);
+}
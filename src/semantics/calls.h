@@ -0,0 +1,37 @@
+#pragma once
+
+#include "src/semantics/abstract_interpreter.h"
+#include "src/semantics/environment.h"
+#include "src/semantics/object/lox_function.h"
+#include "src/semantics/object/lox_object.h"
+#include "src/syntactics/property_cache.h"
+#include "src/syntactics/token.h"
+
+#include <cstddef>
+#include <vector>
+
+// The calls of the tree-walking engines. A method called right away gets its
+// receiver in the call frame; bound methods are only materialised for
+// methods used as values. Every function throws a RuntimeError on a bad
+// callee or argument count.
+
+// The method `name` of the instance `this_object`. If it has none, returns
+// nullptr and sets `field` to its property `name` instead.
+LoxFunction *find_method(const Token &name, PropertyCache &cache,
+                         const LoxObject &this_object, LoxObject &field);
+// The method `method` of the superclass that "super" holds, at `slot` of the
+// environment `depth` up from `environment`. Also sets `this_object` to the
+// receiver of the method.
+LoxFunction *find_super_method(Environment *environment, int depth,
+                               size_t slot, const Token &method,
+                               LoxObject &this_object);
+
+// Calls `callee`, or from tail position leaves the call to the function
+// returning, see LoxFunction::tail_call().
+LoxObject call_value(AbstractInterpreter &interpreter, const Token &paren,
+                     const LoxObject &callee, std::vector<LoxObject> arguments,
+                     bool in_tail_position);
+// Like call_value(), for `method` called on `this_object`.
+LoxObject call_method(AbstractInterpreter &interpreter, const Token &paren,
+                      LoxFunction *method, const LoxObject &this_object,
+                      std::vector<LoxObject> arguments, bool in_tail_position);
@@ -0,0 +1,624 @@
+#include "src/semantics/closure_interpreter.h"
+
+#include "src/logging.h"
+#include "src/semantics/calls.h"
+#include "src/semantics/natives.h"
+#include "src/semantics/object/lox_class.h"
+#include "src/semantics/object/lox_function.h"
+#include "src/semantics/object/lox_instance.h"
+#include "src/semantics/object/print_lox_object.h"
+#include "src/semantics/operators.h"
+#include "src/semantics/runtime_error.h"
+
+#include <iostream>
+#include <utility>
+
+ClosureInterpreter::ClosureInterpreter()
+    : AbstractInterpreter(natives), compiled_expr(), compiled_stmt(),
+      at_top_level(true), bodies(), m_had_runtime_error(false) {}
+
+Completion ClosureInterpreter::execute(const Stmt *stmt) {
+    if (stmt == nullptr) {
+        return Completion::NORMAL;
+    }
+    dispatch(*stmt, *this);
+    return std::exchange(compiled_stmt, {})();
+}
+
+Completion ClosureInterpreter::execute_block(
+    const std::pmr::vector<Stmt *> &stmts, Environment *environment) {
+    auto it = bodies.find(&stmts);
+    return run(it != bodies.end() ? it->second : compile_body(stmts),
+               environment);
+}
+
+void ClosureInterpreter::interpret(
+    const std::pmr::vector<Stmt *> &stmts, InterpreterMode mode) {
+    if (stmts.empty()) {
+        return;
+    }
+
+    try {
+        at_top_level = true;
+        CompiledBlock program = compile(stmts);
+
+        auto expression = dynamic_cast<const Stmt::Expression *>(stmts.back());
+        if (mode == InterpreterMode::INTERACTIVE && expression != nullptr) {
+            program.back() = [this, value = compile(expression->expression)] {
+                std::cout << std::boolalpha << value() << std::endl;
+                return Completion::NORMAL;
+            };
+        }
+
+        for (const auto &stmt : program) {
+            stmt();
+        }
+    } catch (const RuntimeError &err) {
+        error(err.token.line, err.what());
+        m_had_runtime_error = true;
+        curr_environment = globals();
+    }
+}
+
+bool ClosureInterpreter::had_runtime_error() const {
+    return m_had_runtime_error;
+}
+
+void ClosureInterpreter::reset_runtime_error() { m_had_runtime_error = false; }
+
+ClosureInterpreter::CompiledExpr
+ClosureInterpreter::compile(const Expr *expr) {
+    dispatch(*expr, *this);
+    return std::exchange(compiled_expr, {});
+}
+
+ClosureInterpreter::CompiledStmt
+ClosureInterpreter::compile(const Stmt *stmt) {
+    if (stmt == nullptr) {
+        return [] { return Completion::NORMAL; };
+    }
+    dispatch(*stmt, *this);
+    return std::exchange(compiled_stmt, {});
+}
+
+ClosureInterpreter::CompiledBlock
+ClosureInterpreter::compile(const std::pmr::vector<Stmt *> &stmts) {
+    CompiledBlock block;
+    block.reserve(stmts.size());
+    for (const auto &stmt : stmts) {
+        block.push_back(compile(stmt));
+    }
+    return block;
+}
+
+const ClosureInterpreter::CompiledBlock &ClosureInterpreter::compile_body(
+    const std::pmr::vector<Stmt *> &body) {
+    bool enclosing_top_level = std::exchange(at_top_level, false);
+    CompiledBlock block = compile(body);
+    at_top_level = enclosing_top_level;
+    return bodies[&body] = std::move(block);
+}
+
+Completion ClosureInterpreter::run(std::span<const CompiledStmt> block,
+                                   Environment *environment) {
+    EnvironmentScope scope(*this, environment);
+    return run(block);
+}
+
+Completion ClosureInterpreter::run(std::span<const CompiledStmt> block) {
+    for (const auto &stmt : block) {
+        if (stmt() == Completion::RETURN) {
+            return Completion::RETURN;
+        }
+    }
+    return Completion::NORMAL;
+}
+
+void ClosureInterpreter::visit_assign_expr(const Expr::Assign &expr) {
+    CompiledExpr value = compile(expr.value);
+
+    if (auto it = locals.find(&expr); it != locals.end()) {
+        auto [depth, slot] = it->second;
+        compiled_expr = [this, value, depth, slot] {
+            LoxObject result = value();
+            curr_environment->assign_at(depth, slot, result);
+            return result;
+        };
+        return;
+    }
+
+    if (!expr.global.valid_for(global_table.id())) {
+        resolve_global(expr.global, expr.name.lexeme);
+    }
+    compiled_expr = [this, value, slot = expr.global.slot, name = expr.name] {
+        LoxObject result = value();
+        global_table.assign(slot, name, result);
+        return result;
+    };
+}
+
+template <typename NumberOp>
+ClosureInterpreter::CompiledExpr
+ClosureInterpreter::compile_arithmetic(CompiledExpr left, CompiledExpr right,
+                                       const Token &op, NumberOp number_op) {
+    return [this, left = std::move(left), right = std::move(right), op,
+            number_op]() -> LoxObject {
+        TemporaryRoots roots(*this);
+        LoxObject left_value = left();
+        if (not left_value.holds_alternative<double>()) {
+            roots.add(left_value);
+        }
+        LoxObject right_value = right();
+        if (left_value.holds_alternative<double>() and
+            right_value.holds_alternative<double>()) {
+            return number_op(left_value.get<double>(),
+                             right_value.get<double>());
+        }
+        return binary_op(op, left_value, right_value);
+    };
+}
+
+void ClosureInterpreter::visit_binary_expr(const Expr::Binary &expr) {
+    CompiledExpr left = compile(expr.left);
+    CompiledExpr right = compile(expr.right);
+    const Token &op = expr.op;
+
+    switch (op.type) {
+    case PLUS:
+        compiled_expr = compile_arithmetic(left, right, op, std::plus{});
+        break;
+    case MINUS:
+        compiled_expr = compile_arithmetic(left, right, op, std::minus{});
+        break;
+    case STAR:
+        compiled_expr = compile_arithmetic(left, right, op, std::multiplies{});
+        break;
+    case SLASH:
+        compiled_expr =
+            compile_arithmetic(left, right, op, [op](double a, double b) {
+                return number_op(op, a, b);
+            });
+        break;
+    case GREATER:
+        compiled_expr = compile_arithmetic(left, right, op, std::greater{});
+        break;
+    case GREATER_EQUAL:
+        compiled_expr =
+            compile_arithmetic(left, right, op, std::greater_equal{});
+        break;
+    case LESS:
+        compiled_expr = compile_arithmetic(left, right, op, std::less{});
+        break;
+    case LESS_EQUAL:
+        compiled_expr = compile_arithmetic(left, right, op, std::less_equal{});
+        break;
+    default:
+        compiled_expr = [this, left, right, op] {
+            TemporaryRoots roots(*this);
+            LoxObject left_value = roots.add(left());
+            return binary_op(op, left_value, right());
+        };
+        break;
+    }
+}
+
+void ClosureInterpreter::visit_call_expr(const Expr::Call &expr) {
+    compiled_expr = compile_call(expr, false);
+}
+
+ClosureInterpreter::CompiledExpr
+ClosureInterpreter::compile_call(const Expr::Call &expr,
+                                 bool in_tail_position) {
+    std::vector<CompiledExpr> arguments;
+    for (const auto &argument : expr.arguments) {
+        arguments.push_back(compile(argument));
+    }
+
+    switch (expr.callee->kind) {
+    case ExprKind::GET:
+        return compile_method_call(
+            static_cast<const Expr::Get &>(*expr.callee), std::move(arguments),
+            expr.paren, in_tail_position);
+    case ExprKind::SUPER:
+        return compile_super_call(
+            static_cast<const Expr::Super &>(*expr.callee),
+            std::move(arguments), expr.paren, in_tail_position);
+    default:
+        break;
+    }
+
+    return [this, callee = compile(expr.callee),
+            arguments = std::move(arguments), paren = expr.paren,
+            in_tail_position] {
+        TemporaryRoots roots(*this);
+        LoxObject function = roots.add(callee());
+        return call_value(*this, paren, function,
+                          evaluate_arguments(arguments, roots),
+                          in_tail_position);
+    };
+}
+
+ClosureInterpreter::CompiledExpr ClosureInterpreter::compile_method_call(
+    const Expr::Get &callee, std::vector<CompiledExpr> arguments,
+    const Token &paren, bool in_tail_position) {
+    return [this, object = compile(callee.object), &callee,
+            arguments = std::move(arguments), paren, in_tail_position] {
+        TemporaryRoots roots(*this);
+        LoxObject this_object = roots.add(object());
+        LoxObject function;
+        LoxFunction *method =
+            find_method(callee.name, callee.cache, this_object, function);
+        if (method == nullptr) {
+            roots.add(function);
+            return call_value(*this, paren, function,
+                              evaluate_arguments(arguments, roots),
+                              in_tail_position);
+        }
+        return call_method(*this, paren, method, this_object,
+                           evaluate_arguments(arguments, roots),
+                           in_tail_position);
+    };
+}
+
+ClosureInterpreter::CompiledExpr ClosureInterpreter::compile_super_call(
+    const Expr::Super &callee, std::vector<CompiledExpr> arguments,
+    const Token &paren, bool in_tail_position) {
+    auto [depth, slot] = locals.at(&callee);
+    return [this, depth, slot, method_name = callee.method,
+            arguments = std::move(arguments), paren, in_tail_position] {
+        TemporaryRoots roots(*this);
+        LoxObject this_object;
+        LoxFunction *method = find_super_method(curr_environment, depth, slot,
+                                               method_name, this_object);
+        return call_method(*this, paren, method, this_object,
+                           evaluate_arguments(arguments, roots),
+                           in_tail_position);
+    };
+}
+
+std::vector<LoxObject> ClosureInterpreter::evaluate_arguments(
+    const std::vector<CompiledExpr> &arguments, TemporaryRoots &roots) {
+    std::vector<LoxObject> values;
+    values.reserve(arguments.size());
+    for (const auto &argument : arguments) {
+        values.push_back(roots.add(argument()));
+    }
+    return values;
+}
+
+void ClosureInterpreter::visit_get_expr(const Expr::Get &expr) {
+    compiled_expr = [object = compile(expr.object), &expr] {
+        return get_instance(expr.name, object())->get(expr.name, expr.cache);
+    };
+}
+
+void ClosureInterpreter::visit_grouping_expr(const Expr::Grouping &expr) {
+    compiled_expr = compile(expr.expression);
+}
+
+void ClosureInterpreter::visit_lambda_expr(const Expr::Lambda &expr) {
+    if (!expr.body.empty()) {
+        compile_body(expr.body);
+    }
+    compiled_expr = [this, &expr, slot_count = scope_size(expr.body)] {
+        return LoxObject(Heap::instance().allocate<LoxFunction>(
+            expr, curr_environment, slot_count));
+    };
+}
+
+void ClosureInterpreter::visit_literal_expr(const Expr::Literal &expr) {
+    LoxObject value;
+    switch (expr.value.type) {
+    case NIL:
+        break;
+    case TRUE:
+        value = true;
+        break;
+    case FALSE:
+        value = false;
+        break;
+    default:
+        if (expr.value.literal.has_value()) {
+            value = LoxObject(expr.value.literal.value());
+        }
+        break;
+    }
+    if (value.holds_alternative<std::string>()) {
+        constants.push_back(value);
+    }
+    compiled_expr = [value] { return value; };
+}
+
+void ClosureInterpreter::visit_logical_expr(const Expr::Logical &expr) {
+    CompiledExpr left = compile(expr.left);
+    CompiledExpr right = compile(expr.right);
+    if (expr.op.type == OR) {
+        compiled_expr = [left, right] {
+            LoxObject value = left();
+            return static_cast<bool>(value) ? value : right();
+        };
+    } else {
+        compiled_expr = [left, right] {
+            LoxObject value = left();
+            return !static_cast<bool>(value) ? value : right();
+        };
+    }
+}
+
+void ClosureInterpreter::visit_set_expr(const Expr::Set &expr) {
+    compiled_expr = [this, object = compile(expr.object),
+                     value = compile(expr.value), &expr] {
+        TemporaryRoots roots(*this);
+        LoxObject instance = roots.add(object());
+        if (!instance.holds_alternative<LoxInstance *>()) {
+            throw RuntimeError(expr.name, "Only instances have fields.");
+        }
+
+        LoxObject result = value();
+        instance.get<LoxInstance *>()->set(expr.name, result, expr.cache);
+        return result;
+    };
+}
+
+void ClosureInterpreter::visit_super_expr(const Expr::Super &expr) {
+    auto [depth, slot] = locals.at(&expr);
+    compiled_expr = [this, depth, slot, method_name = expr.method] {
+        LoxObject this_object;
+        LoxFunction *method = find_super_method(curr_environment, depth, slot,
+                                               method_name, this_object);
+        return LoxObject(method->bind(this_object));
+    };
+}
+
+void ClosureInterpreter::visit_this_expr(const Expr::This &expr) {
+    auto [depth, slot] = locals.at(&expr);
+    compiled_expr = compile_local(depth, slot);
+}
+
+void ClosureInterpreter::visit_unary_expr(const Expr::Unary &expr) {
+    CompiledExpr right = compile(expr.right);
+    if (expr.op.type == MINUS) {
+        compiled_expr = [right, op = expr.op] {
+            LoxObject value = right();
+            if (value.holds_alternative<double>()) {
+                return LoxObject(-value.get<double>());
+            }
+            return unary_op(op, value);
+        };
+    } else {
+        compiled_expr = [right, op = expr.op] {
+            return unary_op(op, right());
+        };
+    }
+}
+
+void ClosureInterpreter::visit_variable_expr(const Expr::Variable &expr) {
+    if (auto it = locals.find(&expr); it != locals.end()) {
+        auto [depth, slot] = it->second;
+        compiled_expr = compile_local(depth, slot);
+        return;
+    }
+
+    if (!expr.global.valid_for(global_table.id())) {
+        resolve_global(expr.global, expr.name.lexeme);
+    }
+    compiled_expr = [this, slot = expr.global.slot, name = expr.name] {
+        return global_table.get(slot, name);
+    };
+}
+
+ClosureInterpreter::CompiledExpr ClosureInterpreter::compile_local(int depth,
+                                                                   size_t slot) {
+    if (depth == 0) {
+        return [this, slot] { return curr_environment->get_at(0, slot); };
+    }
+    return [this, depth, slot] {
+        return curr_environment->get_at(depth, slot);
+    };
+}
+
+void ClosureInterpreter::visit_block_stmt(const Stmt::Block &stmt) {
+    bool enclosing_top_level = std::exchange(at_top_level, false);
+    CompiledBlock block = compile(stmt.statements);
+    at_top_level = enclosing_top_level;
+
+    if (!has_environment(stmt.statements)) {
+        compiled_stmt = [this, block = std::move(block)] { return run(block); };
+        return;
+    }
+    compiled_stmt = [this, block = std::move(block),
+                     slot_count = scope_size(stmt.statements)] {
+        return run(block, add_environment(curr_environment, slot_count));
+    };
+}
+
+void ClosureInterpreter::visit_class_stmt(const Stmt::Class &stmt) {
+    std::optional<CompiledExpr> superclass_expr;
+    if (stmt.superclass != nullptr) {
+        superclass_expr = compile(stmt.superclass);
+    }
+    for (const auto &method : stmt.methods) {
+        if (!method->body.empty()) {
+            compile_body(method->body);
+        }
+    }
+
+    compiled_stmt = [this, &stmt, superclass_expr,
+                     slot = declaration_slot(stmt.name)] {
+        LoxClass *superclass = nullptr;
+        if (superclass_expr.has_value()) {
+            LoxObject superclass_obj = (*superclass_expr)();
+            if (!superclass_obj.holds_alternative<LoxClass>()) {
+                throw RuntimeError(stmt.superclass->name,
+                                   "Superclass must be a class.");
+            }
+            superclass = superclass_obj.get<LoxClass>();
+
+            curr_environment = add_environment(curr_environment, 1);
+            curr_environment->define(superclass);
+        }
+
+        LoxClass::MethodMap methods;
+        for (const auto &method : stmt.methods) {
+            std::string_view method_name = method->name.lexeme;
+            methods[std::string(method_name)] =
+                Heap::instance().allocate<LoxFunction>(
+                    *method, curr_environment, scope_size(method->body),
+                    method_name == "init");
+        }
+
+        LoxCallable *lox_class = Heap::instance().allocate<LoxClass>(
+            stmt.name.lexeme, superclass, std::move(methods));
+
+        if (superclass != nullptr) {
+            curr_environment = curr_environment->enclosing;
+        }
+
+        define(slot, lox_class);
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureInterpreter::visit_expression_stmt(const Stmt::Expression &stmt) {
+    compiled_stmt = [expression = compile(stmt.expression)] {
+        expression();
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureInterpreter::visit_if_stmt(const Stmt::If &stmt) {
+    compiled_stmt = [condition = compile(stmt.condition),
+                     then_branch = compile(stmt.then_branch),
+                     else_branch = compile(stmt.else_branch)] {
+        return static_cast<bool>(condition()) ? then_branch() : else_branch();
+    };
+}
+
+void ClosureInterpreter::visit_function_stmt(const Stmt::Function &stmt) {
+    if (!stmt.body.empty()) {
+        compile_body(stmt.body);
+    }
+    compiled_stmt = [this, &stmt, slot_count = scope_size(stmt.body),
+                     slot = declaration_slot(stmt.name)] {
+        define(slot, Heap::instance().allocate<LoxFunction>(
+                         stmt, curr_environment, slot_count));
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureInterpreter::visit_print_stmt(const Stmt::Print &stmt) {
+    compiled_stmt = [expression = compile(stmt.expression)] {
+        std::cout << std::boolalpha << expression() << std::endl;
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureInterpreter::visit_return_stmt(const Stmt::Return &stmt) {
+    if (stmt.value == nullptr) {
+        compiled_stmt = [this] {
+            return_value = LoxObject{};
+            return Completion::RETURN;
+        };
+        return;
+    }
+    CompiledExpr value =
+        is_tail_call(stmt.value)
+            ? compile_call(static_cast<const Expr::Call &>(*stmt.value), true)
+            : compile(stmt.value);
+    compiled_stmt = [this, value = std::move(value)] {
+        return_value = value();
+        return Completion::RETURN;
+    };
+}
+
+void ClosureInterpreter::visit_var_stmt(const Stmt::Var &stmt) {
+    std::optional<CompiledExpr> initializer;
+    if (stmt.initializer != nullptr) {
+        initializer = compile(stmt.initializer);
+    }
+    compiled_stmt = [this, initializer, slot = declaration_slot(stmt.name)] {
+        define(slot, initializer.has_value() ? (*initializer)()
+                                             : LoxObject(LoxNull{}));
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureInterpreter::visit_while_stmt(const Stmt::While &stmt) {
+    if (stmt.counted.has_value()) {
+        compiled_stmt = compile_counted_loop(stmt);
+        return;
+    }
+    compiled_stmt = [this, condition = compile(stmt.condition),
+                     body = compile(stmt.body)] {
+        while (static_cast<bool>(condition())) {
+            if (body() == Completion::RETURN) {
+                return Completion::RETURN;
+            }
+            end_iteration();
+        }
+        return Completion::NORMAL;
+    };
+}
+
+// Runs the loop as visit_while_stmt() would when its counter or limit is not
+// a number.
+ClosureInterpreter::CompiledStmt
+ClosureInterpreter::compile_counted_loop(const Stmt::While &stmt) {
+    const CountedLoop &loop = *stmt.counted;
+    const auto &body = static_cast<const Stmt::Block &>(*stmt.body).statements;
+    bool enclosing_top_level = std::exchange(at_top_level, false);
+    CompiledBlock block = compile(body);
+    at_top_level = enclosing_top_level;
+    auto [depth, slot] = locals.at(loop.counter);
+
+    return [this, condition = compile(stmt.condition),
+            limit = compile(loop.limit), block = std::move(block),
+            has_environment = has_environment(body),
+            slot_count = scope_size(body), depth, slot,
+            comparison = loop.comparison, step = loop.step] {
+        // Runs `statements` of the body in an environment of its own, if it
+        // needs one.
+        auto run_body = [&](std::span<const CompiledStmt> statements) {
+            if (!has_environment) {
+                return run(statements);
+            }
+            return run(statements,
+                       add_environment(curr_environment, slot_count));
+        };
+
+        LoxObject &counter = curr_environment->get_at(depth, slot);
+        LoxObject limit_value = limit();
+        if (counter.holds_alternative<double>() and
+            limit_value.holds_alternative<double>()) {
+            std::span<const CompiledStmt> statements(block.data(),
+                                                     block.size() - 1);
+            return count_loop(comparison, step, counter,
+                              limit_value.get<double>(),
+                              [&] { return run_body(statements); });
+        }
+
+        while (static_cast<bool>(condition())) {
+            if (run_body(block) == Completion::RETURN) {
+                return Completion::RETURN;
+            }
+            end_iteration();
+        }
+        return Completion::NORMAL;
+    };
+}
+
+ClosureInterpreter::DeclarationSlot
+ClosureInterpreter::declaration_slot(const Token &name) {
+    if (!at_top_level) {
+        return {false, local_slot(name)};
+    }
+    return {true, global_table.slot(name.lexeme)};
+}
+
+void ClosureInterpreter::define(DeclarationSlot slot, const LoxObject &value) {
+    if (slot.global) {
+        global_table.define(slot.slot, value);
+    } else {
+        curr_environment->assign_at(0, slot.slot, value);
+    }
+}
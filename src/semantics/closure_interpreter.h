@@ -0,0 +1,121 @@
+#pragma once
+
+#include "src/semantics/abstract_interpreter.h"
+#include "src/semantics/interpreter_mode.h"
+#include "src/semantics/object/lox_object.h"
+#include "src/syntactics/expr.h"
+#include "src/syntactics/stmt.h"
+
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Runs a resolved program by first compiling every node, once, into a
+// closure that evaluates it and returns its value. Resolved slots, literal
+// values and operators are baked into the closures, so running them involves
+// neither visitor dispatch nor a shared result register. Shares its runtime
+// (environments, objects, the collector) with the tree-walking Interpreter.
+struct ClosureInterpreter final : AbstractInterpreter,
+                                  ExprVisitor,
+                                  StmtVisitor {
+    ClosureInterpreter();
+
+    // Compiles `stmt` and runs it.
+    Completion execute(const Stmt *stmt) override;
+    // Function calls come through here: runs the compiled body.
+    Completion execute_block(const std::pmr::vector<Stmt *> &stmts,
+                             Environment *environment) override;
+
+    void interpret(const std::pmr::vector<Stmt *> &stmts,
+                   InterpreterMode mode = InterpreterMode::FILE);
+
+    bool had_runtime_error() const;
+    void reset_runtime_error();
+
+  private:
+    using CompiledExpr = std::function<LoxObject()>;
+    using CompiledStmt = std::function<Completion()>;
+    using CompiledBlock = std::vector<CompiledStmt>;
+
+    CompiledExpr compile(const Expr *expr);
+    CompiledStmt compile(const Stmt *stmt);
+    CompiledBlock compile(const std::pmr::vector<Stmt *> &stmts);
+    const CompiledBlock &compile_body(const std::pmr::vector<Stmt *> &body);
+
+    Completion run(std::span<const CompiledStmt> block,
+                   Environment *environment);
+    // Runs `block` in the current environment.
+    Completion run(std::span<const CompiledStmt> block);
+
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
+    void visit_assign_expr(const Expr::Assign &expr) override;
+    void visit_binary_expr(const Expr::Binary &expr) override;
+    void visit_call_expr(const Expr::Call &expr) override;
+    void visit_get_expr(const Expr::Get &expr) override;
+    void visit_grouping_expr(const Expr::Grouping &expr) override;
+    void visit_lambda_expr(const Expr::Lambda &expr) override;
+    void visit_literal_expr(const Expr::Literal &expr) override;
+    void visit_logical_expr(const Expr::Logical &expr) override;
+    void visit_set_expr(const Expr::Set &expr) override;
+    void visit_super_expr(const Expr::Super &expr) override;
+    void visit_this_expr(const Expr::This &expr) override;
+    void visit_unary_expr(const Expr::Unary &expr) override;
+    void visit_variable_expr(const Expr::Variable &expr) override;
+
+    void visit_block_stmt(const Stmt::Block &stmt) override;
+    void visit_class_stmt(const Stmt::Class &stmt) override;
+    void visit_expression_stmt(const Stmt::Expression &stmt) override;
+    void visit_if_stmt(const Stmt::If &stmt) override;
+    void visit_function_stmt(const Stmt::Function &stmt) override;
+    void visit_print_stmt(const Stmt::Print &stmt) override;
+    void visit_return_stmt(const Stmt::Return &stmt) override;
+    void visit_var_stmt(const Stmt::Var &stmt) override;
+    void visit_while_stmt(const Stmt::While &stmt) override;
+
+    // A binary operator whose operands are usually numbers; other operands
+    // go through binary_op.
+    template <typename NumberOp>
+    CompiledExpr compile_arithmetic(CompiledExpr left, CompiledExpr right,
+                                    const Token &op, NumberOp number_op);
+    CompiledExpr compile_local(int depth, size_t slot);
+    // For a while loop the Optimizer found to count.
+    CompiledStmt compile_counted_loop(const Stmt::While &stmt);
+    // Calls from tail position are left to the function returning, see
+    // LoxFunction::tail_call().
+    CompiledExpr compile_call(const Expr::Call &expr, bool in_tail_position);
+    CompiledExpr compile_method_call(const Expr::Get &callee,
+                                     std::vector<CompiledExpr> arguments,
+                                     const Token &paren,
+                                     bool in_tail_position);
+    CompiledExpr compile_super_call(const Expr::Super &callee,
+                                    std::vector<CompiledExpr> arguments,
+                                    const Token &paren, bool in_tail_position);
+
+    std::vector<LoxObject>
+    evaluate_arguments(const std::vector<CompiledExpr> &arguments,
+                       TemporaryRoots &roots);
+
+    // Where a declaration at the current point of compilation stores its
+    // variable: a global slot at the top level, a slot of the current
+    // environment otherwise.
+    struct DeclarationSlot {
+        bool global;
+        size_t slot;
+    };
+    DeclarationSlot declaration_slot(const Token &name);
+    void define(DeclarationSlot slot, const LoxObject &value);
+
+    CompiledExpr compiled_expr;
+    CompiledStmt compiled_stmt;
+    // Whether the statements being compiled run in the global environment.
+    bool at_top_level;
+    std::unordered_map<const std::pmr::vector<Stmt *> *, CompiledBlock> bodies;
+    bool m_had_runtime_error;
+};
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/closure_interpreter.h"
+#include "src/semantics/flat_interpreter.h"
+#include "src/semantics/resolver.h"
+#include "src/semantics/testing.h"
+
+#include <concepts>
+#include <string>
+#include <vector>
+
+// The engines that run the resolved program other than by walking its tree,
+// each expected to run it as the Interpreter does.
+template <typename Engine>
+struct EngineTest : testing::Test {};
+
+struct EngineNames {
+    template <typename Engine>
+    static std::string GetName(int) {
+        if constexpr (std::same_as<Engine, ClosureInterpreter>) {
+            return "Closure";
+        } else {
+            return "Flat";
+        }
+    }
+};
+
+using Engines = testing::Types<ClosureInterpreter, FlatInterpreter>;
+TYPED_TEST_SUITE(EngineTest, Engines, EngineNames);
+
+// Collects at every safe point.
+constexpr GcSettings COLLECT_ALWAYS{.initial_threshold = 1,
+                                    .growth_factor = 1};
+
+TYPED_TEST(EngineTest, Expressions) {
+    EXPECT_EQ(run<TypeParam>("print 1 + 2 * 3;").output, "7\n");
+    expect_same_output<TypeParam>(
+        "print 1 / 3; print -(2 - 5); print 2 >= 2;");
+    expect_same_output<TypeParam>("print \"a\" + \"b\"; print \"a\" == \"a\";");
+    expect_same_output<TypeParam>(
+        "print nil == false; print !nil; print 1 != 2;");
+    expect_same_output<TypeParam>(
+        "print 0 or \"x\"; print 1 and 2; print nil and 1;");
+}
+
+TYPED_TEST(EngineTest, Variables) {
+    expect_same_output<TypeParam>(
+        "var a = 1; { var a = 2; { var a = 3; print a; } print a; } print a;");
+    expect_same_output<TypeParam>(
+        "var a; print a; a = 2; print a = 3; print a;");
+    expect_same_output<TypeParam>(R"(
+        fun get() { return later; }
+        var later = "defined after use";
+        print get();
+    )");
+}
+
+TYPED_TEST(EngineTest, ControlFlow) {
+    expect_same_output<TypeParam>(R"(
+        for (var i = 0; i < 3; i = i + 1) { if (i == 1) print "one"; else print i; }
+        var n = 0;
+        while (n < 5) n = n + 2;
+        print n;
+    )");
+}
+
+TYPED_TEST(EngineTest, Functions) {
+    expect_same_output<TypeParam>(R"(
+        fun counter() {
+            var n = 0;
+            return fun() { n = n + 1; return n; };
+        }
+        var a = counter();
+        a(); a();
+        print a(); print counter()(); print a; print clock;
+        fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }
+        print fib(15);
+        fun find(n) {
+            for (var i = 0; i < 10; i = i + 1) { { if (i == n) return i; } }
+        }
+        print find(3); print find(20);
+        fun empty() {}
+        print empty();
+    )");
+}
+
+TYPED_TEST(EngineTest, Classes) {
+    expect_same_output<TypeParam>(R"(
+        class A {
+            init(x) { this.x = x; }
+            get() { return this.x; }
+            adder() { return fun(y) { return this.x + y; }; }
+        }
+        class B < A {
+            init(x) { super.init(x); return; }
+            get() { return super.get() * 2; }
+        }
+        var b = B(21);
+        print b.get(); print b.init(3).x; print b; print B; print b.get;
+        var bound = b.get; print bound();
+        var super_bound = b.adder(); print super_bound(1);
+        b.f = fun() { return "field"; }; print b.f();
+    )");
+}
+
+TYPED_TEST(EngineTest, RuntimeErrors) {
+    expect_same_output<TypeParam>("print 1 + \"a\";");
+    expect_same_output<TypeParam>("print -\"x\";");
+    expect_same_output<TypeParam>("print 1 / 0;");
+    expect_same_output<TypeParam>("print 1 < nil;");
+    expect_same_output<TypeParam>("var a; a();");
+    expect_same_output<TypeParam>("fun f(a) {} f();");
+    expect_same_output<TypeParam>("print x;");
+    expect_same_output<TypeParam>("x = 1;");
+    expect_same_output<TypeParam>("var o = 1; print o.x;");
+    expect_same_output<TypeParam>("var o = 1; o.x = 2;");
+    expect_same_output<TypeParam>("class A {} A().m();");
+    expect_same_output<TypeParam>("class A { m(a) {} } A().m();");
+    expect_same_output<TypeParam>("var N = 1; class A < N {}");
+}
+
+TYPED_TEST(EngineTest, TailCalls) {
+    expect_same_output<TypeParam>(R"(
+        fun id(x) { return x; }
+        fun make(n) { var get = fun () { return n; }; return id(get); }
+        print make(5)();
+        class A {
+            init(x) { this.x = x; }
+            get() { return this.x; }
+            copy() { return A(this.get()); }
+        }
+        class B < A { get() { return super.get(); } }
+        print B(2).copy().get();
+        fun fail(n) { if (n == 0) return nil + 1; return fail(n - 1); }
+        fail(3);
+    )");
+    // Far deeper than the native stack has room for if every call kept the
+    // frame of its caller.
+    RunResult deep = run<TypeParam>(R"(
+        fun even(n) { if (n == 0) return true; return odd(n - 1); }
+        fun odd(n) { if (n == 0) return false; return even(n - 1); }
+        print even(300001);
+        class Bound {
+            go(n) {
+                if (n == 0) return "bound";
+                var next = this.go;
+                return next(n - 1);
+            }
+        }
+        print Bound().go(300000);
+    )");
+    EXPECT_EQ(deep.output, "false\nbound\n");
+    // Keeps what the pending call needs while the callers return.
+    RunResult collected = run<TypeParam>(R"(
+        class Node { init(next) { this.next = next; } }
+        fun build(n, head) {
+            if (n == 0) return head;
+            return build(n - 1, Node(head));
+        }
+        fun length(node, n) {
+            if (node == nil) return n;
+            return length(node.next, n + 1);
+        }
+        print length(build(3000, nil), 0);
+    )",
+                                         std::nullopt, COLLECT_ALWAYS);
+    EXPECT_EQ(collected.output, "3000\n");
+}
+
+TYPED_TEST(EngineTest, CountedLoops) {
+    const std::string source = R"(
+        fun sum_to(n) {
+            var total = 0;
+            for (var i = 0; i < n; i = i + 1) total = total + i;
+            return total;
+        }
+        print sum_to(100);
+        for (var i = 10; i >= 0; i = i - 2.5) print i;
+        var limit = 3;
+        var last;
+        for (var i = 0; i < limit; i = i + 1) {
+            fun get() { return i; }
+            last = get;
+        }
+        print last();
+        fun first_over(n) {
+            for (var i = 0.5; i <= n * 2; i = 1 + i) if (i > n) return i;
+        }
+        print first_over(4);
+    )";
+    expect_same_output<TypeParam>(source, true);
+    expect_same_output<TypeParam>(
+        "for (var i = \"a\"; i < 3; i = i + 1) print i;", true);
+    expect_same_output<TypeParam>(
+        "var n; for (var i = 0; i < n; i = i + 1) print i;", true);
+}
+
+TYPED_TEST(EngineTest, BlockScopes) {
+    const std::string source = R"(
+        fun f(flag) {
+            var a = 1;
+            if (false) { var b = 2; print b; }
+            { var a = 2; { var a = 3; print a; } print a; }
+            if (flag) { var c = "c"; print c; } else { var d = "d"; print d; }
+            var e = "e";
+            print a;
+            var i = 0;
+            while (i < 3) {
+                var square = i * i;
+                { var cube = square * i; print cube; }
+                i = i + 1;
+            }
+            var get;
+            for (var k = 0; k < 3; k = k + 1) {
+                var captured = k * 10;
+                fun f() { return captured; }
+                if (k == 1) get = f;
+            }
+            print get();
+            return e;
+        }
+        print f(true);
+        print f(false);
+        {
+            print "no locals";
+            { var x = 1; { print x; } { var y = x + 1; print y; } }
+        }
+    )";
+    expect_same_output<TypeParam>(source);
+    expect_same_output<TypeParam>(source, true);
+}
+
+TYPED_TEST(EngineTest, SurvivesCollectionAtEveryEnvironment) {
+    RunResult result = run<TypeParam>(R"(
+        class Node { init(next) { this.next = next; this.name = "n"; } }
+        fun chain(n) {
+            var head = nil;
+            for (var i = 0; i < n; i = i + 1) { head = Node(head); }
+            return head;
+        }
+        var length = 0;
+        for (var node = chain(50); node != nil; node = node.next) {
+            length = length + 1;
+        }
+        print length;
+        print chain(3).next.name + "!";
+    )",
+                                      std::nullopt, COLLECT_ALWAYS);
+    EXPECT_EQ(result.output, "50\nn!\n");
+}
+
+TYPED_TEST(EngineTest, LaterProgramsSeeEarlierDeclarations) {
+    CapturedOutput output;
+
+    // Each program is compiled after the ones before it, as in the REPL.
+    TypeParam engine;
+    std::vector<Program> programs;
+    for (std::string source :
+         {"fun add(a, b) { return a + b; } var x = 1;",
+          "class A { get() { return add(x, 2); } }", "A().get();"}) {
+        const auto &stmts = programs.emplace_back(parse(source)).statements;
+        Resolver{engine}.resolve(stmts);
+        engine.interpret(stmts, InterpreterMode::INTERACTIVE);
+    }
+
+    EXPECT_EQ(output.str(), "3\n");
+}
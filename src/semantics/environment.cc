@@ -1,52 +1,33 @@
 #include "environment.h"
 #include "src/semantics/environment.h"
-#include "src/semantics/runtime_error.h"
 
-Environment::Environment(Environment *enclosing)
-    : enclosing(enclosing), values() {}
+Environment::Environment(Environment *enclosing, size_t slot_count)
+    : enclosing(enclosing), is_marked(false), slots(slot_count),
+      defined_slots(0) {}
 
-Environment::Environment() : enclosing(nullptr), values() {}
+Environment::Environment()
+    : enclosing(nullptr), is_marked(false), slots(), defined_slots(0) {}
 
-void Environment::define(const VarName &name, const LoxObject &value) {
-    values[name] = value;
+LoxObject &Environment::define(const LoxObject &value) {
+    LoxObject &slot = slots[defined_slots++];
+    slot = value;
+    return slot;
 }
 
-void Environment::assign(const Token &name, const LoxObject &value) {
-    if (values.contains(name.lexeme)) {
-        values[name.lexeme] = value;
-        return;
-    }
-
-    if (enclosing) {
-        enclosing->assign(name, value);
-        return;
-    }
-
-    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
-}
-
-LoxObject &Environment::get(const Token &name) {
-    if (values.contains(name.lexeme)) {
-        return values.at(name.lexeme);
-    }
-
-    if (enclosing != nullptr) {
-        return enclosing->get(name);
-    }
-    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
-}
-
-void Environment::assign_at(const Token &name, const LoxObject &value,
-                            int distance) {
-    ancestor(distance)->assign(name, value);
+void Environment::assign_at(int distance, size_t slot,
+                            const LoxObject &value) {
+    ancestor(distance)->slots[slot] = value;
 }
 
-LoxObject &Environment::get_at(const Token &name, int distance) {
-    return ancestor(distance)->get(name);
+LoxObject &Environment::get_at(int distance, size_t slot) {
+    return ancestor(distance)->slots[slot];
 }
 
-LoxObject &Environment::get_at(const std::string &name, int distance) {
-    return ancestor(distance)->values.at(name);
+void Environment::trace(Tracer &tracer) const {
+    tracer.mark_environment(enclosing);
+    for (const auto &value : slots) {
+        tracer.mark_value(value);
+    }
 }
 
 Environment *Environment::ancestor(int distance) {
@@ -64,7 +45,22 @@ EnvironmentTree::EnvironmentTree() : environments(), m_globals(nullptr) {
 
 Environment &EnvironmentTree::globals() { return *m_globals; }
 
-Environment *EnvironmentTree::add_environment(Environment *enclosing) {
-    return environments.emplace_back(std::make_unique<Environment>(enclosing))
+Environment *EnvironmentTree::add_environment(Environment *enclosing,
+                                              size_t slot_count) {
+    return environments
+        .emplace_back(std::make_unique<Environment>(enclosing, slot_count))
         .get();
 }
+
+size_t EnvironmentTree::size() const { return environments.size(); }
+
+size_t EnvironmentTree::sweep() {
+    m_globals->is_marked = true;
+    size_t freed = std::erase_if(environments, [](const auto &environment) {
+        return !environment->is_marked;
+    });
+    for (const auto &environment : environments) {
+        environment->is_marked = false;
+    }
+    return freed;
+}
@@ -4,40 +4,54 @@
 
 #include <memory>
 #include <optional>
-#include <string>
-#include <unordered_map>
+#include <vector>
 
+// A fixed-size array of slots whose indices were assigned by the Resolver.
+// Global variables live in the interpreter's GlobalTable instead; the global
+// environment is only the root every other environment encloses.
 struct Environment {
-    using VarName = std::string;
-
     Environment();
-    explicit Environment(Environment *enclosing);
-
-    void define(const VarName &name, const LoxObject &value);
-    void assign(const Token &name, const LoxObject &value);
+    explicit Environment(Environment *enclosing, size_t slot_count = 0);
 
-    LoxObject &get(const Token &name);
+    // Defines the next slot of this environment, for what takes the first
+    // slots: the receiver and parameters of a call, or `super`. Declarations
+    // assign to the slot the Resolver gave them instead.
+    LoxObject &define(const LoxObject &value);
 
     Environment *enclosing;
 
-    LoxObject &get_at(const Token &name, int distance);
-    LoxObject &get_at(const std::string &name, int distance);
-    void assign_at(const Token &name, const LoxObject &value, int distance);
+    LoxObject &get_at(int distance, size_t slot);
+    void assign_at(int distance, size_t slot, const LoxObject &value);
+
+    // Reports the enclosing environment and every value stored here.
+    void trace(Tracer &tracer) const;
+
+    bool is_marked;
 
   private:
     Environment *ancestor(int distance);
 
-    std::unordered_map<VarName, LoxObject> values;
+    std::vector<LoxObject> slots;
+    size_t defined_slots;
 };
 
+// Owns every environment. Environments are freed by sweep() once a
+// collection found them unreachable.
 struct EnvironmentTree {
     EnvironmentTree();
 
-    Environment *add_environment(Environment *enclosing);
+    Environment *add_environment(Environment *enclosing,
+                                 size_t slot_count = 0);
 
     Environment &globals();
 
+    size_t size() const;
+
+    // Frees every unmarked environment (but the globals) and unmarks the
+    // survivors. Returns the number of environments freed.
+    size_t sweep();
+
   private:
     std::vector<std::unique_ptr<Environment>> environments;
     Environment *m_globals;
-};
\ No newline at end of file
+};
@@ -46,4 +46,23 @@ TEST(EnvironmentTreeTest, AddEnvironmentGlobals) {
     Environment &new_env = *env_tree.add_environment(&globals);
     EXPECT_EQ(new_env.enclosing, &globals);
     EXPECT_EQ(globals.enclosing, nullptr);
-}
\ No newline at end of file
+}
+TEST(EnvironmentTest, Slots) {
+    Environment global{};
+    Environment outer(&global, 2);
+    Environment inner(&outer, 1);
+    outer.define(LoxObject(1.0));
+    outer.define(LoxObject(2.0));
+    inner.define(LoxObject(3.0));
+    EXPECT_EQ(inner.get_at(0, 0).get<double>(), 3.0);
+    EXPECT_EQ(inner.get_at(1, 0).get<double>(), 1.0);
+    EXPECT_EQ(inner.get_at(1, 1).get<double>(), 2.0);
+    inner.assign_at(1, 1, LoxObject(4.0));
+    EXPECT_EQ(outer.get_at(0, 1).get<double>(), 4.0);
+}
+
+TEST(EnvironmentTreeTest, AddEnvironmentSlots) {
+    EnvironmentTree env_tree{};
+    Environment &new_env = *env_tree.add_environment(&env_tree.globals(), 2);
+    EXPECT_TRUE(new_env.get_at(0, 1).holds_alternative<LoxNull>());
+}
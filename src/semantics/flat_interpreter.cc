@@ -0,0 +1,605 @@
+#include "src/semantics/flat_interpreter.h"
+
+#include "src/logging.h"
+#include "src/semantics/calls.h"
+#include "src/semantics/natives.h"
+#include "src/semantics/object/lox_class.h"
+#include "src/semantics/object/lox_function.h"
+#include "src/semantics/object/lox_instance.h"
+#include "src/semantics/object/print_lox_object.h"
+#include "src/semantics/operators.h"
+#include "src/semantics/runtime_error.h"
+
+#include <iostream>
+#include <utility>
+
+FlatInterpreter::FlatInterpreter()
+    : AbstractInterpreter(natives), ast(), flattened(FlatAst::NONE),
+      at_top_level(true), bodies(), declarations(),
+      m_had_runtime_error(false) {}
+
+Completion FlatInterpreter::execute(const Stmt *stmt) {
+    if (stmt == nullptr) {
+        return Completion::NORMAL;
+    }
+    return execute(flatten(stmt));
+}
+
+Completion FlatInterpreter::execute_block(
+    const std::pmr::vector<Stmt *> &stmts, Environment *environment) {
+    return run(bodies.at(&stmts), environment);
+}
+
+void FlatInterpreter::interpret(const std::pmr::vector<Stmt *> &stmts,
+                                InterpreterMode mode) {
+    if (stmts.empty()) {
+        return;
+    }
+
+    try {
+        at_top_level = true;
+        auto program = ast.list(flatten(stmts));
+
+        for (size_t i = 0; i + 1 < program.size(); ++i) {
+            execute(program[i]);
+        }
+        Index last = program.back();
+        if (mode == InterpreterMode::INTERACTIVE &&
+            ast.kinds[last] == Kind::EXPRESSION) {
+            std::cout << std::boolalpha << evaluate(ast.first[last])
+                      << std::endl;
+        } else {
+            execute(last);
+        }
+    } catch (const RuntimeError &err) {
+        error(err.token.line, err.what());
+        m_had_runtime_error = true;
+        curr_environment = globals();
+    }
+}
+
+bool FlatInterpreter::had_runtime_error() const { return m_had_runtime_error; }
+
+void FlatInterpreter::reset_runtime_error() { m_had_runtime_error = false; }
+
+FlatInterpreter::Index FlatInterpreter::flatten(const Expr *expr) {
+    dispatch(*expr, *this);
+    return std::exchange(flattened, FlatAst::NONE);
+}
+
+FlatInterpreter::Index FlatInterpreter::flatten(const Stmt *stmt) {
+    if (stmt == nullptr) {
+        return FlatAst::NONE;
+    }
+    dispatch(*stmt, *this);
+    return std::exchange(flattened, FlatAst::NONE);
+}
+
+FlatInterpreter::Index
+FlatInterpreter::flatten(const std::pmr::vector<Stmt *> &stmts) {
+    std::vector<Index> nodes;
+    nodes.reserve(stmts.size());
+    for (const auto &stmt : stmts) {
+        nodes.push_back(flatten(stmt));
+    }
+    return ast.add_list(nodes);
+}
+
+FlatInterpreter::Index
+FlatInterpreter::flatten_body(const std::pmr::vector<Stmt *> &body) {
+    bool enclosing_top_level = std::exchange(at_top_level, false);
+    Index statements = flatten(body);
+    at_top_level = enclosing_top_level;
+    return statements;
+}
+
+FlatInterpreter::Index FlatInterpreter::flatten_function(
+    Kind kind, const Token &identifier, const std::pmr::vector<Token> &params,
+    const std::pmr::vector<Stmt *> &body) {
+    Index statements = flatten_body(body);
+    bodies[&body] = statements;
+    declarations.push_back({&identifier, &params, &body});
+    return ast.add(kind, ast.add_token(identifier), statements,
+                   static_cast<Index>(declarations.size() - 1),
+                   static_cast<Index>(scope_size(body)));
+}
+
+void FlatInterpreter::locate(Index node, const Expr &expr,
+                             const Token &name) {
+    if (auto it = locals.find(&expr); it != locals.end()) {
+        ast.depths[node] = it->second.depth;
+        ast.slots[node] = static_cast<Index>(it->second.slot);
+    } else {
+        ast.slots[node] = static_cast<Index>(global_table.slot(name.lexeme));
+    }
+}
+
+void FlatInterpreter::locate_declaration(Index node, const Token &name) {
+    if (at_top_level) {
+        ast.slots[node] = static_cast<Index>(global_table.slot(name.lexeme));
+    } else {
+        ast.depths[node] = 0;
+        ast.slots[node] = static_cast<Index>(local_slot(name));
+    }
+}
+
+void FlatInterpreter::visit_assign_expr(const Expr::Assign &expr) {
+    Index value = flatten(expr.value);
+    flattened = ast.add(Kind::ASSIGN, ast.add_token(expr.name), value);
+    locate(flattened, expr, expr.name);
+}
+
+void FlatInterpreter::visit_binary_expr(const Expr::Binary &expr) {
+    Index left = flatten(expr.left);
+    Index right = flatten(expr.right);
+    flattened = ast.add(Kind::BINARY, ast.add_token(expr.op), left, right,
+                        expr.op.type);
+}
+
+void FlatInterpreter::visit_call_expr(const Expr::Call &expr) {
+    Index callee = flatten(expr.callee);
+    std::vector<Index> arguments;
+    arguments.reserve(expr.arguments.size());
+    for (const auto &argument : expr.arguments) {
+        arguments.push_back(flatten(argument));
+    }
+    flattened =
+        ast.add(is_tail_call(&expr) ? Kind::TAIL_CALL : Kind::CALL,
+                ast.add_token(expr.paren), callee, ast.add_list(arguments));
+}
+
+void FlatInterpreter::visit_get_expr(const Expr::Get &expr) {
+    Index object = flatten(expr.object);
+    flattened = ast.add(Kind::GET, ast.add_token(expr.name), object,
+                        ast.add_property_cache());
+}
+
+void FlatInterpreter::visit_grouping_expr(const Expr::Grouping &expr) {
+    flattened = flatten(expr.expression);
+}
+
+void FlatInterpreter::visit_lambda_expr(const Expr::Lambda &expr) {
+    flattened =
+        flatten_function(Kind::LAMBDA, expr.keyword, expr.params, expr.body);
+}
+
+void FlatInterpreter::visit_literal_expr(const Expr::Literal &expr) {
+    LoxObject value;
+    switch (expr.value.type) {
+    case NIL:
+        break;
+    case TRUE:
+        value = true;
+        break;
+    case FALSE:
+        value = false;
+        break;
+    default:
+        if (expr.value.literal.has_value()) {
+            value = LoxObject(expr.value.literal.value());
+        }
+        break;
+    }
+    constants.push_back(value);
+    flattened = ast.add(Kind::LITERAL, FlatAst::NONE,
+                        static_cast<Index>(constants.size() - 1));
+}
+
+void FlatInterpreter::visit_logical_expr(const Expr::Logical &expr) {
+    Index left = flatten(expr.left);
+    Index right = flatten(expr.right);
+    flattened = ast.add(expr.op.type == OR ? Kind::OR : Kind::AND,
+                        ast.add_token(expr.op), left, right);
+}
+
+void FlatInterpreter::visit_set_expr(const Expr::Set &expr) {
+    Index object = flatten(expr.object);
+    Index value = flatten(expr.value);
+    flattened = ast.add(Kind::SET, ast.add_token(expr.name), object, value,
+                        ast.add_property_cache());
+}
+
+void FlatInterpreter::visit_super_expr(const Expr::Super &expr) {
+    flattened = ast.add(Kind::SUPER, ast.add_token(expr.method));
+    locate(flattened, expr, expr.keyword);
+}
+
+void FlatInterpreter::visit_this_expr(const Expr::This &expr) {
+    flattened = ast.add(Kind::THIS, ast.add_token(expr.keyword));
+    locate(flattened, expr, expr.keyword);
+}
+
+void FlatInterpreter::visit_unary_expr(const Expr::Unary &expr) {
+    Index right = flatten(expr.right);
+    flattened =
+        ast.add(Kind::UNARY, ast.add_token(expr.op), right, expr.op.type);
+}
+
+void FlatInterpreter::visit_variable_expr(const Expr::Variable &expr) {
+    flattened = ast.add(Kind::VARIABLE, ast.add_token(expr.name));
+    locate(flattened, expr, expr.name);
+}
+
+void FlatInterpreter::visit_block_stmt(const Stmt::Block &stmt) {
+    Index statements = flatten_body(stmt.statements);
+    Index slot_count = FlatAst::NONE;
+    if (has_environment(stmt.statements)) {
+        slot_count = static_cast<Index>(scope_size(stmt.statements));
+    }
+    flattened = ast.add(Kind::BLOCK, FlatAst::NONE, statements, slot_count);
+}
+
+void FlatInterpreter::visit_class_stmt(const Stmt::Class &stmt) {
+    Index superclass = FlatAst::NONE;
+    if (stmt.superclass != nullptr) {
+        superclass = flatten(stmt.superclass);
+    }
+    std::vector<Index> methods;
+    methods.reserve(stmt.methods.size());
+    for (const auto &method : stmt.methods) {
+        methods.push_back(flatten_function(Kind::FUNCTION, method->name,
+                                           method->params, method->body));
+    }
+    flattened = ast.add(Kind::CLASS, ast.add_token(stmt.name), superclass,
+                        ast.add_list(methods));
+    locate_declaration(flattened, stmt.name);
+}
+
+void FlatInterpreter::visit_expression_stmt(const Stmt::Expression &stmt) {
+    flattened =
+        ast.add(Kind::EXPRESSION, FlatAst::NONE, flatten(stmt.expression));
+}
+
+void FlatInterpreter::visit_if_stmt(const Stmt::If &stmt) {
+    Index condition = flatten(stmt.condition);
+    Index then_branch = flatten(stmt.then_branch);
+    Index else_branch = flatten(stmt.else_branch);
+    flattened = ast.add(Kind::IF, FlatAst::NONE, condition, then_branch,
+                        else_branch);
+}
+
+void FlatInterpreter::visit_function_stmt(const Stmt::Function &stmt) {
+    flattened =
+        flatten_function(Kind::FUNCTION, stmt.name, stmt.params, stmt.body);
+    locate_declaration(flattened, stmt.name);
+}
+
+void FlatInterpreter::visit_print_stmt(const Stmt::Print &stmt) {
+    flattened = ast.add(Kind::PRINT, FlatAst::NONE, flatten(stmt.expression));
+}
+
+void FlatInterpreter::visit_return_stmt(const Stmt::Return &stmt) {
+    Index value = FlatAst::NONE;
+    if (stmt.value != nullptr) {
+        value = flatten(stmt.value);
+    }
+    flattened = ast.add(Kind::RETURN, ast.add_token(stmt.keyword), value);
+}
+
+void FlatInterpreter::visit_var_stmt(const Stmt::Var &stmt) {
+    Index initializer = FlatAst::NONE;
+    if (stmt.initializer != nullptr) {
+        initializer = flatten(stmt.initializer);
+    }
+    flattened = ast.add(Kind::VAR, ast.add_token(stmt.name), initializer);
+    locate_declaration(flattened, stmt.name);
+}
+
+void FlatInterpreter::visit_while_stmt(const Stmt::While &stmt) {
+    Index condition = flatten(stmt.condition);
+    Index body = flatten(stmt.body);
+    if (stmt.counted.has_value()) {
+        constants.push_back(stmt.counted->step);
+        flattened = ast.add(Kind::COUNTED_WHILE, FlatAst::NONE, condition,
+                            body, static_cast<Index>(constants.size() - 1));
+        return;
+    }
+    flattened = ast.add(Kind::WHILE, FlatAst::NONE, condition, body);
+}
+
+LoxObject FlatInterpreter::evaluate(Index node) {
+    switch (ast.kinds[node]) {
+    case Kind::ASSIGN: {
+        LoxObject value = evaluate(ast.first[node]);
+        assign_variable(node, value);
+        return value;
+    }
+    case Kind::BINARY:
+        return evaluate_binary(node);
+    case Kind::AND: {
+        LoxObject value = evaluate(ast.first[node]);
+        return !static_cast<bool>(value) ? value : evaluate(ast.second[node]);
+    }
+    case Kind::OR: {
+        LoxObject value = evaluate(ast.first[node]);
+        return static_cast<bool>(value) ? value : evaluate(ast.second[node]);
+    }
+    case Kind::CALL:
+        return evaluate_call(node, false);
+    case Kind::TAIL_CALL:
+        return evaluate_call(node, true);
+    case Kind::GET: {
+        const Token &name = ast.token(node);
+        LoxObject object = evaluate(ast.first[node]);
+        return get_instance(name, object)
+            ->get(name, ast.property_caches[ast.second[node]]);
+    }
+    case Kind::LAMBDA:
+        return make_function(node);
+    case Kind::LITERAL:
+        return constants[ast.first[node]];
+    case Kind::SET: {
+        TemporaryRoots roots(*this);
+        LoxObject instance = roots.add(evaluate(ast.first[node]));
+        if (!instance.holds_alternative<LoxInstance *>()) {
+            throw RuntimeError(ast.token(node), "Only instances have fields.");
+        }
+        LoxObject value = evaluate(ast.second[node]);
+        instance.get<LoxInstance *>()->set(
+            ast.token(node), value, ast.property_caches[ast.third[node]]);
+        return value;
+    }
+    case Kind::SUPER: {
+        LoxObject this_object;
+        LoxFunction *method =
+            find_super_method(curr_environment, ast.depths[node],
+                              ast.slots[node], ast.token(node), this_object);
+        return method->bind(this_object);
+    }
+    case Kind::THIS:
+        return curr_environment->get_at(ast.depths[node], ast.slots[node]);
+    case Kind::UNARY: {
+        LoxObject value = evaluate(ast.first[node]);
+        if (ast.second[node] == MINUS and value.holds_alternative<double>()) {
+            return -value.get<double>();
+        }
+        return unary_op(ast.token(node), value);
+    }
+    case Kind::VARIABLE:
+        return evaluate_variable(node);
+    default:
+        throw std::logic_error("Not an expression node.");
+    }
+}
+
+LoxObject FlatInterpreter::evaluate_binary(Index node) {
+    TemporaryRoots roots(*this);
+    LoxObject left = evaluate(ast.first[node]);
+    if (not left.holds_alternative<double>()) {
+        roots.add(left);
+    }
+    LoxObject right = evaluate(ast.second[node]);
+    if (left.holds_alternative<double>() and
+        right.holds_alternative<double>()) {
+        double a = left.get<double>();
+        double b = right.get<double>();
+        switch (ast.third[node]) {
+        case PLUS:
+            return a + b;
+        case MINUS:
+            return a - b;
+        case STAR:
+            return a * b;
+        case GREATER:
+            return a > b;
+        case GREATER_EQUAL:
+            return a >= b;
+        case LESS:
+            return a < b;
+        case LESS_EQUAL:
+            return a <= b;
+        default:
+            break;
+        }
+    }
+    return binary_op(ast.token(node), left, right);
+}
+
+LoxObject FlatInterpreter::evaluate_call(Index node, bool in_tail_position) {
+    TemporaryRoots roots(*this);
+    const Token &paren = ast.token(node);
+    Index callee = ast.first[node];
+
+    LoxObject this_object;
+    LoxFunction *method = nullptr;
+    if (ast.kinds[callee] == Kind::GET) {
+        PropertyCache &cache = ast.property_caches[ast.second[callee]];
+        this_object = roots.add(evaluate(ast.first[callee]));
+        LoxObject function;
+        method = find_method(ast.token(callee), cache, this_object, function);
+        if (method == nullptr) {
+            roots.add(function);
+            return call_value(*this, paren, function,
+                              evaluate_arguments(ast.second[node], roots),
+                              in_tail_position);
+        }
+    } else if (ast.kinds[callee] == Kind::SUPER) {
+        method = find_super_method(curr_environment, ast.depths[callee],
+                                   ast.slots[callee], ast.token(callee),
+                                   this_object);
+    } else {
+        LoxObject function = roots.add(evaluate(callee));
+        return call_value(*this, paren, function,
+                          evaluate_arguments(ast.second[node], roots),
+                          in_tail_position);
+    }
+
+    return call_method(*this, paren, method, this_object,
+                       evaluate_arguments(ast.second[node], roots),
+                       in_tail_position);
+}
+
+LoxObject FlatInterpreter::evaluate_variable(Index node) {
+    if (ast.depths[node] == FlatAst::GLOBAL) {
+        return global_table.get(ast.slots[node], ast.token(node));
+    }
+    return curr_environment->get_at(ast.depths[node], ast.slots[node]);
+}
+
+void FlatInterpreter::assign_variable(Index node, const LoxObject &value) {
+    if (ast.depths[node] == FlatAst::GLOBAL) {
+        global_table.assign(ast.slots[node], ast.token(node), value);
+    } else {
+        curr_environment->assign_at(ast.depths[node], ast.slots[node], value);
+    }
+}
+
+void FlatInterpreter::define(Index node, const LoxObject &value) {
+    if (ast.depths[node] == FlatAst::GLOBAL) {
+        global_table.define(ast.slots[node], value);
+    } else {
+        curr_environment->assign_at(0, ast.slots[node], value);
+    }
+}
+
+std::vector<LoxObject>
+FlatInterpreter::evaluate_arguments(Index arguments, TemporaryRoots &roots) {
+    auto nodes = ast.list(arguments);
+    std::vector<LoxObject> values;
+    values.reserve(nodes.size());
+    for (Index argument : nodes) {
+        values.push_back(roots.add(evaluate(argument)));
+    }
+    return values;
+}
+
+LoxFunction *FlatInterpreter::make_function(Index node, bool is_initializer) {
+    const FunctionDeclaration &declaration = declarations[ast.second[node]];
+    return Heap::instance().allocate<LoxFunction>(
+        *declaration.identifier, *declaration.params, *declaration.body,
+        curr_environment, ast.third[node], is_initializer);
+}
+
+Completion FlatInterpreter::execute(Index node) {
+    if (node == FlatAst::NONE) {
+        return Completion::NORMAL;
+    }
+
+    switch (ast.kinds[node]) {
+    case Kind::BLOCK:
+        return run_block(node, ast.list(ast.first[node]));
+    case Kind::CLASS:
+        return execute_class(node);
+    case Kind::EXPRESSION:
+        evaluate(ast.first[node]);
+        return Completion::NORMAL;
+    case Kind::FUNCTION:
+        define(node, make_function(node));
+        return Completion::NORMAL;
+    case Kind::IF:
+        return static_cast<bool>(evaluate(ast.first[node]))
+                   ? execute(ast.second[node])
+                   : execute(ast.third[node]);
+    case Kind::PRINT:
+        std::cout << std::boolalpha << evaluate(ast.first[node]) << std::endl;
+        return Completion::NORMAL;
+    case Kind::RETURN:
+        return_value = ast.first[node] == FlatAst::NONE
+                           ? LoxObject{}
+                           : evaluate(ast.first[node]);
+        return Completion::RETURN;
+    case Kind::VAR:
+        define(node, ast.first[node] == FlatAst::NONE
+                         ? LoxObject(LoxNull{})
+                         : evaluate(ast.first[node]));
+        return Completion::NORMAL;
+    case Kind::WHILE:
+        return execute_while(node);
+    case Kind::COUNTED_WHILE:
+        return execute_counted_loop(node);
+    default:
+        throw std::logic_error("Not a statement node.");
+    }
+}
+
+Completion FlatInterpreter::run(Index statements, Environment *environment) {
+    return run(ast.list(statements), environment);
+}
+
+Completion FlatInterpreter::run(std::span<const Index> statements,
+                                Environment *environment) {
+    EnvironmentScope scope(*this, environment);
+    return run(statements);
+}
+
+Completion FlatInterpreter::run(std::span<const Index> statements) {
+    for (Index stmt : statements) {
+        if (execute(stmt) == Completion::RETURN) {
+            return Completion::RETURN;
+        }
+    }
+    return Completion::NORMAL;
+}
+
+Completion FlatInterpreter::run_block(Index block,
+                                      std::span<const Index> statements) {
+    if (ast.second[block] == FlatAst::NONE) {
+        return run(statements);
+    }
+    return run(statements,
+               add_environment(curr_environment, ast.second[block]));
+}
+
+Completion FlatInterpreter::execute_while(Index node) {
+    while (static_cast<bool>(evaluate(ast.first[node]))) {
+        if (execute(ast.second[node]) == Completion::RETURN) {
+            return Completion::RETURN;
+        }
+        end_iteration();
+    }
+    return Completion::NORMAL;
+}
+
+Completion FlatInterpreter::execute_counted_loop(Index node) {
+    Index condition = ast.first[node];
+    Index counter_node = ast.first[condition];
+    LoxObject &counter = curr_environment->get_at(ast.depths[counter_node],
+                                                  ast.slots[counter_node]);
+    LoxObject limit = evaluate(ast.second[condition]);
+    if (!counter.holds_alternative<double>() or
+        !limit.holds_alternative<double>()) {
+        return execute_while(node);
+    }
+
+    Index body = ast.second[node];
+    auto statements = ast.list(ast.first[body]);
+    return count_loop(
+        static_cast<TokenType>(ast.third[condition]),
+        constants[ast.third[node]].get<double>(), counter, limit.get<double>(),
+        [&] {
+            return run_block(body, statements.first(statements.size() - 1));
+        });
+}
+
+Completion FlatInterpreter::execute_class(Index node) {
+    LoxClass *superclass = nullptr;
+    if (Index superclass_node = ast.first[node];
+        superclass_node != FlatAst::NONE) {
+        LoxObject superclass_obj = evaluate(superclass_node);
+        if (!superclass_obj.holds_alternative<LoxClass>()) {
+            throw RuntimeError(ast.token(superclass_node),
+                               "Superclass must be a class.");
+        }
+        superclass = superclass_obj.get<LoxClass>();
+
+        curr_environment = add_environment(curr_environment, 1);
+        curr_environment->define(superclass);
+    }
+
+    LoxClass::MethodMap methods;
+    for (Index method : ast.list(ast.second[node])) {
+        std::string_view method_name = ast.token(method).lexeme;
+        methods[std::string(method_name)] =
+            make_function(method, method_name == "init");
+    }
+
+    LoxCallable *lox_class = Heap::instance().allocate<LoxClass>(
+        ast.token(node).lexeme, superclass, std::move(methods));
+
+    if (superclass != nullptr) {
+        curr_environment = curr_environment->enclosing;
+    }
+
+    define(node, lox_class);
+    return Completion::NORMAL;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "src/semantics/abstract_interpreter.h"
+#include "src/semantics/interpreter_mode.h"
+#include "src/semantics/object/lox_object.h"
+#include "src/syntactics/expr.h"
+#include "src/syntactics/flat_ast.h"
+#include "src/syntactics/stmt.h"
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Runs a resolved program by first flattening it, once, into a FlatAst, and
+// then walking that: nodes are dispatched on their kind and reach their
+// children by index. The Resolver's depths and slots are copied into the
+// AST's parallel arrays, so variables are found without a lookup. Shares its
+// runtime (environments, objects, the collector) with the tree-walking
+// Interpreter.
+struct FlatInterpreter final : AbstractInterpreter, ExprVisitor, StmtVisitor {
+    FlatInterpreter();
+
+    // Flattens `stmt` and runs it.
+    Completion execute(const Stmt *stmt) override;
+    // Function calls come through here: runs the flattened body.
+    Completion execute_block(const std::pmr::vector<Stmt *> &stmts,
+                             Environment *environment) override;
+
+    void interpret(const std::pmr::vector<Stmt *> &stmts,
+                   InterpreterMode mode = InterpreterMode::FILE);
+
+    bool had_runtime_error() const;
+    void reset_runtime_error();
+
+  private:
+    using Index = FlatAst::Index;
+    using Kind = FlatAst::Kind;
+
+    // What a function node needs to make a LoxFunction, which refers to the
+    // declaration it came from.
+    struct FunctionDeclaration {
+        const Token *identifier;
+        const std::pmr::vector<Token> *params;
+        const std::pmr::vector<Stmt *> *body;
+    };
+
+    Index flatten(const Expr *expr);
+    Index flatten(const Stmt *stmt);
+    // Returns the list of the flattened statements.
+    Index flatten(const std::pmr::vector<Stmt *> &stmts);
+    Index flatten_body(const std::pmr::vector<Stmt *> &body);
+    Index flatten_function(Kind kind, const Token &identifier,
+                           const std::pmr::vector<Token> &params,
+                           const std::pmr::vector<Stmt *> &body);
+    // Copies where the Resolver found the variable `expr` names into `node`.
+    void locate(Index node, const Expr &expr, const Token &name);
+    // Where the declaration `node` stores its variable: a global slot at the
+    // top level, the next local otherwise.
+    void locate_declaration(Index node, const Token &name);
+
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
+    void visit_assign_expr(const Expr::Assign &expr) override;
+    void visit_binary_expr(const Expr::Binary &expr) override;
+    void visit_call_expr(const Expr::Call &expr) override;
+    void visit_get_expr(const Expr::Get &expr) override;
+    void visit_grouping_expr(const Expr::Grouping &expr) override;
+    void visit_lambda_expr(const Expr::Lambda &expr) override;
+    void visit_literal_expr(const Expr::Literal &expr) override;
+    void visit_logical_expr(const Expr::Logical &expr) override;
+    void visit_set_expr(const Expr::Set &expr) override;
+    void visit_super_expr(const Expr::Super &expr) override;
+    void visit_this_expr(const Expr::This &expr) override;
+    void visit_unary_expr(const Expr::Unary &expr) override;
+    void visit_variable_expr(const Expr::Variable &expr) override;
+
+    void visit_block_stmt(const Stmt::Block &stmt) override;
+    void visit_class_stmt(const Stmt::Class &stmt) override;
+    void visit_expression_stmt(const Stmt::Expression &stmt) override;
+    void visit_if_stmt(const Stmt::If &stmt) override;
+    void visit_function_stmt(const Stmt::Function &stmt) override;
+    void visit_print_stmt(const Stmt::Print &stmt) override;
+    void visit_return_stmt(const Stmt::Return &stmt) override;
+    void visit_var_stmt(const Stmt::Var &stmt) override;
+    void visit_while_stmt(const Stmt::While &stmt) override;
+
+    LoxObject evaluate(Index node);
+    Completion execute(Index node);
+    Completion run(Index statements, Environment *environment);
+    Completion run(std::span<const Index> statements, Environment *environment);
+    // Runs `statements` in the current environment.
+    Completion run(std::span<const Index> statements);
+    // Runs `statements` of BLOCK `block` as the block would.
+    Completion run_block(Index block, std::span<const Index> statements);
+
+    LoxObject evaluate_binary(Index node);
+    LoxObject evaluate_call(Index node, bool in_tail_position);
+    LoxObject evaluate_variable(Index node);
+    void assign_variable(Index node, const LoxObject &value);
+    void define(Index node, const LoxObject &value);
+    Completion execute_class(Index node);
+    Completion execute_while(Index node);
+    Completion execute_counted_loop(Index node);
+    LoxFunction *make_function(Index node, bool is_initializer = false);
+
+    std::vector<LoxObject> evaluate_arguments(Index arguments,
+                                              TemporaryRoots &roots);
+
+    FlatAst ast;
+    Index flattened;
+    // Whether the statements being flattened run in the global environment.
+    bool at_top_level;
+    // The statement list every function body was flattened to.
+    std::unordered_map<const std::pmr::vector<Stmt *> *, Index> bodies;
+    std::vector<FunctionDeclaration> declarations;
+    bool m_had_runtime_error;
+};
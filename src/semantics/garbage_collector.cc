@@ -0,0 +1,59 @@
+#include "src/semantics/garbage_collector.h"
+
+std::ostream &operator<<(std::ostream &os, const GcStats &stats) {
+    auto pause_ms =
+        std::chrono::duration<double, std::milli>(stats.pause_time).count();
+    return os << "gc: " << stats.collections << " collections, "
+              << stats.freed_objects << " objects and "
+              << stats.freed_environments << " environments freed, "
+              << stats.peak_live << " peak live, " << pause_ms
+              << " ms paused";
+}
+
+GarbageCollector::GarbageCollector(EnvironmentTree &environments)
+    : environments(environments), gray_objects(), gray_environments() {}
+
+void GarbageCollector::mark_object(const HeapObject *object) {
+    if (object == nullptr or object->is_marked) {
+        return;
+    }
+    object->is_marked = true;
+    gray_objects.push_back(object);
+}
+
+void GarbageCollector::mark_value(const LoxObject &value) {
+    mark_object(value.heap_object());
+}
+
+void GarbageCollector::mark_environment(Environment *environment) {
+    if (environment == nullptr or environment->is_marked) {
+        return;
+    }
+    environment->is_marked = true;
+    gray_environments.push_back(environment);
+}
+
+void GarbageCollector::collect(GcStats &stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    trace_references();
+    stats.freed_environments += environments.sweep();
+    stats.freed_objects += Heap::instance().sweep();
+
+    ++stats.collections;
+    stats.pause_time += std::chrono::steady_clock::now() - start;
+}
+
+void GarbageCollector::trace_references() {
+    while (!gray_objects.empty() or !gray_environments.empty()) {
+        if (!gray_environments.empty()) {
+            Environment *environment = gray_environments.back();
+            gray_environments.pop_back();
+            environment->trace(*this);
+        } else {
+            const HeapObject *object = gray_objects.back();
+            gray_objects.pop_back();
+            object->trace(*this);
+        }
+    }
+}
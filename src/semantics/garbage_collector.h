@@ -0,0 +1,48 @@
+#pragma once
+
+#include "src/semantics/environment.h"
+#include "src/semantics/object/heap.h"
+#include "src/semantics/object/lox_object.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// When the interpreter collects: once the number of heap objects plus
+// environments reaches `initial_threshold` for the first time, and after
+// that once it reaches `growth_factor` times what survived the previous
+// collection.
+struct GcSettings {
+    size_t initial_threshold = 1 << 14;
+    size_t growth_factor = 2;
+};
+
+struct GcStats {
+    size_t collections = 0;
+    size_t freed_objects = 0;
+    size_t freed_environments = 0;
+    size_t peak_live = 0;
+    std::chrono::nanoseconds pause_time{0};
+};
+
+std::ostream &operator<<(std::ostream &os, const GcStats &stats);
+
+// A single mark-sweep collection: mark the roots, then collect() traces
+// everything reachable from them and frees the heap objects and
+// environments it did not reach.
+struct GarbageCollector final : Tracer {
+    explicit GarbageCollector(EnvironmentTree &environments);
+
+    void mark_object(const HeapObject *object) override;
+    void mark_value(const LoxObject &value) override;
+    void mark_environment(Environment *environment) override;
+
+    void collect(GcStats &stats);
+
+  private:
+    void trace_references();
+
+    EnvironmentTree &environments;
+    std::vector<const HeapObject *> gray_objects;
+    std::vector<Environment *> gray_environments;
+};
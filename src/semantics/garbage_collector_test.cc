@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/interpreter.h"
+#include "src/semantics/testing.h"
+
+#include <sys/resource.h>
+
+#include <string>
+
+namespace {
+
+// Runs `source` on `interpreter` and returns everything it printed.
+std::string run(Interpreter &interpreter, const std::string &source) {
+    return run_on(interpreter, source).output;
+}
+
+long max_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+std::string calls_program(int calls) {
+    return "var n = 0;\n"
+           "fun f(x) { var y = x; n = y; }\n"
+           "for (var i = 0; i < " +
+           std::to_string(calls) + "; i = i + 1) { f(i); }\n";
+}
+
+} // namespace
+
+TEST(GarbageCollectorTest, ReclaimsFinishedFrames) {
+    constexpr GcSettings settings{.initial_threshold = 1000,
+                                  .growth_factor = 2};
+    Interpreter interpreter;
+    interpreter.configure_gc(settings);
+    // What earlier tests left in the shared heap.
+    size_t garbage = Heap::instance().size();
+    run(interpreter, calls_program(200000));
+
+    // Each iteration adds a call environment, which is freed once the heap
+    // grows past the threshold again.
+    const GcStats &stats = interpreter.gc_stats();
+    EXPECT_GT(stats.collections, 100);
+    EXPECT_LE(stats.peak_live, garbage + 2 * settings.initial_threshold);
+    EXPECT_LE(interpreter.environments.size(), settings.initial_threshold);
+}
+
+TEST(GarbageCollectorTest, AllowsOneInterpreterAtATime) {
+    // Collections of either would free what only the other one holds.
+    EXPECT_DEBUG_DEATH(
+        {
+            Interpreter first;
+            Interpreter second;
+        },
+        "Only one interpreter");
+}
+
+TEST(GarbageCollectorTest, BlocksOnlyAddEnvironmentsForCapturedLocals) {
+    Interpreter interpreter;
+    EXPECT_EQ(run(interpreter, R"(
+        fun work(n) {
+            var total = 0;
+            for (var i = 0; i < n; i = i + 1) {
+                var j = i;
+                { var k = j; total = total + k; }
+                { total = total + 0; }
+            }
+            return total;
+        }
+        print work(1000);
+    )"),
+              "499500\n");
+    // The globals, and the frame of the call, which holds the locals of its
+    // blocks too.
+    EXPECT_EQ(interpreter.environments.size(), 2);
+
+    // Here every iteration has its own `v` for `get` to capture.
+    EXPECT_EQ(run(interpreter, R"(
+        var first;
+        for (var i = 0; i < 3; i = i + 1) {
+            var v = i;
+            fun get() { return v; }
+            if (i == 0) first = get;
+        }
+        print first();
+    )"),
+              "0\n");
+    // The loop, its iterations and the call of `first` add one each.
+    EXPECT_EQ(interpreter.environments.size(), 2 + 1 + 3 + 1);
+}
+
+TEST(GarbageCollectorTest, KeepsReachableEnvironments) {
+    Interpreter interpreter;
+    EXPECT_EQ(run(interpreter, R"(
+        fun make(n) { var v = n; return fun() { return v; }; }
+        fun apply(f, g) { return f() + g(); }
+        class Box {
+            init(v) { this.f = make(v); }
+            get() { return this.f(); }
+        }
+        var boxes = nil;
+        var total = 0;
+        for (var i = 0; i < 20000; i = i + 1) {
+            var box = Box(i);
+            total = total + apply(make(i), box.f) + box.get();
+            if (i == 7) { boxes = box; }
+        }
+        print total;
+        print boxes.get();
+    )"),
+              "5.9997e+08\n7\n");
+}
+
+TEST(GarbageCollectorTest, ReclaimsCycles) {
+    Interpreter interpreter;
+    interpreter.configure_gc({.initial_threshold = 1024, .growth_factor = 2});
+    EXPECT_EQ(run(interpreter, R"(
+        class Node {
+            init(value) { this.value = value; this.self = this.get; }
+            get() { return this.value; }
+        }
+        fun make_counter() {
+            var count = 0;
+            fun counter() { count = count + 1; return counter; }
+            return counter;
+        }
+        var sum = 0;
+        for (var i = 0; i < 20000; i = i + 1) {
+            var a = Node(i);
+            var b = Node(i);
+            a.next = b;
+            b.next = a;
+            sum = sum + a.next.next.self();
+            make_counter()()();
+        }
+        print sum;
+    )"),
+              "1.9999e+08\n");
+
+    const GcStats &stats = interpreter.gc_stats();
+    EXPECT_GT(stats.collections, 0);
+    // Each iteration leaves two nodes, their bound methods and a counter.
+    EXPECT_GT(stats.freed_objects, 5 * 20000 - 4096);
+    EXPECT_LT(Heap::instance().size(), 4096);
+}
+
+TEST(GarbageCollectorTest, DirectMethodCallsDoNotAllocate) {
+    Interpreter interpreter;
+    interpreter.configure_gc({.initial_threshold = 1 << 30});
+    size_t heap_size = Heap::instance().size();
+    EXPECT_EQ(run(interpreter, R"(
+        class Counter {
+            init() { this.count = 0; }
+            add(n) { this.count = this.count + n; return this; }
+        }
+        class Twice < Counter {
+            add(n) { return super.add(2 * n); }
+        }
+        var counter = Twice();
+        for (var i = 0; i < 100000; i = i + 1) { counter.add(1).add(1); }
+        print counter.count;
+    )"),
+              "400000\n");
+
+    // Just the classes, their methods and the instance: only methods used
+    // as values are bound on the heap.
+    EXPECT_EQ(interpreter.gc_stats().collections, 0);
+    EXPECT_LT(Heap::instance().size() - heap_size, 16);
+}
+
+TEST(GarbageCollectorTest, RssIsBoundedAcross10MCalls) {
+    Interpreter interpreter;
+    run(interpreter, calls_program(1000000));
+    long warm_rss = max_rss_kb();
+
+    run(interpreter, calls_program(10000000));
+    // Without collection every call would leak its environment, well over a
+    // gigabyte in total.
+    EXPECT_LT(max_rss_kb() - warm_rss, 16 * 1024);
+}
@@ -0,0 +1,57 @@
+#include "src/semantics/global_table.h"
+
+#include "src/semantics/runtime_error.h"
+
+namespace {
+
+uint64_t next_table_id = 0;
+
+} // namespace
+
+GlobalTable::GlobalTable()
+    : m_id(next_table_id++), slots(), values(), defined() {}
+
+uint64_t GlobalTable::id() const { return m_id; }
+
+size_t GlobalTable::slot(std::string_view name) {
+    if (auto it = slots.find(name); it != slots.end()) {
+        return it->second;
+    }
+    slots.emplace(name, values.size());
+    values.emplace_back();
+    defined.push_back(false);
+    return values.size() - 1;
+}
+
+void GlobalTable::define(size_t slot, const LoxObject &value) {
+    values[slot] = value;
+    defined[slot] = true;
+}
+
+void GlobalTable::define(std::string_view name, const LoxObject &value) {
+    define(slot(name), value);
+}
+
+LoxObject &GlobalTable::get(size_t slot, const Token &name) {
+    check_defined(slot, name);
+    return values[slot];
+}
+
+void GlobalTable::assign(size_t slot, const Token &name,
+                         const LoxObject &value) {
+    check_defined(slot, name);
+    values[slot] = value;
+}
+
+void GlobalTable::trace(Tracer &tracer) const {
+    for (const auto &value : values) {
+        tracer.mark_value(value);
+    }
+}
+
+void GlobalTable::check_defined(size_t slot, const Token &name) const {
+    if (!defined[slot]) {
+        throw RuntimeError(name, "Undefined variable '" +
+                                     std::string(name.lexeme) + "'.");
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "src/semantics/object/heap.h"
+#include "src/semantics/object/lox_object.h"
+#include "src/syntactics/token.h"
+#include "src/tp_utils.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// The global variables, stored densely. Every name gets a fixed slot the
+// first time it is resolved or defined, so a slot stays valid across
+// redefinitions; a slot whose variable was never defined reads as undefined.
+struct GlobalTable {
+    GlobalTable();
+
+    GlobalTable(const GlobalTable &) = delete;
+    GlobalTable &operator=(const GlobalTable &) = delete;
+
+    // Unique for the lifetime of the process, so caches can tell tables apart.
+    uint64_t id() const;
+
+    // The slot of `name`, which is reserved if it has none yet.
+    size_t slot(std::string_view name);
+
+    void define(size_t slot, const LoxObject &value);
+    void define(std::string_view name, const LoxObject &value);
+
+    // `name` is only used to report an undefined variable.
+    LoxObject &get(size_t slot, const Token &name);
+    void assign(size_t slot, const Token &name, const LoxObject &value);
+
+    void trace(Tracer &tracer) const;
+
+  private:
+    void check_defined(size_t slot, const Token &name) const;
+
+    uint64_t m_id;
+    StringMap<size_t> slots;
+    std::vector<LoxObject> values;
+    std::vector<bool> defined;
+};
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/global_table.h"
+#include "src/semantics/runtime_error.h"
+
+namespace {
+
+Token identifier(std::string_view name) {
+    return Token(IDENTIFIER, name, 1);
+}
+
+} // namespace
+
+TEST(GlobalTableTest, SlotsAreStablePerName) {
+    GlobalTable table{};
+    size_t a = table.slot("a");
+    size_t b = table.slot("b");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(table.slot("a"), a);
+}
+
+TEST(GlobalTableTest, RedefinitionReusesSlot) {
+    GlobalTable table{};
+    size_t a = table.slot("a");
+    table.define("a", LoxObject(1.0));
+    table.define("a", LoxObject(2.0));
+    EXPECT_EQ(table.get(a, identifier("a")).get<double>(), 2.0);
+}
+
+TEST(GlobalTableTest, ReservedSlotIsUndefined) {
+    GlobalTable table{};
+    size_t a = table.slot("a");
+    EXPECT_THROW(table.get(a, identifier("a")), RuntimeError);
+    EXPECT_THROW(table.assign(a, identifier("a"), LoxObject(1.0)),
+                 RuntimeError);
+    table.define(a, LoxObject(1.0));
+    table.assign(a, identifier("a"), LoxObject(3.0));
+    EXPECT_EQ(table.get(a, identifier("a")).get<double>(), 3.0);
+}
+
+TEST(GlobalTableTest, IdsAreUnique) {
+    GlobalTable first{};
+    GlobalTable second{};
+    EXPECT_NE(first.id(), second.id());
+}
@@ -1,30 +1,29 @@
 #include "src/semantics/interpreter.h"
 
-#include "interpreter.h"
 #include "src/logging.h"
+#include "src/semantics/calls.h"
 #include "src/semantics/natives.h"
 #include "src/semantics/object/lox_class.h"
 #include "src/semantics/object/lox_function.h"
 #include "src/semantics/object/lox_instance.h"
-#include "src/semantics/return.h"
+#include "src/semantics/operators.h"
 #include "src/tp_utils.h"
 
+#include <algorithm>
+#include <utility>
+
 Interpreter::Interpreter()
-    : AbstractInterpreter(), expr_result(LoxNull{}),
-      m_had_runtime_error(false) {
-    Environment *global_environment = globals();
-    for (const auto &[name, obj] : natives) {
-        global_environment->define(name, obj);
-    }
-}
+    : AbstractInterpreter(natives), expr_result(LoxNull{}),
+      completion(Completion::NORMAL), m_had_runtime_error(false) {}
 
-void Interpreter::execute(const Stmt *stmt) {
+Completion Interpreter::execute(const Stmt *stmt) {
     if (stmt) {
-        stmt->accept(*this);
+        dispatch(*stmt, *this);
     }
+    return std::exchange(completion, Completion::NORMAL);
 }
 
-void Interpreter::interpret(const std::vector<std::shared_ptr<Stmt>> &stmts,
+void Interpreter::interpret(const std::pmr::vector<Stmt *> &stmts,
                             InterpreterMode mode) {
     if (stmts.empty()) {
         return;
@@ -34,7 +33,7 @@ void Interpreter::interpret(const std::vector<std::shared_ptr<Stmt>> &stmts,
         std::for_each(stmts.begin(), --stmts.end(),
                       [this](const auto &stmt) { execute(stmt); });
 
-        const Stmt *last_stmt = (--stmts.end())->get();
+        const Stmt *last_stmt = stmts.back();
         execute(last_stmt);
 
         const Stmt::Expression *expression =
@@ -55,84 +54,65 @@ void Interpreter::reset_runtime_error() { m_had_runtime_error = false; }
 void Interpreter::visit_assign_expr(const Expr::Assign &assign) {
     LoxObject value = evaluate(assign.value);
 
-    if (locals.contains(&assign)) {
-        int distance = locals[&assign];
-        curr_environment->assign_at(assign.name, value, distance);
+    if (assign.global.valid_for(global_table.id())) {
+        global_table.assign(assign.global.slot, assign.name, value);
+    } else if (auto it = locals.find(&assign); it != locals.end()) {
+        auto [depth, slot] = it->second;
+        curr_environment->assign_at(depth, slot, value);
     } else {
-        globals()->assign(assign.name, value);
+        global_table.assign(global_slot(assign.name, assign.global),
+                            assign.name, value);
     }
     expr_result = value;
 }
 
 void Interpreter::visit_binary_expr(const Expr::Binary &binary) {
-    binary.left->accept(*this);
+    TemporaryRoots roots(*this);
+    dispatch(*binary.left, *this);
     LoxObject left = expr_result;
+    if (not left.holds_alternative<double>()) {
+        roots.add(left);
+    }
 
-    binary.right->accept(*this);
+    dispatch(*binary.right, *this);
     LoxObject right = expr_result;
 
-    switch (binary.op.type) {
-    case MINUS:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left.get<double>() - right.get<double>();
-        break;
-    case SLASH:
-        check_numeric_op(binary.op, left, right);
-        if (right.get<double>() == 0) {
-            throw RuntimeError(binary.op, "Division by zero.");
+    switch (binary.specialization) {
+    case BinarySpecialization::NUMBER:
+        if (left.holds_alternative<double>() and
+            right.holds_alternative<double>()) {
+            expr_result = number_op(binary.op, left.get<double>(),
+                                    right.get<double>());
+            return;
         }
-        expr_result = left.get<double>() / right.get<double>();
-        break;
-    case STAR:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left.get<double>() * right.get<double>();
+        binary.specialization = BinarySpecialization::GENERIC;
         break;
-    case PLUS:
-        if (left.holds_alternative<double>() &&
-            right.holds_alternative<double>()) {
-            expr_result = left.get<double>() + right.get<double>();
-        } else if (left.holds_alternative<std::string>() &&
-                   right.holds_alternative<std::string>()) {
+    case BinarySpecialization::STRING:
+        if (left.holds_alternative<std::string>() and
+            right.holds_alternative<std::string>()) {
             expr_result = left.get<std::string>() + right.get<std::string>();
-        } else {
-            throw RuntimeError(binary.op,
-                               "Operands must be two numbers or two strings.");
+            return;
         }
+        binary.specialization = BinarySpecialization::GENERIC;
         break;
-    case GREATER:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left > right;
+    case BinarySpecialization::UNINITIALIZED:
+        binary.specialization = specialize(binary.op.type, left, right);
         break;
-    case GREATER_EQUAL:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left >= right;
-        break;
-    case LESS:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left < right;
-        break;
-    case LESS_EQUAL:
-        check_numeric_op(binary.op, left, right);
-        expr_result = left <= right;
-        break;
-    case EQUAL_EQUAL:
-        expr_result = left == right;
-        break;
-    case BANG_EQUAL:
-        expr_result = left != right;
-        break;
-    default:
+    case BinarySpecialization::GENERIC:
         break;
     }
+
+    expr_result = binary_op(binary.op, left, right);
 }
 
 void Interpreter::visit_grouping_expr(const Expr::Grouping &grouping) {
-    grouping.expression->accept(*this);
+    dispatch(*grouping.expression, *this);
 }
 
 void Interpreter::visit_lambda_expr(const Expr::Lambda &func) {
     LoxObject func_object =
-        std::make_shared<LoxFunction>(func, curr_environment);
+        Heap::instance().allocate<LoxFunction>(func, curr_environment,
+                                               scope_size(func.body));
     expr_result = func_object;
 }
 
@@ -147,10 +127,16 @@ void Interpreter::visit_literal_expr(const Expr::Literal &literal) {
     case FALSE:
         expr_result = false;
         break;
-    default:
-        if (literal.value.literal.has_value()) {
-            expr_result = variant_cast(literal.value.literal.value());
+    case STRING:
+        // Made once, rather than allocated on every evaluation.
+        if (!literal.constant.valid_for(global_table.id())) {
+            literal.constant = {global_table.id(), constants.size()};
+            constants.push_back(LoxObject(literal.value.literal.value()));
         }
+        expr_result = constants[literal.constant.index];
+        break;
+    default:
+        expr_result = std::get<double>(literal.value.literal.value());
         break;
     }
 }
@@ -173,110 +159,135 @@ void Interpreter::visit_logical_expr(const Expr::Logical &logical) {
 }
 
 void Interpreter::visit_set_expr(const Expr::Set &set) {
-    LoxObject object = evaluate(set.object);
+    TemporaryRoots roots(*this);
+    LoxObject object = roots.add(evaluate(set.object));
 
-    if (!object.holds_alternative<std::shared_ptr<LoxInstance>>()) {
+    if (!object.holds_alternative<LoxInstance *>()) {
         throw RuntimeError(set.name, "Only instances have fields.");
     }
 
     LoxObject value = evaluate(set.value);
-    object.get<std::shared_ptr<LoxInstance>>()->set(set.name, value);
+    object.get<LoxInstance *>()->set(set.name, value, set.cache);
 
     expr_result = value;
 }
 
 void Interpreter::visit_super_expr(const Expr::Super &expr) {
-    int distance = locals.at(&expr);
-    auto superclass = curr_environment->get_at(std::string("super"), distance)
-                          .get<LoxClass>();
+    auto [depth, slot] = locals.at(&expr);
+    LoxObject object;
+    LoxFunction *method = find_super_method(curr_environment, depth, slot,
+                                            expr.method, object);
+    expr_result = method->bind(object);
+}
 
-    auto object = curr_environment->get_at(std::string("this"), distance - 1);
+void Interpreter::visit_this_expr(const Expr::This &expr) {
+    auto [depth, slot] = locals.at(&expr);
+    expr_result = curr_environment->get_at(depth, slot);
+}
 
-    auto method = superclass->find_method(expr.method.lexeme);
+void Interpreter::visit_unary_expr(const Expr::Unary &unary) {
+    dispatch(*unary.right, *this);
+    expr_result = unary_op(unary.op, expr_result);
+}
 
-    if (method == nullptr) {
-        throw RuntimeError(expr.method,
-                           "Undefined property '" + expr.method.lexeme + "'.");
-    }
-    expr_result = method->bind({"this", object}, environments);
+void Interpreter::visit_call_expr(const Expr::Call &expr) {
+    expr_result = call(expr, false);
 }
 
-void Interpreter::visit_this_expr(const Expr::This &expr) {
-    expr_result = lookup_variable(expr.keyword, &expr);
+void Interpreter::visit_get_expr(const Expr::Get &expr) {
+    LoxObject object = evaluate(expr.object);
+    expr_result = get_instance(expr.name, object)->get(expr.name, expr.cache);
 }
 
-void Interpreter::visit_unary_expr(const Expr::Unary &unary) {
-    unary.right->accept(*this);
-    switch (unary.op.type) {
-    case BANG:
-        expr_result = !static_cast<bool>(expr_result);
+void Interpreter::visit_variable_expr(const Expr::Variable &variable) {
+    expr_result = lookup_variable(variable);
+}
+
+BinarySpecialization Interpreter::specialize(TokenType op,
+                                             const LoxObject &left,
+                                             const LoxObject &right) {
+    if (left.holds_alternative<double>() and
+        right.holds_alternative<double>()) {
+        return BinarySpecialization::NUMBER;
+    }
+    if (op == PLUS and left.holds_alternative<std::string>() and
+        right.holds_alternative<std::string>()) {
+        return BinarySpecialization::STRING;
+    }
+    return BinarySpecialization::GENERIC;
+}
+
+LoxObject Interpreter::call(const Expr::Call &expr, bool in_tail_position) {
+    TemporaryRoots roots(*this);
+
+    LoxObject callee;
+    LoxObject this_object;
+    LoxFunction *method = nullptr;
+    switch (expr.callee->kind) {
+    case ExprKind::GET: {
+        auto &get = static_cast<const Expr::Get &>(*expr.callee);
+        this_object = roots.add(evaluate(get.object));
+        method = find_method(get.name, get.cache, this_object, callee);
+        roots.add(callee);
         break;
-    case MINUS:
-        check_numeric_op(unary.op, expr_result);
-        expr_result = -expr_result.get<double>();
+    }
+    case ExprKind::SUPER: {
+        auto &super = static_cast<const Expr::Super &>(*expr.callee);
+        auto [depth, slot] = locals.at(&super);
+        method = find_super_method(curr_environment, depth, slot,
+                                   super.method, this_object);
         break;
+    }
     default:
+        callee = roots.add(evaluate(expr.callee));
         break;
     }
-}
-
-void Interpreter::visit_call_expr(const Expr::Call &expr) {
-    LoxObject callee = evaluate(expr.callee);
 
     std::vector<LoxObject> arguments;
     for (const auto &argument_expr : expr.arguments) {
-        arguments.push_back(evaluate(argument_expr));
-    }
-    if (not callee.holds_alternative<std::shared_ptr<LoxCallable>>()) {
-        throw RuntimeError(expr.paren, "Can only call functions and classes.");
+        arguments.push_back(roots.add(evaluate(argument_expr)));
     }
-    auto function = callee.get<std::shared_ptr<LoxCallable>>();
 
-    if (arguments.size() != function->arity()) {
-        throw RuntimeError(expr.paren,
-                           "Expected " + std::to_string(function->arity()) +
-                               " arguments but got " +
-                               std::to_string(arguments.size()) + ".");
+    if (method != nullptr) {
+        return call_method(*this, expr.paren, method, this_object,
+                           std::move(arguments), in_tail_position);
     }
-
-    expr_result = function->call(*this, arguments);
+    return call_value(*this, expr.paren, callee, std::move(arguments),
+                      in_tail_position);
 }
 
-void Interpreter::visit_get_expr(const Expr::Get &expr) {
-    LoxObject object = evaluate(expr.object);
-
-    if (not object.holds_alternative<std::shared_ptr<LoxInstance>>()) {
-        throw RuntimeError(expr.name, "Only instances have properties.");
+LoxObject Interpreter::lookup_variable(const Expr::Variable &variable) {
+    // A valid cache means the Resolver found no local of this name.
+    if (variable.global.valid_for(global_table.id())) {
+        return global_table.get(variable.global.slot, variable.name);
     }
-    auto instance = object.get<std::shared_ptr<LoxInstance>>();
-    expr_result = instance->get(expr.name, instance, environments);
-}
-
-void Interpreter::visit_variable_expr(const Expr::Variable &variable) {
-    expr_result = lookup_variable(variable.name, &variable);
+    auto it = locals.find(&variable);
+    if (it == locals.end()) {
+        return global_table.get(global_slot(variable.name, variable.global),
+                                variable.name);
+    }
+    auto [depth, slot] = it->second;
+    return curr_environment->get_at(depth, slot);
 }
 
-void Interpreter::check_numeric_op(const Token &op, const LoxObject &operand) {
-    if (operand.holds_alternative<double>()) {
-        return;
+size_t Interpreter::global_slot(const Token &name, GlobalCache &cache) {
+    if (!cache.valid_for(global_table.id())) {
+        resolve_global(cache, name.lexeme);
     }
-    throw RuntimeError(op, "Operand must be a number.");
+    return cache.slot;
 }
-void Interpreter::check_numeric_op(const Token &op, const LoxObject &left,
-                                   const LoxObject &right) {
-    if (left.holds_alternative<double>() and
-        right.holds_alternative<double>()) {
-        return;
+
+void Interpreter::define(const Token &name, const LoxObject &value) {
+    if (curr_environment == globals()) {
+        global_table.define(name.lexeme, value);
+    } else {
+        curr_environment->assign_at(0, local_slot(name), value);
     }
-    throw RuntimeError(op, "Operands must be numbers.");
 }
 
-LoxObject Interpreter::lookup_variable(const Token &name, const Expr *expr) {
-    if (!locals.contains(expr)) {
-        return globals()->get(name);
-    }
-    int distance = locals.at(expr);
-    return curr_environment->get_at(name, distance);
+void Interpreter::mark_roots(Tracer &tracer) {
+    AbstractInterpreter::mark_roots(tracer);
+    tracer.mark_value(expr_result);
 }
 
 void Interpreter::print_expr_result() {
@@ -284,13 +295,17 @@ void Interpreter::print_expr_result() {
 }
 
 void Interpreter::visit_block_stmt(const Stmt::Block &block) {
+    if (!has_environment(block.statements)) {
+        completion = execute_statements(block.statements);
+        return;
+    }
     Environment *new_environment =
-        environments.add_environment(curr_environment);
-    execute_block(block.statements, new_environment);
+        add_environment(curr_environment, scope_size(block.statements));
+    completion = execute_block(block.statements, new_environment);
 }
 
 void Interpreter::visit_class_stmt(const Stmt::Class &stmt) {
-    std::shared_ptr<LoxClass> superclass = nullptr;
+    LoxClass *superclass = nullptr;
     if (stmt.superclass != nullptr) {
         LoxObject superclass_obj = evaluate(stmt.superclass);
 
@@ -301,28 +316,29 @@ void Interpreter::visit_class_stmt(const Stmt::Class &stmt) {
         superclass = superclass_obj.get<LoxClass>();
     }
 
-    curr_environment->define(stmt.name.lexeme, LoxNull{});
-
     if (stmt.superclass != nullptr) {
-        curr_environment = environments.add_environment(curr_environment);
-        curr_environment->define("super", superclass);
+        curr_environment = add_environment(curr_environment, 1);
+        curr_environment->define(superclass);
     }
 
     LoxClass::MethodMap methods;
     for (const auto &method : stmt.methods) {
-        std::string &method_name = method->name.lexeme;
-        methods[method_name] = std::make_shared<LoxFunction>(
-            *method, curr_environment, method_name == "init");
+        std::string_view method_name = method->name.lexeme;
+        methods[std::string(method_name)] =
+            Heap::instance().allocate<LoxFunction>(
+                *method, curr_environment, scope_size(method->body),
+                method_name == "init");
     }
 
-    std::shared_ptr<LoxCallable> lox_class =
-        std::make_shared<LoxClass>(stmt.name.lexeme, superclass, methods);
+    LoxCallable *lox_class =
+        Heap::instance().allocate<LoxClass>(stmt.name.lexeme, superclass,
+                                            std::move(methods));
 
     if (superclass != nullptr) {
         curr_environment = curr_environment->enclosing;
     }
 
-    curr_environment->assign(stmt.name, lox_class);
+    define(stmt.name, lox_class);
 }
 
 void Interpreter::visit_expression_stmt(const Stmt::Expression &expression) {
@@ -330,17 +346,17 @@ void Interpreter::visit_expression_stmt(const Stmt::Expression &expression) {
 }
 
 void Interpreter::visit_function_stmt(const Stmt::Function &func) {
-    auto function_object =
-        std::make_shared<LoxFunction>(func, curr_environment);
-    curr_environment->define(func.name.lexeme, std::move(function_object));
+    auto function_object = Heap::instance().allocate<LoxFunction>(
+        func, curr_environment, scope_size(func.body));
+    define(func.name, function_object);
 }
 
 void Interpreter::visit_if_stmt(const Stmt::If &stmt) {
     evaluate(stmt.condition);
     if (static_cast<bool>(expr_result)) {
-        execute(stmt.then_branch);
+        completion = execute(stmt.then_branch);
     } else {
-        execute(stmt.else_branch);
+        completion = execute(stmt.else_branch);
     }
 }
 
@@ -351,11 +367,14 @@ void Interpreter::visit_print_stmt(const Stmt::Print &print) {
 
 void Interpreter::visit_return_stmt(const Stmt::Return &stmt) {
     LoxObject value;
-    if (stmt.value != nullptr) {
+    if (is_tail_call(stmt.value)) {
+        value = call(static_cast<const Expr::Call &>(*stmt.value), true);
+    } else if (stmt.value != nullptr) {
         value = evaluate(stmt.value);
     }
 
-    throw Return(value);
+    return_value = value;
+    completion = Completion::RETURN;
 }
 
 void Interpreter::visit_var_stmt(const Stmt::Var &var) {
@@ -365,11 +384,50 @@ void Interpreter::visit_var_stmt(const Stmt::Var &var) {
         value = evaluate(var.initializer);
     }
 
-    curr_environment->define(var.name.lexeme, value);
+    define(var.name, value);
 }
 
 void Interpreter::visit_while_stmt(const Stmt::While &stmt) {
+    if (stmt.counted.has_value() and run_counted_loop(stmt)) {
+        return;
+    }
     while (static_cast<bool>(evaluate(stmt.condition))) {
-        execute(stmt.body);
+        if ((completion = execute(stmt.body)) == Completion::RETURN) {
+            return;
+        }
+        end_iteration();
+    }
+}
+
+bool Interpreter::run_counted_loop(const Stmt::While &stmt) {
+    const CountedLoop &loop = *stmt.counted;
+    auto [depth, slot] = locals.at(loop.counter);
+    LoxObject &counter = curr_environment->get_at(depth, slot);
+    LoxObject limit = evaluate(loop.limit);
+    if (!counter.holds_alternative<double>() or
+        !limit.holds_alternative<double>()) {
+        return false;
+    }
+
+    const auto &body = static_cast<const Stmt::Block &>(*stmt.body).statements;
+    std::span<Stmt *const> statements(body.data(), body.size() - 1);
+    completion = count_loop(
+        loop.comparison, loop.step, counter, limit.get<double>(), [&] {
+            if (!has_environment(body)) {
+                return execute_statements(statements);
+            }
+            EnvironmentScope scope(
+                *this, add_environment(curr_environment, scope_size(body)));
+            return execute_statements(statements);
+        });
+    return true;
+}
+
+Completion Interpreter::execute_statements(std::span<Stmt *const> stmts) {
+    for (const Stmt *stmt : stmts) {
+        if (execute(stmt) == Completion::RETURN) {
+            return Completion::RETURN;
+        }
     }
+    return Completion::NORMAL;
 }
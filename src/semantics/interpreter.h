@@ -2,23 +2,21 @@
 
 #include "src/semantics/abstract_interpreter.h"
 #include "src/semantics/environment.h"
+#include "src/semantics/interpreter_mode.h"
 #include "src/semantics/object/lox_callable.h"
+#include "src/semantics/object/lox_function.h"
 #include "src/semantics/object/lox_object.h"
 #include "src/semantics/object/print_lox_object.h"
 #include "src/semantics/runtime_error.h"
 #include "src/syntactics/expr.h"
 #include "src/syntactics/stmt.h"
 
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <variant>
 #include <vector>
 
-enum class InterpreterMode {
-    FILE,
-    INTERACTIVE,
-};
-
 struct Interpreter final : AbstractInterpreter, ExprVisitor, StmtVisitor {
     using AbstractInterpreter::execute;
 
@@ -26,19 +24,25 @@ struct Interpreter final : AbstractInterpreter, ExprVisitor, StmtVisitor {
 
     template <typename ExprPtr>
     LoxObject evaluate(const ExprPtr &expr) {
-        expr->accept(*this);
+        dispatch(*expr, *this);
         return expr_result;
     }
 
-    void execute(const Stmt *stmt) override;
+    Completion execute(const Stmt *stmt) override;
 
-    void interpret(const std::vector<std::shared_ptr<Stmt>> &stmts,
+    void interpret(const std::pmr::vector<Stmt *> &stmts,
                    InterpreterMode mode = InterpreterMode::FILE);
 
     bool had_runtime_error() const;
     void reset_runtime_error();
 
   private:
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
     void visit_assign_expr(const Expr::Assign &assign) override;
     void visit_binary_expr(const Expr::Binary &binary) override;
     void visit_call_expr(const Expr::Call &expr) override;
@@ -63,14 +67,32 @@ struct Interpreter final : AbstractInterpreter, ExprVisitor, StmtVisitor {
     void visit_var_stmt(const Stmt::Var &var) override;
     void visit_while_stmt(const Stmt::While &stmt) override;
 
-    static void check_numeric_op(const Token &op, const LoxObject &operand);
-    static void check_numeric_op(const Token &op, const LoxObject &left,
-                                 const LoxObject &right);
+    // The specialisation for a Binary node's first operands.
+    static BinarySpecialization specialize(TokenType op, const LoxObject &left,
+                                           const LoxObject &right);
+    // Runs a loop the Optimizer found to count, unless its counter or limit
+    // is not a number, in which case it returns false for the loop to run as
+    // written.
+    bool run_counted_loop(const Stmt::While &stmt);
+    // Runs `stmts` in the current environment.
+    Completion execute_statements(std::span<Stmt *const> stmts);
+    // Makes `expr`, or from tail position leaves it to the function
+    // returning, see LoxFunction::tail_call().
+    LoxObject call(const Expr::Call &expr, bool in_tail_position);
 
-    LoxObject lookup_variable(const Token &name, const Expr *expr);
+    LoxObject lookup_variable(const Expr::Variable &variable);
+    // The slot of a global the Resolver did not see, which is then cached.
+    size_t global_slot(const Token &name, GlobalCache &cache);
+    // Declares a variable in the current environment: in the global table at
+    // the top level, in the next free slot otherwise.
+    void define(const Token &name, const LoxObject &value);
 
     void print_expr_result();
 
+    void mark_roots(Tracer &tracer) override;
+
     LoxObject expr_result;
+    // Set by statements that complete abnormally, handed back by execute().
+    Completion completion;
     bool m_had_runtime_error;
 };
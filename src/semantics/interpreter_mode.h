@@ -0,0 +1,6 @@
+#pragma once
+
+enum class InterpreterMode {
+    FILE,
+    INTERACTIVE,
+};
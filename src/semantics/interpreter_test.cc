@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/interpreter.h"
+#include "src/semantics/resolver.h"
+#include "src/semantics/testing.h"
+#include "src/syntactics/parser.h"
+#include "src/syntactics/scanner.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The Binary node of a statement `print a <op> b;`.
+const Expr::Binary &printed_binary(const RunResult &result, size_t index) {
+    auto &print = dynamic_cast<const Stmt::Print &>(
+        *result.program.statements.at(index));
+    return dynamic_cast<const Expr::Binary &>(*print.expression);
+}
+
+} // namespace
+
+TEST(InterpreterTest, BinaryNodesSpecialiseOnFirstOperands) {
+    RunResult result = run<Interpreter>(R"(
+        print 1 + 2;
+        print "a" + "b";
+        print 1 < 2;
+        print nil == nil;
+        if (false) print 1 - 2;
+    )");
+    EXPECT_EQ(result.output, "3\nab\ntrue\ntrue\n");
+    EXPECT_EQ(printed_binary(result, 0).specialization,
+              BinarySpecialization::NUMBER);
+    EXPECT_EQ(printed_binary(result, 1).specialization,
+              BinarySpecialization::STRING);
+    EXPECT_EQ(printed_binary(result, 2).specialization,
+              BinarySpecialization::NUMBER);
+    EXPECT_EQ(printed_binary(result, 3).specialization,
+              BinarySpecialization::GENERIC);
+}
+
+TEST(InterpreterTest, FailedGuardFallsBackToGeneric) {
+    RunResult result = run<Interpreter>(R"(
+        fun add(a, b) { return a + b; }
+        for (var i = 0; i < 3; i = i + 1) print add(i, 1);
+        print add("a", "b");
+        print add(1, 1);
+        print add(1, "b");
+    )");
+    EXPECT_EQ(result.output,
+              "1\n2\n3\nab\n2\n"
+              "[line 2] Error: Operands must be two numbers or two strings.\n");
+
+    auto &add = dynamic_cast<const Stmt::Function &>(
+        *result.program.statements.at(0));
+    auto &ret = dynamic_cast<const Stmt::Return &>(*add.body.at(0));
+    EXPECT_EQ(dynamic_cast<const Expr::Binary &>(*ret.value).specialization,
+              BinarySpecialization::GENERIC);
+}
+
+TEST(InterpreterTest, ForgottenDeclarationsCanBeFreed) {
+    CapturedOutput output;
+
+    // Runs each declaration as it is parsed and frees the ones that declare
+    // no functions, so that later ones may reuse their memory.
+    Parser parser(Scanner(std::stringstream{R"(
+        var total = 0;
+        fun add(n) { total = total + n; }
+        for (var i = 0; i < 3; i = i + 1) { var j = i * 2; add(j); }
+        { var k = total; print k; }
+        for (var i = 0; i < 2; i = i + 1) print total + i;
+        print add;
+    )"}));
+    Interpreter interpreter;
+    std::vector<Program> kept;
+    while (auto program = parser.parse_declaration()) {
+        Resolver{interpreter}.resolve(program->statements);
+        interpreter.interpret(program->statements);
+        if (program->declares_functions) {
+            kept.push_back(std::move(*program));
+        } else {
+            interpreter.forget(program->statements);
+        }
+    }
+
+    EXPECT_FALSE(parser.had_error());
+    EXPECT_EQ(kept.size(), 1);
+    EXPECT_EQ(output.str(), "6\n6\n7\n<fun add>\n");
+}
+
+TEST(InterpreterTest, TailCallsDoNotGrowTheStack) {
+    // Each of these would need far more native stack than a thread has if
+    // every call kept the frame of its caller.
+    RunResult result = run<Interpreter>(R"(
+        fun count(n, total) {
+            if (n == 0) return total;
+            return count(n - 1, total + 1);
+        }
+        print count(1000000, 0);
+        fun even(n) { if (n == 0) return true; return odd(n - 1); }
+        fun odd(n) { if (n == 0) return false; return even(n - 1); }
+        print even(300001);
+        class Countdown {
+            init() { this.steps = 0; }
+            run(n) {
+                if (n == 0) return this.steps;
+                this.steps = this.steps + 1;
+                return this.run(n - 1);
+            }
+        }
+        class Twice < Countdown { twice(n) { return super.run(2 * n); } }
+        print Twice().twice(150000);
+        fun make(x) { return Countdown(); }
+        print make(1).steps;
+        class Bound {
+            go(n) {
+                if (n == 0) return "bound";
+                var next = this.go;
+                return next(n - 1);
+            }
+        }
+        print Bound().go(300000);
+    )");
+    EXPECT_EQ(result.output, "1e+06\nfalse\n300000\n0\nbound\n");
+}
@@ -6,9 +6,9 @@
 #include <chrono>
 #include <sstream>
 
-const std::vector<std::pair<std::string, LoxObject>> natives{
-    {"clock", LoxObject(std::make_shared<ClockFun>())},
-    {"string", LoxObject(std::make_shared<ToStringFun>())},
+const Natives natives{
+    {"clock", LoxObject(Heap::instance().allocate<ClockFun>())},
+    {"string", LoxObject(Heap::instance().allocate<ToStringFun>())},
 };
 
 std::string ClockFun::to_string() const { return "<native fn>"; }
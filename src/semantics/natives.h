@@ -5,7 +5,7 @@
 #include <string>
 #include <utility>
 
-extern const std::vector<std::pair<std::string, LoxObject>> natives;
+extern const Natives natives;
 
 struct ClockFun final : LoxCallable {
     std::string to_string() const override;
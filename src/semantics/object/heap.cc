@@ -0,0 +1,45 @@
+#include "src/semantics/object/heap.h"
+
+Heap::Heap() : objects(nullptr), object_count(0) {}
+
+Heap::~Heap() {
+    HeapObject *object = objects;
+    while (object != nullptr) {
+        HeapObject *next = object->next_object;
+        delete object;
+        object = next;
+    }
+}
+
+Heap &Heap::instance() {
+    static Heap heap;
+    return heap;
+}
+
+size_t Heap::size() const { return object_count; }
+
+size_t Heap::sweep() {
+    size_t freed = 0;
+    HeapObject *previous = nullptr;
+    HeapObject *object = objects;
+    while (object != nullptr) {
+        if (object->is_marked) {
+            object->is_marked = false;
+            previous = object;
+            object = object->next_object;
+            continue;
+        }
+
+        HeapObject *unreached = object;
+        object = object->next_object;
+        if (previous != nullptr) {
+            previous->next_object = object;
+        } else {
+            objects = object;
+        }
+        delete unreached;
+        ++freed;
+    }
+    object_count -= freed;
+    return freed;
+}
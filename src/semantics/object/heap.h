@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+struct Environment;
+struct HeapObject;
+struct LoxObject;
+
+// Visits the references of the objects reached during a collection.
+struct Tracer {
+    virtual ~Tracer() = default;
+
+    virtual void mark_object(const HeapObject *object) = 0;
+    virtual void mark_value(const LoxObject &value) = 0;
+    virtual void mark_environment(Environment *environment) = 0;
+};
+
+// Base of every runtime object a LoxObject can refer to: strings, callables
+// and instances.
+struct HeapObject {
+    HeapObject() = default;
+    HeapObject(const HeapObject &) = delete;
+    HeapObject &operator=(const HeapObject &) = delete;
+
+    virtual ~HeapObject() = default;
+
+    // Reports every object and environment this object refers to.
+    virtual void trace(Tracer &tracer) const {}
+
+    mutable bool is_marked = false;
+
+  private:
+    friend struct Heap;
+
+    // Intrusive list of every object owned by the heap.
+    HeapObject *next_object = nullptr;
+};
+
+// Owns every HeapObject. LoxObject only stores a tagged pointer, so copying a
+// value never touches a reference count; the heap releases the objects when
+// a collection finds them unreachable, or at exit.
+//
+// The heap is shared by every interpreter in the process, so only one
+// interpreter may be alive at a time; see AbstractInterpreter.
+struct Heap {
+    static Heap &instance();
+
+    Heap(const Heap &) = delete;
+    Heap &operator=(const Heap &) = delete;
+    ~Heap();
+
+    template <typename T, typename... Args>
+    T *allocate(Args &&...args) {
+        T *object = new T(std::forward<Args>(args)...);
+        object->next_object = objects;
+        objects = object;
+        ++object_count;
+        return object;
+    }
+
+    size_t size() const;
+
+    // Frees every unmarked object and unmarks the survivors. Returns the
+    // number of objects freed.
+    size_t sweep();
+
+  private:
+    Heap();
+
+    HeapObject *objects;
+    size_t object_count;
+};
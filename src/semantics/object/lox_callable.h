@@ -1,6 +1,7 @@
 #pragma once
 
 #include "src/semantics/abstract_interpreter.h"
+#include "src/semantics/object/heap.h"
 #include "src/semantics/object/lox_callable.fwd.h"
 
 #include <memory>
@@ -8,7 +9,7 @@
 
 struct LoxObject;
 
-struct LoxCallable {
+struct LoxCallable : HeapObject {
     virtual ~LoxCallable() = default;
 
     virtual std::string to_string() const = 0;
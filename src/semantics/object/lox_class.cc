@@ -2,39 +2,47 @@
 
 #include "src/semantics/object/lox_instance.h"
 
-LoxClass::LoxClass(std::string name, std::shared_ptr<LoxClass> superclass,
+LoxClass::LoxClass(std::string_view name, LoxClass *superclass,
                    LoxClass::MethodMap methods)
-    : name(std::move(name)), superclass(std::move(superclass)),
-      methods(std::move(methods)) {}
-
-std::shared_ptr<LoxFunction>
-LoxClass::find_method(const std::string &name) const {
-    if (methods.contains(name)) {
-        return methods.at(name);
-    }
-
+    : name(name), superclass(superclass),
+      methods(std::move(methods)), m_root_shape(std::make_unique<Shape>()) {
     if (superclass != nullptr) {
-        return superclass->find_method(name);
+        // Methods of this class override the inherited ones.
+        this->methods.insert(superclass->methods.begin(),
+                             superclass->methods.end());
     }
+}
 
-    return nullptr;
+LoxFunction *LoxClass::find_method(std::string_view name) const {
+    auto it = methods.find(name);
+    return it != methods.end() ? it->second : nullptr;
 }
 
+Shape *LoxClass::root_shape() const { return m_root_shape.get(); }
+
 std::string LoxClass::to_string() const { return name; }
 
 LoxObject LoxClass::call(AbstractInterpreter &interpreter,
                          const std::vector<LoxObject> &arguments) {
-    LoxObject instance(std::make_shared<LoxInstance>(this));
+    TemporaryRoots roots(interpreter);
+    LoxObject instance =
+        roots.add(Heap::instance().allocate<LoxInstance>(this));
 
     auto initializer = find_method("init");
     if (initializer) {
-        initializer->bind({"this", instance}, interpreter.environments)
-            ->call(interpreter, arguments);
+        initializer->call_method(interpreter, instance, arguments);
     }
 
     return instance;
 }
 
+void LoxClass::trace(Tracer &tracer) const {
+    tracer.mark_object(superclass);
+    for (const auto &[name, method] : methods) {
+        tracer.mark_object(method);
+    }
+}
+
 size_t LoxClass::arity() const {
     auto initializer = find_method("init");
     if (initializer) {
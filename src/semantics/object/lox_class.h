@@ -5,20 +5,25 @@
 #include "src/semantics/object/lox_callable.h"
 #include "src/semantics/object/lox_function.h"
 #include "src/semantics/object/lox_instance.fwd.h"
+#include "src/semantics/object/shape.h"
+#include "src/tp_utils.h"
 
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 struct LoxClass final : LoxCallable {
-    using MethodMap =
-        std::unordered_map<std::string, std::shared_ptr<LoxFunction>>;
+    using MethodMap = StringMap<LoxFunction *>;
 
-    LoxClass(std::string name, std::shared_ptr<LoxClass> superclass,
-             MethodMap methods);
+    LoxClass(std::string_view name, LoxClass *superclass, MethodMap methods);
 
-    std::shared_ptr<LoxFunction> find_method(const std::string &name) const;
+    // Also finds inherited methods, which the constructor copies in from the
+    // superclass so no lookup walks the class chain.
+    LoxFunction *find_method(std::string_view name) const;
+
+    // The shape of a new instance of this class.
+    Shape *root_shape() const;
 
     std::string to_string() const override;
 
@@ -27,8 +32,11 @@ struct LoxClass final : LoxCallable {
 
     size_t arity() const;
 
+    void trace(Tracer &tracer) const override;
+
   private:
     std::string name;
-    std::shared_ptr<LoxClass> superclass;
+    LoxClass *superclass;
     MethodMap methods;
+    std::unique_ptr<Shape> m_root_shape;
 };
\ No newline at end of file
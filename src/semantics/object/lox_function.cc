@@ -3,26 +3,32 @@
 #include "src/semantics/abstract_interpreter.h"
 #include "src/semantics/environment.h"
 #include "src/semantics/object/lox_object.h"
-#include "src/semantics/return.h"
 
-LoxFunction::LoxFunction(Token name, std::vector<Token> params,
-                         std::vector<std::shared_ptr<Stmt>> body,
-                         Environment *closure, bool is_initializer)
-    : identifier(std::move(name)), params(std::move(params)),
-      body(std::move(body)), closure(closure), is_initializer(is_initializer) {}
+#include <optional>
+#include <utility>
+
+LoxFunction::LoxFunction(const Token &identifier,
+                         const std::pmr::vector<Token> &params,
+                         const std::pmr::vector<Stmt *> &body,
+                         Environment *closure, size_t slot_count,
+                         bool is_initializer)
+    : identifier(identifier), params(params), body(body), closure(closure),
+      slot_count(slot_count), is_initializer(is_initializer) {}
 
 LoxFunction::LoxFunction(const Stmt::Function &declaration,
-                         Environment *closure, bool is_initializer)
+                         Environment *closure, size_t slot_count,
+                         bool is_initializer)
     : LoxFunction(declaration.name, declaration.params, declaration.body,
-                  closure, is_initializer) {}
+                  closure, slot_count, is_initializer) {}
 
-LoxFunction::LoxFunction(const Expr::Lambda &declaration, Environment *closure)
+LoxFunction::LoxFunction(const Expr::Lambda &declaration, Environment *closure,
+                         size_t slot_count)
     : LoxFunction(declaration.keyword, declaration.params, declaration.body,
-                  closure) {}
+                  closure, slot_count) {}
 
 std::string LoxFunction::to_string() const {
     if (identifier.type == IDENTIFIER) {
-        return "<fun " + identifier.lexeme + ">";
+        return "<fun " + std::string(identifier.lexeme) + ">";
     } else {
         return "<anonymous function>";
     }
@@ -30,27 +36,75 @@ std::string LoxFunction::to_string() const {
 
 LoxObject LoxFunction::call(AbstractInterpreter &interpreter,
                             const std::vector<LoxObject> &arguments) {
-    Environment *func_environment =
-        interpreter.environments.add_environment(closure);
-    for (size_t i = 0; i < params.size(); ++i) {
-        func_environment->define(params[i].lexeme, arguments[i]);
+    return invoke(interpreter, nullptr, arguments);
+}
+
+LoxObject LoxFunction::call_method(AbstractInterpreter &interpreter,
+                                   const LoxObject &this_object,
+                                   const std::vector<LoxObject> &arguments) {
+    return invoke(interpreter, &this_object, arguments);
+}
+
+LoxObject LoxFunction::tail_call(AbstractInterpreter &interpreter,
+                                 const LoxObject *this_object,
+                                 std::vector<LoxObject> arguments) {
+    std::optional<LoxObject> receiver;
+    if (this_object != nullptr) {
+        receiver = *this_object;
     }
+    interpreter.tail_call =
+        TailCall{LoxObject(this), receiver, std::move(arguments)};
+    return LoxObject{};
+}
 
-    Environment *previous_environment = interpreter.curr_environment;
-    try {
-        interpreter.execute_block(body, func_environment);
-    } catch (const Return &return_value) {
-        interpreter.curr_environment = previous_environment;
+LoxObject LoxFunction::invoke(AbstractInterpreter &interpreter,
+                              const LoxObject *this_object,
+                              const std::vector<LoxObject> &arguments) {
+    LoxObject result = run(interpreter, this_object, arguments);
+    // Each call in tail position is made here after the one making it has
+    // returned, rather than inside it.
+    while (interpreter.tail_call.has_value()) {
+        TailCall call = std::move(*interpreter.tail_call);
+        interpreter.tail_call.reset();
 
-        if (is_initializer) {
-            std::cout << "this" << std::endl;
-            return closure->get_at(std::string("this"), 0);
+        TemporaryRoots roots(interpreter);
+        roots.add(call.function);
+        if (call.this_object.has_value()) {
+            roots.add(*call.this_object);
+        }
+        for (const LoxObject &argument : call.arguments) {
+            roots.add(argument);
         }
-        return return_value.return_value;
+        auto function =
+            static_cast<LoxFunction *>(call.function.get<LoxCallable *>());
+        result = function->run(interpreter,
+                               call.this_object.has_value()
+                                   ? &*call.this_object
+                                   : nullptr,
+                               call.arguments);
+    }
+    return result;
+}
+
+LoxObject LoxFunction::run(AbstractInterpreter &interpreter,
+                           const LoxObject *this_object,
+                           const std::vector<LoxObject> &arguments) {
+    Environment *func_environment =
+        interpreter.add_environment(closure, slot_count);
+    if (this_object != nullptr) {
+        func_environment->define(*this_object);
+    }
+    for (const auto &argument : arguments) {
+        func_environment->define(argument);
     }
 
+    Completion completion = interpreter.execute_block(body, func_environment);
+
     if (is_initializer) {
-        return closure->get_at(std::string("this"), 0);
+        return *this_object;
+    }
+    if (completion == Completion::RETURN) {
+        return std::exchange(interpreter.return_value, LoxObject{});
     }
 
     return LoxObject{};
@@ -58,12 +112,32 @@ LoxObject LoxFunction::call(AbstractInterpreter &interpreter,
 
 size_t LoxFunction::arity() const { return params.size(); }
 
-std::shared_ptr<LoxFunction>
-LoxFunction::bind(const std::pair<std::string, LoxObject> &to_bind,
-                  EnvironmentTree &envs) {
-    Environment *new_enviroment = envs.add_environment(closure);
-    auto [name, object] = to_bind;
-    new_enviroment->define(name, object);
-    return std::make_shared<LoxFunction>(identifier, params, body,
-                                         new_enviroment, is_initializer);
+void LoxFunction::trace(Tracer &tracer) const {
+    tracer.mark_environment(closure);
+}
+
+LoxCallable *LoxFunction::bind(const LoxObject &this_object) {
+    return Heap::instance().allocate<LoxBoundMethod>(this_object, this);
+}
+
+LoxBoundMethod::LoxBoundMethod(LoxObject this_object, LoxFunction *method)
+    : this_object(this_object), method(method) {}
+
+std::string LoxBoundMethod::to_string() const { return method->to_string(); }
+
+LoxObject LoxBoundMethod::call(AbstractInterpreter &interpreter,
+                               const std::vector<LoxObject> &arguments) {
+    return method->call_method(interpreter, this_object, arguments);
+}
+
+size_t LoxBoundMethod::arity() const { return method->arity(); }
+
+void LoxBoundMethod::trace(Tracer &tracer) const {
+    tracer.mark_value(this_object);
+    tracer.mark_object(method);
+}
+
+LoxObject LoxBoundMethod::tail_call(AbstractInterpreter &interpreter,
+                                    std::vector<LoxObject> arguments) {
+    return method->tail_call(interpreter, &this_object, std::move(arguments));
 }
@@ -1,33 +1,81 @@
 #pragma once
 
 #include "src/semantics/object/lox_callable.h"
+#include "src/semantics/object/lox_object.h"
 #include "src/syntactics/stmt.h"
-#include <memory>
+#include <vector>
 
 struct LoxFunction final : LoxCallable {
-    LoxFunction(Token name, std::vector<Token> params,
-                std::vector<std::shared_ptr<Stmt>> body, Environment *closure,
-                bool is_initializer = false);
+    LoxFunction(const Token &identifier, const std::pmr::vector<Token> &params,
+                const std::pmr::vector<Stmt *> &body, Environment *closure,
+                size_t slot_count, bool is_initializer = false);
     LoxFunction(const Stmt::Function &declaration, Environment *closure,
-                bool is_initializer = false);
-    LoxFunction(const Expr::Lambda &declaration, Environment *closure);
+                size_t slot_count, bool is_initializer = false);
+    LoxFunction(const Expr::Lambda &declaration, Environment *closure,
+                size_t slot_count);
 
     std::string to_string() const override;
     LoxObject call(AbstractInterpreter &interpreter,
                    const std::vector<LoxObject> &arguments) override;
     size_t arity() const;
 
-    // Todo: add option to bind more than one objects.
-    std::shared_ptr<LoxFunction>
-    bind(const std::pair<std::string, LoxObject> &to_bind,
-         EnvironmentTree &envs);
+    void trace(Tracer &tracer) const override;
+
+    // Calls this function as a method of `this_object`, which goes in slot 0
+    // of the call frame, where the Resolver expects "this".
+    LoxObject call_method(AbstractInterpreter &interpreter,
+                          const LoxObject &this_object,
+                          const std::vector<LoxObject> &arguments);
+
+    // Materialises this method as a first-class value. Only needed when the
+    // method is not called right away.
+    LoxCallable *bind(const LoxObject &this_object);
+
+    // Calls this function, as a method of `this_object` if not nullptr, from
+    // tail position: leaves the call to the invoke() that the function making
+    // it was called through, which makes it once the return being completed
+    // gets there. Tail recursion so runs in constant C++ stack. Returns nil,
+    // the value of the expression until then.
+    LoxObject tail_call(AbstractInterpreter &interpreter,
+                        const LoxObject *this_object,
+                        std::vector<LoxObject> arguments);
 
   private:
+    LoxObject invoke(AbstractInterpreter &interpreter,
+                     const LoxObject *this_object,
+                     const std::vector<LoxObject> &arguments);
+    // Runs the body once, in a new environment.
+    LoxObject run(AbstractInterpreter &interpreter,
+                  const LoxObject *this_object,
+                  const std::vector<LoxObject> &arguments);
+
     // If named, this is the name of the function. Otherwise, it is the keyword
-    // "fun".
-    Token identifier;
-    std::vector<Token> params;
-    std::vector<std::shared_ptr<Stmt>> body;
+    // "fun". Like `params` and `body`, it belongs to the declaration.
+    const Token &identifier;
+    const std::pmr::vector<Token> &params;
+    const std::pmr::vector<Stmt *> &body;
     Environment *closure;
+    // Parameters and locals declared directly in the body.
+    size_t slot_count;
     bool is_initializer;
 };
+
+// A method together with the instance it was accessed on.
+struct LoxBoundMethod final : LoxCallable {
+    LoxBoundMethod(LoxObject this_object, LoxFunction *method);
+
+    std::string to_string() const override;
+    LoxObject call(AbstractInterpreter &interpreter,
+                   const std::vector<LoxObject> &arguments) override;
+    size_t arity() const;
+
+    void trace(Tracer &tracer) const override;
+
+    // Calls the method from tail position, see LoxFunction::tail_call().
+    LoxObject tail_call(AbstractInterpreter &interpreter,
+                        std::vector<LoxObject> arguments);
+
+  private:
+    LoxObject this_object;
+    LoxFunction *method;
+};
@@ -3,29 +3,70 @@
 #include "src/semantics/object/lox_function.h"
 #include "src/semantics/runtime_error.h"
 
-LoxInstance::LoxInstance(const LoxClass *lclass) : lclass(lclass), fields() {}
+LoxInstance::LoxInstance(const LoxClass *lclass)
+    : lclass(lclass), shape(lclass->root_shape()), fields() {}
 
 std::string LoxInstance::to_string() const {
     return lclass->to_string() + " instance";
 }
 
-LoxObject LoxInstance::get(Token name,
-                           const std::shared_ptr<LoxInstance> &this_bind,
-                           EnvironmentTree &envs) const {
+LoxObject LoxInstance::get(const Token &name, PropertyCache &cache) {
+    const PropertyCache::Entry &entry = lookup(name, cache);
+    if (entry.method != nullptr) {
+        return entry.method->bind(this);
+    }
+    return fields[entry.slot];
+}
+
+LoxFunction *LoxInstance::get_method(const Token &name, PropertyCache &cache) {
+    return lookup(name, cache).method;
+}
+
+const PropertyCache::Entry &LoxInstance::lookup(const Token &name,
+                                                PropertyCache &cache) {
+    const PropertyCache::Entry *entry = cache.find(shape->id());
+    if (entry != nullptr) {
+        return *entry;
+    }
+
     // Fields shadow methods.
-    if (fields.contains(name.lexeme)) {
-        return fields.at(name.lexeme);
+    if (auto slot = shape->slot(name.lexeme)) {
+        cache.add({shape->id(), slot.value(), nullptr, nullptr});
+    } else if (auto method = lclass->find_method(name.lexeme)) {
+        cache.add({shape->id(), 0, method, nullptr});
+    } else {
+        throw RuntimeError(name, "Undefined property '" +
+                                     std::string(name.lexeme) + "'.");
     }
+    return *cache.find(shape->id());
+}
 
-    if (auto method = lclass->find_method(name.lexeme)) {
-        return method->bind({"this", this_bind}, envs);
+void LoxInstance::set(const Token &name, const LoxObject &value,
+                      PropertyCache &cache) {
+    const PropertyCache::Entry *entry = cache.find(shape->id());
+    if (entry == nullptr) {
+        if (auto slot = shape->slot(name.lexeme)) {
+            cache.add({shape->id(), slot.value(), nullptr, nullptr});
+        } else {
+            cache.add({shape->id(), shape->size(), nullptr,
+                       shape->add_field(name.lexeme)});
+        }
+        entry = cache.find(shape->id());
     }
 
-    throw RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
+    if (entry->transition != nullptr) {
+        shape = entry->transition;
+        fields.push_back(value);
+    } else {
+        fields[entry->slot] = value;
+    }
 }
 
-void LoxInstance::set(Token name, const LoxObject &value) {
-    fields[name.lexeme] = value;
+void LoxInstance::trace(Tracer &tracer) const {
+    tracer.mark_object(lclass);
+    for (const auto &value : fields) {
+        tracer.mark_value(value);
+    }
 }
 
 std::ostream &operator<<(std::ostream &os, const LoxInstance &callable) {
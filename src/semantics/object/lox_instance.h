@@ -2,25 +2,38 @@
 
 #include "src/semantics/object/lox_instance.fwd.h"
 
+#include "src/semantics/object/heap.h"
 #include "src/semantics/object/lox_class.h"
 #include "src/semantics/object/lox_object.h"
+#include "src/semantics/object/shape.h"
+#include "src/syntactics/property_cache.h"
 #include "src/syntactics/token.h"
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 
-struct LoxInstance {
+struct LoxInstance final : HeapObject {
     LoxInstance(const LoxClass *lclass);
 
     std::string to_string() const;
 
-    LoxObject get(Token name, const std::shared_ptr<LoxInstance> &this_bind,
-                  EnvironmentTree &envs) const;
-    void set(Token name, const LoxObject &value);
+    // `cache` is the inline cache of the property access being evaluated;
+    // it is consulted first and updated on a miss.
+    LoxObject get(const Token &name, PropertyCache &cache);
+    // The method `name` refers to, unbound, or nullptr if it is a field.
+    LoxFunction *get_method(const Token &name, PropertyCache &cache);
+    void set(const Token &name, const LoxObject &value, PropertyCache &cache);
+
+    void trace(Tracer &tracer) const override;
 
   private:
+    const PropertyCache::Entry &lookup(const Token &name,
+                                       PropertyCache &cache);
+
     const LoxClass *lclass;
-    std::unordered_map<std::string, LoxObject> fields;
+    Shape *shape;
+    // Indexed by the slots of `shape`.
+    std::vector<LoxObject> fields;
 };
 
 std::ostream &operator<<(std::ostream &os, const LoxInstance &callable);
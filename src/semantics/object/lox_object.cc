@@ -2,6 +2,8 @@
 
 #include "src/tp_utils.h"
 
+#include <cmath>
+
 LoxNull::operator bool() const { return false; }
 
 bool LoxNull::operator=(const LoxNull &other) const { return true; };
@@ -11,29 +13,92 @@ std::ostream &operator<<(std::ostream &os, const LoxNull &null) {
     return os << "null";
 }
 
-LoxObject::LoxObject(LoxObjectT object) : object(std::move(object)) {}
+LoxString::LoxString(std::string value) : value(std::move(value)) {}
+
+LoxObject::LoxObject() : bits(NIL_BITS) {}
+
+LoxObject::LoxObject(LoxNull) : bits(NIL_BITS) {}
+
+LoxObject::LoxObject(bool boolean) : bits(boolean ? TRUE_BITS : FALSE_BITS) {}
+
+LoxObject::LoxObject(double number) : bits(std::bit_cast<uint64_t>(number)) {
+    if ((bits & QNAN) == QNAN) {
+        bits = (bits & SIGN_BIT) | CANONICAL_NAN;
+    }
+}
+
+LoxObject::LoxObject(std::string string)
+    : bits(box(Heap::instance().allocate<LoxString>(std::move(string)),
+               STRING_TAG)) {}
+
+LoxObject::LoxObject(const char *string) : LoxObject(std::string(string)) {}
+
+LoxObject::LoxObject(LoxCallable *callable)
+    : bits(box(callable, CALLABLE_TAG)) {}
+
+LoxObject::LoxObject(LoxInstance *instance)
+    : bits(box(instance, INSTANCE_TAG)) {}
+
+LoxObject::LoxObject(const LoxObjectT &object)
+    : LoxObject(std::visit([](const auto &x) { return LoxObject(x); }, object)) {
+}
 
 LoxObject::LoxObject(TokenLiteral token_literal)
-    : object(variant_cast(std::move(token_literal))) {}
+    : LoxObject(std::visit(overloaded{
+                               [](double number) { return LoxObject(number); },
+                               [](std::string_view string) {
+                                   return LoxObject(std::string(string));
+                               },
+                           },
+                           token_literal)) {}
 
-LoxObject::operator LoxObjectT() const { return object; }
+LoxObject::operator LoxObjectT() const {
+    if (holds_alternative<double>()) {
+        return get<double>();
+    }
+    if (holds_alternative<bool>()) {
+        return get<bool>();
+    }
+    if (holds_alternative<std::string>()) {
+        return get<std::string>();
+    }
+    if (holds_alternative<LoxCallable *>()) {
+        return get<LoxCallable *>();
+    }
+    if (holds_alternative<LoxInstance *>()) {
+        return get<LoxInstance *>();
+    }
+    return LoxNull{};
+}
+
+const HeapObject *LoxObject::heap_object() const {
+    if ((bits & POINTER_BITS) != POINTER_BITS) {
+        return nullptr;
+    }
+    // HeapObject is the only base of every heap type, so it shares their
+    // address.
+    return pointer<HeapObject>();
+}
 
 LoxObject::operator bool() const {
-    return std::visit(overloaded{
-                          [](const std::shared_ptr<LoxCallable> &ptr) {
-                              return ptr != nullptr;
-                          },
-                          [](const std::shared_ptr<LoxInstance> &ptr) {
-                              return ptr != nullptr;
-                          },
-                          [](const std::string &x) { return !x.empty(); },
-                          [](auto x) -> bool { return x; },
-                      },
-                      object);
+    if (holds_alternative<double>()) {
+        return static_cast<bool>(get<double>());
+    }
+    if (holds_alternative<std::string>()) {
+        return !get<std::string>().empty();
+    }
+    return bits != NIL_BITS and bits != FALSE_BITS;
 }
 
 bool LoxObject::operator==(const LoxObject &other) const {
-    return object == other.object;
+    if (holds_alternative<double>() and other.holds_alternative<double>()) {
+        return get<double>() == other.get<double>();
+    }
+    if (holds_alternative<std::string>() and
+        other.holds_alternative<std::string>()) {
+        return get<std::string>() == other.get<std::string>();
+    }
+    return bits == other.bits;
 }
 
 std::partial_ordering LoxObject::operator<=>(const LoxObject &other) const {
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "src/semantics/object/heap.h"
 #include "src/semantics/object/lox_callable.fwd.h"
 #include "src/semantics/object/lox_instance.fwd.h"
 #include "src/syntactics/token.h"
 #include "src/tp_utils.h"
 
+#include <bit>
 #include <compare>
 #include <concepts>
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <vector>
@@ -19,61 +22,115 @@ struct LoxNull {
 
 std::ostream &operator<<(std::ostream &os, const LoxNull &null);
 
+struct LoxString final : HeapObject {
+    explicit LoxString(std::string value);
+
+    std::string value;
+};
+
+// A NaN-boxed value: doubles are stored as themselves, every other
+// alternative lives in the payload of a quiet NaN. The few NaNs that would
+// read as one of those keep only their sign. Strings, callables and
+// instances are pointers into the Heap, tagged in their low (alignment)
+// bits, so a LoxObject is 8 bytes and copying it is a register move.
 struct LoxObject {
-    // TODO: Change shared_ptr to unique_ptr.
     using LoxObjectT = std::variant<LoxNull, bool, double, std::string,
-                                    std::shared_ptr<LoxCallable>,
-                                    std::shared_ptr<LoxInstance>>;
+                                    LoxCallable *, LoxInstance *>;
 
-    LoxObject() = default;
-    LoxObject(LoxObjectT object);
+    LoxObject();
+    LoxObject(LoxNull);
+    LoxObject(bool boolean);
+    LoxObject(double number);
+    LoxObject(std::string string);
+    LoxObject(const char *string);
+    LoxObject(LoxCallable *callable);
+    LoxObject(LoxInstance *instance);
+    LoxObject(const LoxObjectT &object);
     LoxObject(TokenLiteral token_literal);
-    template <typename T>
-    LoxObject(T x) : object(std::move(x)) {}
 
     operator LoxObjectT() const;
 
     template <class T>
-    T &get() {
-        return std::get<T>(object);
-    }
-    template <class T>
-    const T &get() const {
-        return std::get<T>(object);
+    bool holds_alternative() const {
+        if constexpr (std::same_as<T, LoxNull>) {
+            return bits == NIL_BITS;
+        } else if constexpr (std::same_as<T, bool>) {
+            return (bits | 1) == TRUE_BITS;
+        } else if constexpr (std::same_as<T, double>) {
+            return (bits & QNAN) != QNAN;
+        } else if constexpr (std::same_as<T, std::string>) {
+            return is_pointer(STRING_TAG);
+        } else if constexpr (std::same_as<T, LoxCallable *>) {
+            return is_pointer(CALLABLE_TAG);
+        } else if constexpr (std::same_as<T, LoxInstance *>) {
+            return is_pointer(INSTANCE_TAG);
+        } else {
+            static_assert(std::derived_from<T, LoxCallable>);
+            return is_pointer(CALLABLE_TAG) and
+                   dynamic_cast<T *>(pointer<LoxCallable>()) != nullptr;
+        }
     }
 
     template <class T>
-    requires std::derived_from<T, LoxCallable> std::shared_ptr<T> get() {
-        auto lox_ptr = std::get<std::shared_ptr<LoxCallable>>(object);
-        return std::dynamic_pointer_cast<T>(lox_ptr);
+    decltype(auto) get() const {
+        if constexpr (std::same_as<T, LoxNull>) {
+            return LoxNull{};
+        } else if constexpr (std::same_as<T, bool>) {
+            return bits == TRUE_BITS;
+        } else if constexpr (std::same_as<T, double>) {
+            return std::bit_cast<double>(bits);
+        } else if constexpr (std::same_as<T, std::string>) {
+            return static_cast<const std::string &>(
+                pointer<LoxString>()->value);
+        } else if constexpr (std::same_as<T, LoxCallable *>) {
+            return pointer<LoxCallable>();
+        } else if constexpr (std::same_as<T, LoxInstance *>) {
+            return pointer<LoxInstance>();
+        } else {
+            static_assert(std::derived_from<T, LoxCallable>);
+            return dynamic_cast<T *>(pointer<LoxCallable>());
+        }
     }
 
+    // The object a string, callable or instance refers to, nullptr for
+    // every other value.
+    const HeapObject *heap_object() const;
+
+    explicit operator bool() const;
+
+    bool operator==(const LoxObject &other) const;
+    std::partial_ordering operator<=>(const LoxObject &other) const;
+
+  private:
+    static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+    static constexpr uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr uint64_t CANONICAL_NAN = 0x7ff8000000000000;
+
+    static constexpr uint64_t NIL_BITS = QNAN | 1;
+    static constexpr uint64_t FALSE_BITS = QNAN | 2;
+    static constexpr uint64_t TRUE_BITS = QNAN | 3;
+
+    static constexpr uint64_t POINTER_BITS = SIGN_BIT | QNAN;
+    static constexpr uint64_t TAG_MASK = 0x7;
+    static constexpr uint64_t STRING_TAG = 0;
+    static constexpr uint64_t CALLABLE_TAG = 1;
+    static constexpr uint64_t INSTANCE_TAG = 2;
+
     template <class T>
-    requires std::derived_from<T, LoxCallable>
-    const std::shared_ptr<T> &get() const {
-        auto lox_ptr = std::get<std::shared_ptr<LoxCallable>>(object);
-        return std::dynamic_pointer_cast<T>(lox_ptr);
+    static uint64_t box(T *pointer, uint64_t tag) {
+        return POINTER_BITS | reinterpret_cast<uintptr_t>(pointer) | tag;
     }
 
-    template <class T>
-    bool holds_alternative() const {
-        return std::holds_alternative<T>(object);
+    bool is_pointer(uint64_t tag) const {
+        return (bits & (POINTER_BITS | TAG_MASK)) == (POINTER_BITS | tag);
     }
 
     template <class T>
-    requires std::derived_from<T, LoxCallable>
-    bool holds_alternative() const {
-        using CallablePtr = std::shared_ptr<LoxCallable>;
-        return std::holds_alternative<CallablePtr>(object) and
-               (std::dynamic_pointer_cast<T>(std::get<CallablePtr>(object)) !=
-                nullptr);
+    T *pointer() const {
+        return reinterpret_cast<T *>(bits & ~(POINTER_BITS | TAG_MASK));
     }
 
-    explicit operator bool() const;
-
-    bool operator==(const LoxObject &other) const;
-    std::partial_ordering operator<=>(const LoxObject &other) const;
-
-  private:
-    LoxObjectT object;
+    uint64_t bits;
 };
+
+static_assert(sizeof(LoxObject) == 8);
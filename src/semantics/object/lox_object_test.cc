@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/object/lox_object.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+TEST(LoxObjectTest, Size) { EXPECT_EQ(sizeof(LoxObject), 8); }
+
+TEST(LoxObjectTest, Null) {
+    LoxObject object;
+    EXPECT_TRUE(object.holds_alternative<LoxNull>());
+    EXPECT_FALSE(object.holds_alternative<bool>());
+    EXPECT_FALSE(object.holds_alternative<double>());
+    EXPECT_FALSE(static_cast<bool>(object));
+    EXPECT_EQ(object, LoxObject(LoxNull{}));
+}
+
+TEST(LoxObjectTest, Bool) {
+    LoxObject t(true);
+    LoxObject f(false);
+    EXPECT_TRUE(t.holds_alternative<bool>());
+    EXPECT_TRUE(f.holds_alternative<bool>());
+    EXPECT_TRUE(t.get<bool>());
+    EXPECT_FALSE(f.get<bool>());
+    EXPECT_NE(t, f);
+    EXPECT_NE(f, LoxObject(LoxNull{}));
+}
+
+TEST(LoxObjectTest, Number) {
+    for (double number : {0.0, -0.0, 1.5, -3.0, 1e300,
+                          std::numeric_limits<double>::infinity()}) {
+        LoxObject object(number);
+        EXPECT_TRUE(object.holds_alternative<double>());
+        EXPECT_FALSE(object.holds_alternative<LoxNull>());
+        EXPECT_EQ(object.get<double>(), number);
+    }
+    EXPECT_EQ(LoxObject(0.0), LoxObject(-0.0));
+    EXPECT_FALSE(static_cast<bool>(LoxObject(0.0)));
+
+    LoxObject nan(std::nan(""));
+    EXPECT_TRUE(nan.holds_alternative<double>());
+    EXPECT_NE(nan, nan);
+    // NaNs keep their sign, even those whose bits would read as a boxed
+    // value.
+    EXPECT_TRUE(std::signbit(LoxObject(-std::nan("")).get<double>()));
+    for (uint64_t bits : {0x7ffc000000000001u, 0xfffc000000000001u}) {
+        double boxed_nan = std::bit_cast<double>(bits);
+        LoxObject object(boxed_nan);
+        EXPECT_TRUE(object.holds_alternative<double>());
+        EXPECT_TRUE(std::isnan(object.get<double>()));
+        EXPECT_EQ(std::signbit(object.get<double>()), std::signbit(boxed_nan));
+    }
+}
+
+TEST(LoxObjectTest, String) {
+    LoxObject a("abc");
+    LoxObject b(std::string("abc"));
+    EXPECT_TRUE(a.holds_alternative<std::string>());
+    EXPECT_FALSE(a.holds_alternative<double>());
+    EXPECT_EQ(a.get<std::string>(), "abc");
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, LoxObject("abd"));
+    EXPECT_FALSE(static_cast<bool>(LoxObject("")));
+}
+
+TEST(LoxObjectTest, TokenLiteral) {
+    EXPECT_EQ(LoxObject(TokenLiteral(2.0)).get<double>(), 2.0);
+    EXPECT_EQ(LoxObject(TokenLiteral("s")).get<std::string>(), "s");
+}
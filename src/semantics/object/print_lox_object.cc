@@ -4,15 +4,20 @@
 #include "src/semantics/object/lox_instance.h"
 
 std::ostream &operator<<(std::ostream &os, const LoxObject &lox_object) {
-    return std::visit(
-        overloaded{
-            [&os](const std::shared_ptr<LoxCallable> &x) -> std::ostream & {
-                return os << *x;
-            },
-            [&os](const std::shared_ptr<LoxInstance> &x) -> std::ostream & {
-                return os << *x;
-            },
-            [&os](const auto &x) -> std::ostream & { return os << x; },
-        },
-        static_cast<LoxObject::LoxObjectT>(lox_object));
+    if (lox_object.holds_alternative<double>()) {
+        return os << lox_object.get<double>();
+    }
+    if (lox_object.holds_alternative<bool>()) {
+        return os << lox_object.get<bool>();
+    }
+    if (lox_object.holds_alternative<std::string>()) {
+        return os << lox_object.get<std::string>();
+    }
+    if (lox_object.holds_alternative<LoxCallable *>()) {
+        return os << *lox_object.get<LoxCallable *>();
+    }
+    if (lox_object.holds_alternative<LoxInstance *>()) {
+        return os << *lox_object.get<LoxInstance *>();
+    }
+    return os << LoxNull{};
 }
@@ -0,0 +1,36 @@
+#include "src/semantics/object/shape.h"
+
+namespace {
+
+uint64_t next_shape_id = 0;
+
+} // namespace
+
+Shape::Shape() : m_id(next_shape_id++), slots(), transitions() {}
+
+Shape::Shape(const Shape &parent, std::string_view name)
+    : m_id(next_shape_id++), slots(parent.slots), transitions() {
+    slots.emplace(name, slots.size());
+}
+
+uint64_t Shape::id() const { return m_id; }
+
+std::optional<size_t> Shape::slot(std::string_view name) const {
+    auto it = slots.find(name);
+    if (it == slots.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t Shape::size() const { return slots.size(); }
+
+Shape *Shape::add_field(std::string_view name) {
+    auto it = transitions.find(name);
+    if (it == transitions.end()) {
+        it = transitions
+                 .emplace(name, std::unique_ptr<Shape>(new Shape(*this, name)))
+                 .first;
+    }
+    return it->second.get();
+}
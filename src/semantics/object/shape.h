@@ -0,0 +1,36 @@
+#pragma once
+
+#include "src/tp_utils.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// The field layout of an instance: which slot of its field array holds each
+// field. Instances of a class that had the same fields added in the same
+// order share a shape. Shapes form a tree owned by the class's root shape,
+// the layout of an instance without fields.
+struct Shape {
+    Shape();
+
+    Shape(const Shape &) = delete;
+    Shape &operator=(const Shape &) = delete;
+
+    // Unique for the lifetime of the process, unlike the address of a shape.
+    uint64_t id() const;
+
+    std::optional<size_t> slot(std::string_view name) const;
+    size_t size() const;
+
+    // The shape of an instance of this shape once `name` is added to it. The
+    // new field takes slot size().
+    Shape *add_field(std::string_view name);
+
+  private:
+    Shape(const Shape &parent, std::string_view name);
+
+    uint64_t m_id;
+    StringMap<size_t> slots;
+    StringMap<std::unique_ptr<Shape>> transitions;
+};
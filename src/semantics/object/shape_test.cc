@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/object/shape.h"
+
+TEST(ShapeTest, AddFieldAssignsNextSlot) {
+    Shape root{};
+    Shape *x = root.add_field("x");
+    Shape *xy = x->add_field("y");
+    EXPECT_EQ(root.size(), 0);
+    EXPECT_EQ(xy->size(), 2);
+    EXPECT_EQ(xy->slot("x"), 0);
+    EXPECT_EQ(xy->slot("y"), 1);
+    EXPECT_EQ(x->slot("y"), std::nullopt);
+}
+
+TEST(ShapeTest, SameOrderSharesShape) {
+    Shape root{};
+    EXPECT_EQ(root.add_field("x")->add_field("y"),
+              root.add_field("x")->add_field("y"));
+    EXPECT_NE(root.add_field("x")->add_field("y"),
+              root.add_field("y")->add_field("x"));
+}
+
+TEST(ShapeTest, IdsAreUnique) {
+    Shape root{};
+    EXPECT_NE(root.id(), root.add_field("x")->id());
+    EXPECT_NE(root.add_field("x")->id(), root.add_field("y")->id());
+}
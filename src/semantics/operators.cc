@@ -0,0 +1,113 @@
+#include "src/semantics/operators.h"
+
+#include "src/semantics/runtime_error.h"
+
+#include <string>
+
+namespace {
+
+void check_numeric_op(const Token &op, const LoxObject &operand) {
+    if (operand.holds_alternative<double>()) {
+        return;
+    }
+    throw RuntimeError(op, "Operand must be a number.");
+}
+
+void check_numeric_op(const Token &op, const LoxObject &left,
+                      const LoxObject &right) {
+    if (left.holds_alternative<double>() and
+        right.holds_alternative<double>()) {
+        return;
+    }
+    throw RuntimeError(op, "Operands must be numbers.");
+}
+
+} // namespace
+
+LoxObject binary_op(const Token &op, const LoxObject &left,
+                    const LoxObject &right) {
+    switch (op.type) {
+    case MINUS:
+    case SLASH:
+    case STAR:
+    case GREATER:
+    case GREATER_EQUAL:
+    case LESS:
+    case LESS_EQUAL:
+        check_numeric_op(op, left, right);
+        return number_op(op, left.get<double>(), right.get<double>());
+    case PLUS:
+        if (left.holds_alternative<double>() &&
+            right.holds_alternative<double>()) {
+            return left.get<double>() + right.get<double>();
+        }
+        if (left.holds_alternative<std::string>() &&
+            right.holds_alternative<std::string>()) {
+            return left.get<std::string>() + right.get<std::string>();
+        }
+        throw RuntimeError(op, "Operands must be two numbers or two strings.");
+    case EQUAL_EQUAL:
+        return left == right;
+    case BANG_EQUAL:
+        return left != right;
+    default:
+        return LoxNull{};
+    }
+}
+
+LoxObject number_op(const Token &op, double left, double right) {
+    switch (op.type) {
+    case MINUS:
+        return left - right;
+    case SLASH:
+        if (right == 0) {
+            throw RuntimeError(op, "Division by zero.");
+        }
+        return left / right;
+    case STAR:
+        return left * right;
+    case PLUS:
+        return left + right;
+    case GREATER:
+        return left > right;
+    case GREATER_EQUAL:
+        return left >= right;
+    case LESS:
+        return left < right;
+    case LESS_EQUAL:
+        return left <= right;
+    case EQUAL_EQUAL:
+        return left == right;
+    case BANG_EQUAL:
+        return left != right;
+    default:
+        return LoxNull{};
+    }
+}
+
+LoxObject unary_op(const Token &op, const LoxObject &right) {
+    switch (op.type) {
+    case BANG:
+        return !static_cast<bool>(right);
+    case MINUS:
+        check_numeric_op(op, right);
+        return -right.get<double>();
+    default:
+        return right;
+    }
+}
+
+void check_arity(const Token &paren, size_t arity, size_t argument_count) {
+    if (argument_count != arity) {
+        throw RuntimeError(paren, "Expected " + std::to_string(arity) +
+                                      " arguments but got " +
+                                      std::to_string(argument_count) + ".");
+    }
+}
+
+LoxInstance *get_instance(const Token &name, const LoxObject &object) {
+    if (not object.holds_alternative<LoxInstance *>()) {
+        throw RuntimeError(name, "Only instances have properties.");
+    }
+    return object.get<LoxInstance *>();
+}
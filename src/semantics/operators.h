@@ -0,0 +1,20 @@
+#pragma once
+
+#include "src/semantics/object/lox_instance.fwd.h"
+#include "src/semantics/object/lox_object.h"
+#include "src/syntactics/token.h"
+
+#include <cstddef>
+
+// The semantics of Lox's operators and of the checks around calls and
+// property accesses, shared by the tree-walking engines. Every function
+// throws a RuntimeError on bad operands.
+
+LoxObject binary_op(const Token &op, const LoxObject &left,
+                    const LoxObject &right);
+// binary_op for two numbers, which need no type checks.
+LoxObject number_op(const Token &op, double left, double right);
+LoxObject unary_op(const Token &op, const LoxObject &right);
+
+void check_arity(const Token &paren, size_t arity, size_t argument_count);
+LoxInstance *get_instance(const Token &name, const LoxObject &object);
@@ -0,0 +1,936 @@
+#include "src/semantics/optimizer.h"
+
+#include "src/semantics/operators.h"
+#include "src/semantics/runtime_error.h"
+
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+namespace {
+
+// Counts the assignments to each local, by declaration, scoping names as the
+// Resolver does, and finds the globals that are assigned to or declared more
+// than once.
+struct AssignmentFinder final : ExprVisitor, StmtVisitor {
+    using Scope = std::unordered_map<std::string_view, const Token *>;
+
+    AssignmentFinder(std::unordered_map<const Token *, size_t> &assigned,
+                     std::unordered_set<std::string_view> &redefined_globals)
+        : assigned(assigned), redefined_globals(redefined_globals), scopes(),
+          declared_globals() {}
+
+    std::unordered_map<const Token *, size_t> &assigned;
+    std::unordered_set<std::string_view> &redefined_globals;
+    std::vector<Scope> scopes;
+    std::unordered_set<std::string_view> declared_globals;
+
+    void find(const Expr *expr) {
+        if (expr != nullptr) {
+            dispatch(*expr, *this);
+        }
+    }
+
+    void find(const Stmt *stmt) {
+        if (stmt != nullptr) {
+            dispatch(*stmt, *this);
+        }
+    }
+
+    void find(const std::pmr::vector<Stmt *> &body) {
+        for (const Stmt *stmt : body) {
+            find(stmt);
+        }
+    }
+
+    void find_function(const std::pmr::vector<Token> &params,
+                       const std::pmr::vector<Stmt *> &body) {
+        scopes.emplace_back();
+        for (const Token &param : params) {
+            declare(param);
+        }
+        find(body);
+        scopes.pop_back();
+    }
+
+    void declare(const Token &name) {
+        if (!scopes.empty()) {
+            scopes.back()[name.lexeme] = &name;
+        } else if (!declared_globals.insert(name.lexeme).second) {
+            redefined_globals.insert(name.lexeme);
+        }
+    }
+
+    void visit_assign_expr(const Expr::Assign &expr) override {
+        find(expr.value);
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            if (auto it = scope->find(expr.name.lexeme); it != scope->end()) {
+                ++assigned[it->second];
+                return;
+            }
+        }
+        redefined_globals.insert(expr.name.lexeme);
+    }
+
+    void visit_binary_expr(const Expr::Binary &expr) override {
+        find(expr.left);
+        find(expr.right);
+    }
+
+    void visit_call_expr(const Expr::Call &expr) override {
+        find(expr.callee);
+        for (const Expr *argument : expr.arguments) {
+            find(argument);
+        }
+    }
+
+    void visit_get_expr(const Expr::Get &expr) override { find(expr.object); }
+
+    void visit_grouping_expr(const Expr::Grouping &expr) override {
+        find(expr.expression);
+    }
+
+    void visit_lambda_expr(const Expr::Lambda &expr) override {
+        find_function(expr.params, expr.body);
+    }
+
+    void visit_literal_expr(const Expr::Literal &expr) override {}
+
+    void visit_logical_expr(const Expr::Logical &expr) override {
+        find(expr.left);
+        find(expr.right);
+    }
+
+    void visit_set_expr(const Expr::Set &expr) override {
+        find(expr.object);
+        find(expr.value);
+    }
+
+    void visit_super_expr(const Expr::Super &expr) override {}
+
+    void visit_this_expr(const Expr::This &expr) override {}
+
+    void visit_unary_expr(const Expr::Unary &expr) override {
+        find(expr.right);
+    }
+
+    void visit_variable_expr(const Expr::Variable &expr) override {}
+
+    void visit_block_stmt(const Stmt::Block &stmt) override {
+        scopes.emplace_back();
+        find(stmt.statements);
+        scopes.pop_back();
+    }
+
+    void visit_class_stmt(const Stmt::Class &stmt) override {
+        declare(stmt.name);
+        for (const Stmt::Function *method : stmt.methods) {
+            find_function(method->params, method->body);
+        }
+    }
+
+    void visit_expression_stmt(const Stmt::Expression &stmt) override {
+        find(stmt.expression);
+    }
+
+    void visit_if_stmt(const Stmt::If &stmt) override {
+        find(stmt.condition);
+        find(stmt.then_branch);
+        find(stmt.else_branch);
+    }
+
+    void visit_function_stmt(const Stmt::Function &stmt) override {
+        declare(stmt.name);
+        find_function(stmt.params, stmt.body);
+    }
+
+    void visit_print_stmt(const Stmt::Print &stmt) override {
+        find(stmt.expression);
+    }
+
+    void visit_return_stmt(const Stmt::Return &stmt) override {
+        find(stmt.value);
+    }
+
+    void visit_var_stmt(const Stmt::Var &stmt) override {
+        declare(stmt.name);
+        find(stmt.initializer);
+    }
+
+    void visit_while_stmt(const Stmt::While &stmt) override {
+        find(stmt.condition);
+        find(stmt.body);
+    }
+};
+
+Expr::Literal *as_literal(Expr *expr) {
+    return expr != nullptr and expr->kind == ExprKind::LITERAL
+               ? static_cast<Expr::Literal *>(expr)
+               : nullptr;
+}
+
+// Mirrors the truthiness of LoxObject: nil, false, 0 and "" are falsey.
+bool is_truthy(const Expr::Literal &literal) {
+    switch (literal.value.type) {
+    case NIL:
+    case FALSE:
+        return false;
+    case NUMBER:
+        return std::get<double>(literal.value.literal.value()) != 0;
+    case STRING:
+        return !std::get<std::string_view>(literal.value.literal.value())
+                    .empty();
+    default:
+        return true;
+    }
+}
+
+double number(const Expr::Literal &literal) {
+    return std::get<double>(literal.value.literal.value());
+}
+
+std::string_view string(const Expr::Literal &literal) {
+    return std::get<std::string_view>(literal.value.literal.value());
+}
+
+bool equal(const Expr::Literal &left, const Expr::Literal &right) {
+    if (left.value.type != right.value.type) {
+        return false;
+    }
+    switch (left.value.type) {
+    case NUMBER:
+        return number(left) == number(right);
+    case STRING:
+        return string(left) == string(right);
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+Optimizer::Optimizer(AstArena &arena, AbstractInterpreter *interpreter,
+                     OptimizerSettings settings)
+    : arena(arena), interpreter(interpreter), settings(settings), scopes(),
+      assigned(), redefined_globals(), global_functions(), functions(),
+      inlining() {}
+
+void Optimizer::optimize(std::pmr::vector<Stmt *> &stmts) {
+    AssignmentFinder finder(assigned, redefined_globals);
+    finder.find(stmts);
+    optimize_body(stmts);
+}
+
+Expr *Optimizer::optimize(Expr *expr) {
+    switch (expr->kind) {
+    case ExprKind::ASSIGN: {
+        auto &assign = static_cast<Expr::Assign &>(*expr);
+        assign.value = optimize(assign.value);
+        return expr;
+    }
+    case ExprKind::BINARY: {
+        auto &binary = static_cast<Expr::Binary &>(*expr);
+        binary.left = optimize(binary.left);
+        binary.right = optimize(binary.right);
+        return fold_binary(binary);
+    }
+    case ExprKind::CALL: {
+        auto &call = static_cast<Expr::Call &>(*expr);
+        call.callee = optimize(call.callee);
+        for (Expr *&argument : call.arguments) {
+            argument = optimize(argument);
+        }
+        return inline_call(call);
+    }
+    case ExprKind::GET: {
+        auto &get = static_cast<Expr::Get &>(*expr);
+        get.object = optimize(get.object);
+        return expr;
+    }
+    case ExprKind::GROUPING:
+        return optimize(static_cast<Expr::Grouping &>(*expr).expression);
+    case ExprKind::LAMBDA: {
+        auto &lambda = static_cast<Expr::Lambda &>(*expr);
+        optimize_function(lambda.params, lambda.body);
+        return expr;
+    }
+    case ExprKind::LOGICAL: {
+        auto &logical = static_cast<Expr::Logical &>(*expr);
+        logical.left = optimize(logical.left);
+        logical.right = optimize(logical.right);
+        return fold_logical(logical);
+    }
+    case ExprKind::SET: {
+        auto &set = static_cast<Expr::Set &>(*expr);
+        set.object = optimize(set.object);
+        set.value = optimize(set.value);
+        return expr;
+    }
+    case ExprKind::UNARY: {
+        auto &unary = static_cast<Expr::Unary &>(*expr);
+        unary.right = optimize(unary.right);
+        return fold_unary(unary);
+    }
+    case ExprKind::VARIABLE:
+        return fold_variable(static_cast<Expr::Variable &>(*expr));
+    case ExprKind::LITERAL:
+    case ExprKind::SUPER:
+    case ExprKind::THIS:
+        return expr;
+    }
+    return expr;
+}
+
+Stmt *Optimizer::optimize(Stmt *stmt) {
+    switch (stmt->kind) {
+    case StmtKind::BLOCK: {
+        auto &block = static_cast<Stmt::Block &>(*stmt);
+        scopes.emplace_back();
+        optimize_body(block.statements);
+        scopes.pop_back();
+        if (block.statements.empty()) {
+            drop(stmt);
+            return nullptr;
+        }
+        return stmt;
+    }
+    case StmtKind::CLASS: {
+        auto &class_stmt = static_cast<Stmt::Class &>(*stmt);
+        declare(class_stmt.name);
+        for (Stmt::Function *method : class_stmt.methods) {
+            optimize_function(method->params, method->body);
+        }
+        return stmt;
+    }
+    case StmtKind::EXPRESSION: {
+        auto &expression = static_cast<Stmt::Expression &>(*stmt);
+        expression.expression = optimize(expression.expression);
+        return stmt;
+    }
+    case StmtKind::IF: {
+        auto &if_stmt = static_cast<Stmt::If &>(*stmt);
+        if_stmt.condition = optimize(if_stmt.condition);
+        if (Expr::Literal *condition = as_literal(if_stmt.condition)) {
+            Stmt *taken = if_stmt.then_branch;
+            Stmt *not_taken = if_stmt.else_branch;
+            if (!is_truthy(*condition)) {
+                std::swap(taken, not_taken);
+            }
+            drop(not_taken);
+            return taken != nullptr ? optimize(taken) : nullptr;
+        }
+        if_stmt.then_branch = optimize_nested(if_stmt.then_branch);
+        if (if_stmt.else_branch != nullptr) {
+            if_stmt.else_branch = optimize(if_stmt.else_branch);
+        }
+        return stmt;
+    }
+    case StmtKind::FUNCTION: {
+        auto &function = static_cast<Stmt::Function &>(*stmt);
+        declare(function.name, nullptr, &function);
+        optimize_function(function.params, function.body);
+        functions[&function] = inspect(function);
+        if (scopes.empty() and settings.whole_program and
+            !redefined_globals.contains(function.name.lexeme)) {
+            global_functions[function.name.lexeme] = &function;
+        }
+        return stmt;
+    }
+    case StmtKind::PRINT: {
+        auto &print = static_cast<Stmt::Print &>(*stmt);
+        print.expression = optimize(print.expression);
+        return stmt;
+    }
+    case StmtKind::RETURN: {
+        auto &return_stmt = static_cast<Stmt::Return &>(*stmt);
+        if (return_stmt.value != nullptr) {
+            return_stmt.value = optimize(return_stmt.value);
+        }
+        return stmt;
+    }
+    case StmtKind::VAR: {
+        auto &var = static_cast<Stmt::Var &>(*stmt);
+        // Lambdas in the initializer see the variable, but not as a constant.
+        declare(var.name);
+        Expr::Literal *value = nullptr;
+        if (var.initializer != nullptr) {
+            var.initializer = optimize(var.initializer);
+            value = as_literal(var.initializer);
+        } else {
+            value = arena.make<Expr::Literal>(
+                Token(NIL, "nil", var.name.line));
+        }
+        if (value != nullptr and !assigned.contains(&var.name)) {
+            declare(var.name, value);
+        }
+        return stmt;
+    }
+    case StmtKind::WHILE: {
+        auto &while_stmt = static_cast<Stmt::While &>(*stmt);
+        while_stmt.condition = optimize(while_stmt.condition);
+        if (Expr::Literal *condition = as_literal(while_stmt.condition);
+            condition != nullptr and !is_truthy(*condition)) {
+            drop(stmt);
+            return nullptr;
+        }
+        while_stmt.body = optimize_nested(while_stmt.body);
+        count_loop(while_stmt);
+        return stmt;
+    }
+    }
+    return stmt;
+}
+
+Stmt *Optimizer::optimize_nested(Stmt *stmt) {
+    // What is left of a statement that runs nothing still runs nothing.
+    Stmt *optimized = optimize(stmt);
+    return optimized != nullptr ? optimized : stmt;
+}
+
+void Optimizer::optimize_body(std::pmr::vector<Stmt *> &body) {
+    size_t kept = 0;
+    for (Stmt *stmt : body) {
+        if (Stmt *optimized = optimize(stmt)) {
+            body[kept++] = optimized;
+        }
+    }
+    body.resize(kept);
+}
+
+void Optimizer::optimize_function(const std::pmr::vector<Token> &params,
+                                  std::pmr::vector<Stmt *> &body) {
+    scopes.emplace_back();
+    for (const Token &param : params) {
+        declare(param);
+    }
+    optimize_body(body);
+    scopes.pop_back();
+}
+
+Expr *Optimizer::fold_binary(Expr::Binary &binary) {
+    Expr::Literal *left = as_literal(binary.left);
+    Expr::Literal *right = as_literal(binary.right);
+    if (left == nullptr or right == nullptr) {
+        return &binary;
+    }
+
+    if (left->value.type == NUMBER and right->value.type == NUMBER) {
+        LoxObject result;
+        try {
+            result = number_op(binary.op, number(*left), number(*right));
+        } catch (const RuntimeError &) {
+            // Left for the engine to report when it runs.
+            return &binary;
+        }
+        if (result.holds_alternative<double>()) {
+            return make_literal(binary.op, result.get<double>());
+        }
+        return make_literal(binary.op, result.get<bool>());
+    }
+
+    switch (binary.op.type) {
+    case PLUS:
+        if (left->value.type == STRING and right->value.type == STRING) {
+            return make_literal(binary.op,
+                                std::string(string(*left)) +
+                                    std::string(string(*right)));
+        }
+        return &binary;
+    case EQUAL_EQUAL:
+        return make_literal(binary.op, equal(*left, *right));
+    case BANG_EQUAL:
+        return make_literal(binary.op, !equal(*left, *right));
+    default:
+        return &binary;
+    }
+}
+
+Expr *Optimizer::fold_logical(Expr::Logical &logical) {
+    Expr::Literal *left = as_literal(logical.left);
+    if (left == nullptr) {
+        return &logical;
+    }
+    // `or` stops at a truthy left operand, `and` at a falsey one.
+    if (is_truthy(*left) == (logical.op.type == OR)) {
+        drop(logical.right);
+        return left;
+    }
+    return logical.right;
+}
+
+Expr *Optimizer::fold_unary(Expr::Unary &unary) {
+    Expr::Literal *right = as_literal(unary.right);
+    if (right == nullptr) {
+        return &unary;
+    }
+    if (unary.op.type == BANG) {
+        return make_literal(unary.op, !is_truthy(*right));
+    }
+    if (unary.op.type == MINUS and right->value.type == NUMBER) {
+        return make_literal(unary.op, -number(*right));
+    }
+    return &unary;
+}
+
+Expr *Optimizer::fold_variable(Expr::Variable &variable) {
+    const Binding *binding = lookup(variable.name.lexeme);
+    if (binding == nullptr or binding->value == nullptr) {
+        return &variable;
+    }
+    drop(&variable);
+    return binding->value;
+}
+
+// Recognises the loops `for` makes of
+//     for (var i = start; i < limit; i = i + step) body
+// where nothing but the increment assigns to i and `limit` is invariant, as well as
+// while loops of the same shape, with any comparison. Evaluating the limit
+// once, before the first iteration, then evaluates it where the condition
+// first does: only reading the counter comes before it.
+void Optimizer::count_loop(Stmt::While &loop) {
+    if (loop.condition->kind != ExprKind::BINARY or
+        loop.body->kind != StmtKind::BLOCK) {
+        return;
+    }
+    auto &condition = static_cast<Expr::Binary &>(*loop.condition);
+    switch (condition.op.type) {
+    case LESS:
+    case LESS_EQUAL:
+    case GREATER:
+    case GREATER_EQUAL:
+        break;
+    default:
+        return;
+    }
+    if (condition.left->kind != ExprKind::VARIABLE or
+        !is_invariant(condition.right)) {
+        return;
+    }
+    auto &counter = static_cast<const Expr::Variable &>(*condition.left);
+    const Binding *binding = lookup(counter.name.lexeme);
+    if (binding == nullptr) {
+        return;
+    }
+
+    // The last statement must be `i = i + step`, `i = step + i` or
+    // `i = i - step`, with i not declared again by the block.
+    const auto &body = static_cast<const Stmt::Block &>(*loop.body).statements;
+    auto names_counter = [&](const Expr *expr) {
+        return expr->kind == ExprKind::VARIABLE and
+               static_cast<const Expr::Variable &>(*expr).name.lexeme ==
+                   counter.name.lexeme;
+    };
+    auto declares_counter = [&](const Stmt *stmt) {
+        switch (stmt->kind) {
+        case StmtKind::VAR:
+            return static_cast<const Stmt::Var &>(*stmt).name.lexeme ==
+                   counter.name.lexeme;
+        case StmtKind::FUNCTION:
+            return static_cast<const Stmt::Function &>(*stmt).name.lexeme ==
+                   counter.name.lexeme;
+        case StmtKind::CLASS:
+            return static_cast<const Stmt::Class &>(*stmt).name.lexeme ==
+                   counter.name.lexeme;
+        default:
+            return false;
+        }
+    };
+    if (body.empty() or body.back()->kind != StmtKind::EXPRESSION or
+        std::ranges::any_of(body, declares_counter)) {
+        return;
+    }
+    const Expr *increment =
+        static_cast<const Stmt::Expression &>(*body.back()).expression;
+    if (increment->kind != ExprKind::ASSIGN) {
+        return;
+    }
+    auto &assign = static_cast<const Expr::Assign &>(*increment);
+    if (assign.name.lexeme != counter.name.lexeme or
+        assign.value->kind != ExprKind::BINARY) {
+        return;
+    }
+    auto &sum = static_cast<const Expr::Binary &>(*assign.value);
+    Expr::Literal *step = nullptr;
+    if (names_counter(sum.left)) {
+        step = as_literal(sum.right);
+    } else if (sum.op.type == PLUS and names_counter(sum.right)) {
+        step = as_literal(sum.left);
+    }
+    if (step == nullptr or step->value.type != NUMBER or
+        (sum.op.type != PLUS and sum.op.type != MINUS)) {
+        return;
+    }
+
+    // Nothing else may assign to the counter, in the body or in a closure
+    // that the body might call.
+    if (auto it = assigned.find(binding->declaration);
+        it == assigned.end() or it->second != 1) {
+        return;
+    }
+
+    loop.counted = CountedLoop{&counter, condition.right, condition.op.type,
+                               sum.op.type == PLUS ? number(*step)
+                                                   : -number(*step)};
+}
+
+bool Optimizer::is_invariant(const Expr *expr) const {
+    switch (expr->kind) {
+    case ExprKind::LITERAL:
+        return true;
+    case ExprKind::VARIABLE: {
+        std::string_view name =
+            static_cast<const Expr::Variable &>(*expr).name.lexeme;
+        if (const Binding *binding = lookup(name)) {
+            return !assigned.contains(binding->declaration);
+        }
+        // Code declared by later lines of the REPL may assign to a global.
+        return settings.whole_program and !redefined_globals.contains(name);
+    }
+    case ExprKind::BINARY: {
+        auto &binary = static_cast<const Expr::Binary &>(*expr);
+        return is_invariant(binary.left) and is_invariant(binary.right);
+    }
+    case ExprKind::LOGICAL: {
+        auto &logical = static_cast<const Expr::Logical &>(*expr);
+        return is_invariant(logical.left) and is_invariant(logical.right);
+    }
+    case ExprKind::UNARY:
+        return is_invariant(static_cast<const Expr::Unary &>(*expr).right);
+    default:
+        return false;
+    }
+}
+
+// A call to a function whose only statement returns an expression becomes a
+// copy of that expression, with the parameters replaced by copies of the
+// arguments. That evaluates as the call does as long as
+//  - the call certainly calls the function, as it names a function that is
+//    never assigned to,
+//  - the arguments evaluate the same whenever, and however often, the copy
+//    evaluates them, as they are literals, `this` or locals that nothing
+//    assigns to while the copy runs,
+//  - every other name in the expression is a global that no local shadows
+//    where it is copied to.
+// Functions that refer to themselves are not inlined, nor ones whose result
+// is large, declares a function, or refers to `this`, `super` or a local of
+// an enclosing function.
+Expr *Optimizer::inline_call(Expr::Call &call) {
+    const Stmt::Function *function = callee(call);
+    if (function == nullptr) {
+        return &call;
+    }
+
+    const char *obstacle = nullptr;
+    auto it = functions.find(function);
+    if (it == functions.end()) {
+        // It is only inspected once its body is optimized.
+        obstacle = "it refers to itself";
+    } else if (it->second.obstacle != nullptr) {
+        obstacle = it->second.obstacle;
+    } else if (call.arguments.size() != function->params.size()) {
+        obstacle = "it is called with the wrong number of arguments";
+    } else if (inlining.contains(function)) {
+        obstacle = "it is being inlined already";
+    } else if (!std::ranges::all_of(call.arguments, [&](Expr *argument) {
+                   return is_stable(argument, it->second);
+               })) {
+        obstacle = "an argument is not a literal, this or a local it keeps";
+    } else if (std::ranges::any_of(it->second.globals,
+                                   [this](std::string_view global) {
+                                       return lookup(global) != nullptr;
+                                   })) {
+        obstacle = "a local shadows a global it refers to";
+    }
+    trace(call, *function, obstacle);
+    if (obstacle != nullptr) {
+        return &call;
+    }
+
+    Expr *result = it->second.result != nullptr
+                       ? copy(it->second.result, function, &call.arguments)
+                       : arena.make<Expr::Literal>(
+                             Token(NIL, "nil", call.paren.line));
+    if (interpreter != nullptr and it->second.result != nullptr) {
+        interpreter->resolve_inlined(result, it->second.result, &call);
+    }
+    drop(&call);
+    inlining.insert(function);
+    result = optimize(result);
+    inlining.erase(function);
+    return result;
+}
+
+const Stmt::Function *Optimizer::callee(const Expr::Call &call) const {
+    if (call.callee->kind != ExprKind::VARIABLE) {
+        return nullptr;
+    }
+    auto &name = static_cast<const Expr::Variable &>(*call.callee).name;
+    if (const Binding *binding = lookup(name.lexeme)) {
+        return assigned.contains(binding->declaration) ? nullptr
+                                                       : binding->function;
+    }
+    auto it = global_functions.find(name.lexeme);
+    return it != global_functions.end() ? it->second : nullptr;
+}
+
+bool Optimizer::is_stable(const Expr *argument,
+                          const Inlinable &inlinable) const {
+    switch (argument->kind) {
+    case ExprKind::LITERAL:
+    case ExprKind::THIS:
+        return true;
+    case ExprKind::VARIABLE: {
+        auto &name = static_cast<const Expr::Variable &>(*argument).name;
+        const Binding *binding = lookup(name.lexeme);
+        return binding != nullptr and
+               (!inlinable.has_effects or
+                !assigned.contains(binding->declaration));
+    }
+    default:
+        return false;
+    }
+}
+
+Optimizer::Inlinable Optimizer::inspect(const Stmt::Function &function) const {
+    Inlinable inlinable{nullptr, nullptr, {}, false};
+    if (function.body.empty()) {
+        return inlinable;
+    }
+    if (function.body.size() > 1 or
+        function.body.front()->kind != StmtKind::RETURN) {
+        inlinable.obstacle = "its body is more than a return statement";
+        return inlinable;
+    }
+    inlinable.result =
+        static_cast<const Stmt::Return &>(*function.body.front()).value;
+    if (inlinable.result != nullptr) {
+        size_t size = 0;
+        inlinable.obstacle =
+            inspect(inlinable.result, function, inlinable, size);
+        if (inlinable.obstacle == nullptr and size > MAX_INLINED_SIZE) {
+            inlinable.obstacle = "its result is too large";
+        }
+    }
+    return inlinable;
+}
+
+// Returns why `expr`, part of the result of `function`, cannot be inlined, or
+// nullptr, adding the number of its nodes to `size`.
+const char *Optimizer::inspect(const Expr *expr,
+                               const Stmt::Function &function,
+                               Inlinable &inlinable, size_t &size) const {
+    ++size;
+    auto refer_to = [&](const Token &name, bool assigns) -> const char * {
+        for (const Token &param : function.params) {
+            if (param.lexeme == name.lexeme) {
+                return assigns ? "it assigns to a parameter" : nullptr;
+            }
+        }
+        if (name.lexeme == function.name.lexeme) {
+            return "it refers to itself";
+        }
+        // Scopes are as they were where the function was declared.
+        if (lookup(name.lexeme) != nullptr) {
+            return "it refers to a local of an enclosing function";
+        }
+        inlinable.globals.push_back(name.lexeme);
+        return nullptr;
+    };
+    auto inspect_all = [&](auto... children) -> const char * {
+        const char *obstacle = nullptr;
+        ((obstacle = obstacle != nullptr
+                         ? obstacle
+                         : inspect(children, function, inlinable, size)),
+         ...);
+        return obstacle;
+    };
+
+    switch (expr->kind) {
+    case ExprKind::ASSIGN: {
+        auto &assign = static_cast<const Expr::Assign &>(*expr);
+        inlinable.has_effects = true;
+        if (const char *obstacle = refer_to(assign.name, true)) {
+            return obstacle;
+        }
+        return inspect_all(assign.value);
+    }
+    case ExprKind::BINARY: {
+        auto &binary = static_cast<const Expr::Binary &>(*expr);
+        return inspect_all(binary.left, binary.right);
+    }
+    case ExprKind::CALL: {
+        auto &call = static_cast<const Expr::Call &>(*expr);
+        inlinable.has_effects = true;
+        const char *obstacle = inspect_all(call.callee);
+        for (const Expr *argument : call.arguments) {
+            obstacle = obstacle != nullptr ? obstacle : inspect_all(argument);
+        }
+        return obstacle;
+    }
+    case ExprKind::GET:
+        return inspect_all(static_cast<const Expr::Get &>(*expr).object);
+    case ExprKind::GROUPING:
+        return inspect_all(
+            static_cast<const Expr::Grouping &>(*expr).expression);
+    case ExprKind::LAMBDA:
+        return "it declares a function";
+    case ExprKind::LITERAL:
+        return nullptr;
+    case ExprKind::LOGICAL: {
+        auto &logical = static_cast<const Expr::Logical &>(*expr);
+        return inspect_all(logical.left, logical.right);
+    }
+    case ExprKind::SET: {
+        auto &set = static_cast<const Expr::Set &>(*expr);
+        inlinable.has_effects = true;
+        return inspect_all(set.object, set.value);
+    }
+    case ExprKind::SUPER:
+    case ExprKind::THIS:
+        return "it refers to this or super";
+    case ExprKind::UNARY:
+        return inspect_all(static_cast<const Expr::Unary &>(*expr).right);
+    case ExprKind::VARIABLE:
+        return refer_to(static_cast<const Expr::Variable &>(*expr).name,
+                        false);
+    }
+    return nullptr;
+}
+
+Expr *Optimizer::copy(const Expr *expr, const Stmt::Function *function,
+                      const std::pmr::vector<Expr *> *arguments) {
+    auto copy_of = [&](const Expr *child) {
+        return copy(child, function, arguments);
+    };
+    // Copies of locals are where the originals are, so they refer to the
+    // same variables.
+    auto resolved = [this, expr](Expr *copy) {
+        if (interpreter != nullptr) {
+            interpreter->resolve_copy(copy, expr);
+        }
+        return copy;
+    };
+
+    switch (expr->kind) {
+    case ExprKind::ASSIGN: {
+        auto &assign = static_cast<const Expr::Assign &>(*expr);
+        return resolved(
+            arena.make<Expr::Assign>(assign.name, copy_of(assign.value)));
+    }
+    case ExprKind::BINARY: {
+        auto &binary = static_cast<const Expr::Binary &>(*expr);
+        return arena.make<Expr::Binary>(copy_of(binary.left), binary.op,
+                                        copy_of(binary.right));
+    }
+    case ExprKind::CALL: {
+        auto &call = static_cast<const Expr::Call &>(*expr);
+        auto arguments = arena.list<Expr *>();
+        for (const Expr *argument : call.arguments) {
+            arguments.push_back(copy_of(argument));
+        }
+        return arena.make<Expr::Call>(copy_of(call.callee), call.paren,
+                                      std::move(arguments));
+    }
+    case ExprKind::GET: {
+        auto &get = static_cast<const Expr::Get &>(*expr);
+        return arena.make<Expr::Get>(copy_of(get.object), get.name);
+    }
+    case ExprKind::GROUPING:
+        return copy_of(static_cast<const Expr::Grouping &>(*expr).expression);
+    case ExprKind::LITERAL:
+        return arena.make<Expr::Literal>(
+            static_cast<const Expr::Literal &>(*expr).value);
+    case ExprKind::LOGICAL: {
+        auto &logical = static_cast<const Expr::Logical &>(*expr);
+        return arena.make<Expr::Logical>(copy_of(logical.left), logical.op,
+                                         copy_of(logical.right));
+    }
+    case ExprKind::SET: {
+        auto &set = static_cast<const Expr::Set &>(*expr);
+        return arena.make<Expr::Set>(copy_of(set.object), set.name,
+                                     copy_of(set.value));
+    }
+    case ExprKind::THIS:
+        return resolved(arena.make<Expr::This>(
+            static_cast<const Expr::This &>(*expr).keyword));
+    case ExprKind::UNARY: {
+        auto &unary = static_cast<const Expr::Unary &>(*expr);
+        return arena.make<Expr::Unary>(unary.op, copy_of(unary.right));
+    }
+    case ExprKind::VARIABLE: {
+        auto &variable = static_cast<const Expr::Variable &>(*expr);
+        for (size_t i = 0; function != nullptr and i < function->params.size();
+             ++i) {
+            if (function->params[i].lexeme == variable.name.lexeme) {
+                return copy(arguments->at(i));
+            }
+        }
+        return resolved(arena.make<Expr::Variable>(variable.name));
+    }
+    case ExprKind::LAMBDA:
+    case ExprKind::SUPER:
+        break;
+    }
+    throw std::logic_error("Not an expression inline_call() copies.");
+}
+
+void Optimizer::trace(const Expr::Call &call, const Stmt::Function &function,
+                      const char *obstacle) const {
+    if (settings.trace_inlining == nullptr) {
+        return;
+    }
+    std::ostream &os = *settings.trace_inlining;
+    os << "inlining: [line " << call.paren.line << "] " << function.name.lexeme;
+    if (obstacle == nullptr) {
+        os << " inlined\n";
+    } else {
+        os << " not inlined: " << obstacle << '\n';
+    }
+}
+
+Expr::Literal *Optimizer::make_literal(const Token &at, bool value) {
+    return arena.make<Expr::Literal>(
+        Token(value ? TRUE : FALSE, value ? "true" : "false", at.line));
+}
+
+// Folded numbers and strings are in no source, so their tokens have no
+// lexeme.
+Expr::Literal *Optimizer::make_literal(const Token &at, double value) {
+    return arena.make<Expr::Literal>(Token(NUMBER, "", at.line, value));
+}
+
+Expr::Literal *Optimizer::make_literal(const Token &at,
+                                       std::string_view value) {
+    return arena.make<Expr::Literal>(
+        Token(STRING, "", at.line, arena.copy(value)));
+}
+
+const Optimizer::Binding *Optimizer::lookup(std::string_view name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        if (auto it = scope->find(name); it != scope->end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+void Optimizer::declare(const Token &name, Expr::Literal *value,
+                        const Stmt::Function *function) {
+    if (!scopes.empty()) {
+        scopes.back()[name.lexeme] = {&name, value, function};
+    }
+}
+
+void Optimizer::drop(const Stmt *stmt) {
+    if (interpreter != nullptr and stmt != nullptr) {
+        interpreter->forget(stmt);
+    }
+}
+
+void Optimizer::drop(const Expr *expr) {
+    if (interpreter != nullptr and expr != nullptr) {
+        interpreter->forget(expr);
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "src/semantics/abstract_interpreter.h"
+#include "src/syntactics/ast_arena.h"
+#include "src/syntactics/expr.h"
+#include "src/syntactics/stmt.h"
+
+#include <iosfwd>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct OptimizerSettings {
+    // Whether the program is all the code that can assign to its globals, so
+    // that a global function it never assigns to is never redefined. Not so
+    // for a line of the REPL, which later lines can redefine.
+    bool whole_program = true;
+    // Where to report which calls are inlined and why others are not.
+    std::ostream *trace_inlining = nullptr;
+};
+
+// Rewrites a resolved program so that it does less at run time, for every
+// engine alike:
+//  - operators whose operands are literals are folded into a literal, unless
+//    evaluating them would be a runtime error,
+//  - locals that are never assigned after their declaration are replaced by
+//    their value wherever they are read, if that is a literal,
+//  - if and while statements with a literal condition lose the branches that
+//    can never run,
+//  - calls to small functions that are never assigned to are replaced by
+//    what the function returns, see inline_call(),
+//  - while loops that count a local towards a limit are marked as such, for
+//    engines to run them with a native counter, see count_loop(),
+//  - groupings are dropped.
+// New nodes go in the arena of the program being optimized. Programs with
+// resolve errors must not be optimized.
+struct Optimizer {
+    // `interpreter`, if given, forgets what the Resolver recorded about the
+    // nodes that are dropped, and learns about the nodes that are copied.
+    explicit Optimizer(AstArena &arena,
+                       AbstractInterpreter *interpreter = nullptr,
+                       OptimizerSettings settings = {});
+
+    void optimize(std::pmr::vector<Stmt *> &stmts);
+
+    // Functions whose result has more nodes than this are not inlined.
+    static constexpr size_t MAX_INLINED_SIZE = 16;
+
+  private:
+    // What a local name refers to.
+    struct Binding {
+        const Token *declaration;
+        // The value of a local that is never assigned to, if a literal.
+        Expr::Literal *value;
+        // The declaration of a local function.
+        const Stmt::Function *function;
+    };
+    using Scope = std::unordered_map<std::string_view, Binding>;
+
+    // Whether calls to a function can be inlined, found once the body of its
+    // declaration is optimized.
+    struct Inlinable {
+        // Why they cannot be, or nullptr.
+        const char *obstacle;
+        // What a call returns: the value of the function's only statement, a
+        // return, or nullptr if it returns nil.
+        const Expr *result;
+        // The globals `result` refers to, which must not be shadowed where
+        // it is inlined.
+        std::vector<std::string_view> globals;
+        // Whether `result` calls or assigns to anything, which might assign
+        // to a local passed as an argument.
+        bool has_effects;
+    };
+
+    Expr *optimize(Expr *expr);
+    // Returns the statement to run in place of `stmt`, or nullptr if there
+    // is nothing left to run.
+    Stmt *optimize(Stmt *stmt);
+    // For statements that must stay, e.g. the body of a loop.
+    Stmt *optimize_nested(Stmt *stmt);
+    void optimize_body(std::pmr::vector<Stmt *> &body);
+    void optimize_function(const std::pmr::vector<Token> &params,
+                           std::pmr::vector<Stmt *> &body);
+
+    Expr *fold_binary(Expr::Binary &binary);
+    Expr *fold_logical(Expr::Logical &logical);
+    Expr *fold_unary(Expr::Unary &unary);
+    Expr *fold_variable(Expr::Variable &variable);
+
+    void count_loop(Stmt::While &loop);
+    // Whether `expr` evaluates the same wherever it is, within the scopes
+    // being optimized, and does nothing else.
+    bool is_invariant(const Expr *expr) const;
+
+    Expr *inline_call(Expr::Call &call);
+    // The function a call certainly calls, if it can tell.
+    const Stmt::Function *callee(const Expr::Call &call) const;
+    bool is_stable(const Expr *argument, const Inlinable &inlinable) const;
+    Inlinable inspect(const Stmt::Function &function) const;
+    const char *inspect(const Expr *expr, const Stmt::Function &function,
+                        Inlinable &inlinable, size_t &size) const;
+    // A copy of `expr` with the parameters of `function` replaced by copies
+    // of `arguments`.
+    Expr *copy(const Expr *expr, const Stmt::Function *function = nullptr,
+               const std::pmr::vector<Expr *> *arguments = nullptr);
+    void trace(const Expr::Call &call, const Stmt::Function &function,
+               const char *obstacle) const;
+
+    Expr::Literal *make_literal(const Token &at, bool value);
+    Expr::Literal *make_literal(const Token &at, double value);
+    Expr::Literal *make_literal(const Token &at, std::string_view value);
+
+    const Binding *lookup(std::string_view name) const;
+    void declare(const Token &name, Expr::Literal *value = nullptr,
+                 const Stmt::Function *function = nullptr);
+    void drop(const Stmt *stmt);
+    void drop(const Expr *expr);
+
+    AstArena &arena;
+    AbstractInterpreter *interpreter;
+    OptimizerSettings settings;
+    std::vector<Scope> scopes;
+    // The number of assignments to each local that is assigned to
+    // somewhere, by declaration.
+    std::unordered_map<const Token *, size_t> assigned;
+    // The names of globals that are assigned to somewhere, or declared more
+    // than once.
+    std::unordered_set<std::string_view> redefined_globals;
+    // Global functions whose declaration was optimized, by name.
+    std::unordered_map<std::string_view, const Stmt::Function *>
+        global_functions;
+    // What inspect() found about the functions declared so far.
+    std::unordered_map<const Stmt::Function *, Inlinable> functions;
+    // The functions whose calls are being inlined, which their result must
+    // not inline again.
+    std::unordered_set<const Stmt::Function *> inlining;
+};
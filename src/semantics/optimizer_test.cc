@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/interpreter.h"
+#include "src/semantics/optimizer.h"
+#include "src/semantics/testing.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Runs `source` optimized, expecting it to print what it does unoptimized.
+RunResult run_optimized(const std::string &source,
+                        OptimizerSettings settings = {}) {
+    RunResult optimized = run<Interpreter>(source, settings);
+    EXPECT_EQ(optimized.output, run<Interpreter>(source).output);
+    return optimized;
+}
+
+// The expression of the print statement `index` of `stmts`.
+const Expr &printed(const std::pmr::vector<Stmt *> &stmts, size_t index) {
+    return *dynamic_cast<const Stmt::Print &>(*stmts.at(index)).expression;
+}
+
+} // namespace
+
+TEST(OptimizerTest, FoldsConstantExpressions) {
+    RunResult result = run_optimized(R"(
+        print 1 + 2 * (3 - 1);
+        print "con" + "cat" + "enated";
+        print !true;
+        print -(4 - 6) >= 2;
+        print nil == false;
+        print "a" != "a";
+        print nil or "default";
+        print 0 and 1;
+    )");
+    EXPECT_EQ(result.output,
+              "5\nconcatenated\nfalse\ntrue\nfalse\nfalse\ndefault\n0\n");
+    for (size_t i = 0; i < result.program.statements.size(); ++i) {
+        EXPECT_EQ(printed(result.program.statements, i).kind,
+                  ExprKind::LITERAL);
+    }
+}
+
+TEST(OptimizerTest, LeavesRuntimeErrorsToTheEngine) {
+    RunResult result = run_optimized("print 1;\nprint 2 / (1 - 1);");
+    EXPECT_EQ(result.output, "1\n[line 2] Error: Division by zero.\n");
+    EXPECT_EQ(printed(result.program.statements, 1).kind, ExprKind::BINARY);
+
+    RunResult mistyped = run_optimized(R"(print "a" - 1;)");
+    EXPECT_EQ(printed(mistyped.program.statements, 0).kind, ExprKind::BINARY);
+}
+
+TEST(OptimizerTest, PropagatesLocalsThatAreNeverAssigned) {
+    RunResult result = run_optimized(R"(
+        var global = 1;
+        {
+            var width = 2;
+            var area = width * 3;
+            var counter = 0;
+            counter = counter + 1;
+            var nothing;
+            fun get() { return width; }
+            print area;
+            print counter;
+            print nothing;
+            print global;
+            print get();
+        }
+    )");
+    EXPECT_EQ(result.output, "6\n1\nnull\n1\n2\n");
+
+    auto &block =
+        dynamic_cast<const Stmt::Block &>(*result.program.statements.at(1));
+    const auto &stmts = block.statements;
+    EXPECT_EQ(printed(stmts, 6).kind, ExprKind::LITERAL);
+    EXPECT_EQ(printed(stmts, 7).kind, ExprKind::VARIABLE);
+    EXPECT_EQ(printed(stmts, 8).kind, ExprKind::LITERAL);
+    EXPECT_EQ(printed(stmts, 9).kind, ExprKind::VARIABLE);
+
+    auto &get = dynamic_cast<const Stmt::Function &>(*stmts.at(5));
+    auto &returned = dynamic_cast<const Stmt::Return &>(*get.body.at(0));
+    EXPECT_EQ(returned.value->kind, ExprKind::LITERAL);
+}
+
+TEST(OptimizerTest, RespectsShadowingAndClosures) {
+    run_optimized(R"(
+        var name = "global";
+        {
+            fun show() { print name; }
+            var name = "block";
+            show();
+            {
+                var name = "inner";
+                print name + "!";
+            }
+            var make = fun () {
+                var name = "closure";
+                return fun () { return name; };
+            };
+            print make()();
+            var self = fun () { return self; };
+            print self() == self;
+        }
+        print name;
+    )");
+}
+
+TEST(OptimizerTest, PrunesBranchesThatNeverRun) {
+    RunResult result = run_optimized(R"(
+        if (false) print "then"; else print "else";
+        if (1 > 2) print "never";
+        while (false) print "never";
+        {
+            var debug = false;
+            if (debug) print "debug";
+        }
+        fun once() {
+            while (true) { print "once"; return; }
+        }
+        once();
+    )");
+    EXPECT_EQ(result.output, "else\nonce\n");
+
+    const auto &stmts = result.program.statements;
+    ASSERT_EQ(stmts.size(), 4);
+    EXPECT_EQ(printed(stmts, 0).kind, ExprKind::LITERAL);
+    auto &block = dynamic_cast<const Stmt::Block &>(*stmts.at(1));
+    EXPECT_EQ(block.statements.size(), 1);
+    auto &once = dynamic_cast<const Stmt::Function &>(*stmts.at(2));
+    EXPECT_EQ(once.body.at(0)->kind, StmtKind::WHILE);
+}
+
+TEST(OptimizerTest, RunsClassesAndLoopsAsBefore) {
+    run_optimized(R"(
+        class Shape {
+            init(sides) { this.sides = sides * (1 + 0); }
+            describe() { return "sides: " + (this.sides + ""); }
+        }
+        class Square < Shape {
+            init() { super.init(2 + 2); }
+        }
+        var total = 0;
+        for (var i = 0; i < 3 + 2; i = i + 1) {
+            var step = 2;
+            total = total + i * step;
+        }
+        print total;
+        print Square().sides;
+    )");
+}
+
+TEST(OptimizerTest, InlinesSmallFunctions) {
+    std::stringstream trace;
+    RunResult result = run_optimized(R"(
+        fun square(x) { return x * x; }
+        fun area(width, height) { return width * height; }
+        fun nothing() {}
+        {
+            var side = 3;
+            print square(side);
+            print area(side, square(2));
+            print nothing();
+        }
+        fun get_x(point) { return point.x; }
+        class Point {
+            init(x) { this.x = x; }
+            next() { return get_x(this) + 1; }
+        }
+        print Point(5).next();
+    )",
+                                     {.trace_inlining = &trace});
+    EXPECT_EQ(result.output, "9\n12\nnull\n6\n");
+    EXPECT_EQ(trace.str(), "inlining: [line 7] square inlined\n"
+                           "inlining: [line 8] square inlined\n"
+                           "inlining: [line 8] area inlined\n"
+                           "inlining: [line 9] nothing inlined\n"
+                           "inlining: [line 14] get_x inlined\n");
+
+    auto &block =
+        dynamic_cast<const Stmt::Block &>(*result.program.statements.at(3));
+    for (size_t i = 1; i < block.statements.size(); ++i) {
+        EXPECT_EQ(printed(block.statements, i).kind, ExprKind::LITERAL);
+    }
+}
+
+TEST(OptimizerTest, KeepsTailCallsOfInlinedCalls) {
+    // Inlining `step` leaves `loop` calling itself, which must still not
+    // grow the stack.
+    RunResult result = run_optimized(R"(
+        fun step(n) { return loop(n - 1); }
+        fun loop(n) {
+            if (n == 0) return "done";
+            return step(n);
+        }
+        print loop(200000);
+    )");
+    EXPECT_EQ(result.output, "done\n");
+}
+
+TEST(OptimizerTest, KeepsCallsItCannotInline) {
+    std::stringstream trace;
+    run_optimized(R"(
+        fun fib(n) {
+            if (n < 2) return n;
+            return fib(n - 1) + fib(n - 2);
+        }
+        fun itself(n) { return itself; }
+        var counter = 0;
+        fun next(n) { return n + counter; }
+        fun add(a, b) { return a + b; }
+        fun reset() { counter = 0; }
+        reset = nil;
+        print fib(10);
+        print itself(1) == itself;
+        {
+            var counter = 10;
+            print next(1);
+            var i = 0;
+            i = i + 1;
+            print add(i, 1);
+            print add(i + 1, 1);
+            var offset = 5;
+            fun shift(x) { return x + offset; }
+            offset = 6;
+            print shift(1);
+            print add(1, 2, 3);
+        }
+    )",
+                  {.trace_inlining = &trace});
+    EXPECT_EQ(trace.str(),
+              "inlining: [line 12] fib not inlined: "
+              "its body is more than a return statement\n"
+              "inlining: [line 13] itself not inlined: it refers to itself\n"
+              "inlining: [line 16] next not inlined: "
+              "a local shadows a global it refers to\n"
+              "inlining: [line 19] add inlined\n"
+              "inlining: [line 20] add not inlined: "
+              "an argument is not a literal, this or a local it keeps\n"
+              "inlining: [line 24] shift not inlined: "
+              "it refers to a local of an enclosing function\n"
+              "inlining: [line 25] add not inlined: "
+              "it is called with the wrong number of arguments\n");
+}
+
+TEST(OptimizerTest, InlinesGlobalFunctionsOnlyInWholePrograms) {
+    const std::string source = R"(
+        fun twice(x) { return x + x; }
+        print twice(2);
+    )";
+    std::stringstream trace;
+    RunResult line = run_optimized(source, {.whole_program = false});
+    EXPECT_EQ(printed(line.program.statements, 1).kind, ExprKind::CALL);
+    RunResult whole = run_optimized(source, {.trace_inlining = &trace});
+    EXPECT_EQ(printed(whole.program.statements, 1).kind, ExprKind::LITERAL);
+    EXPECT_EQ(trace.str(), "inlining: [line 3] twice inlined\n");
+}
+
+TEST(OptimizerTest, MarksCountedLoops) {
+    RunResult result = run_optimized(R"(
+        var limit = 3;
+        for (var i = 0; i < limit; i = i + 1) print i;
+        for (var i = 9; i > limit * 2; i = i - 1) print i;
+        for (var i = 0; i < 4; i = i + 1) { i = i + 1; print i; }
+        for (var i = 0; i < 2; i = i + 1) { var i = 5; print i; }
+        var moving = 2;
+        for (var i = 0; i < moving; i = i + 1) { moving = moving - 0.5; }
+        {
+            var j = 0;
+            while (j < 2) { print j; j = j + 1; }
+            var k = j;
+            while (k > 0) k = k - 1;
+        }
+    )");
+    EXPECT_EQ(result.output, "0\n1\n2\n9\n8\n7\n1\n3\n5\n5\n0\n1\n");
+
+    const auto &stmts = result.program.statements;
+    // The loop of the for statement `index` of `stmts`.
+    auto loop = [&](size_t index) -> const Stmt::While & {
+        auto &block = dynamic_cast<const Stmt::Block &>(*stmts.at(index));
+        return dynamic_cast<const Stmt::While &>(*block.statements.at(1));
+    };
+    EXPECT_TRUE(loop(1).counted.has_value());
+    EXPECT_EQ(loop(1).counted->step, 1);
+    EXPECT_TRUE(loop(2).counted.has_value());
+    EXPECT_EQ(loop(2).counted->step, -1);
+    // The body assigns to the counter.
+    EXPECT_FALSE(loop(3).counted.has_value());
+    // Only a nested block shadows it.
+    EXPECT_TRUE(loop(4).counted.has_value());
+    // The limit changes.
+    EXPECT_FALSE(loop(6).counted.has_value());
+    // A while loop counts too, if its body is a block.
+    EXPECT_TRUE(loop(7).counted.has_value());
+    auto &block = dynamic_cast<const Stmt::Block &>(*stmts.at(7));
+    EXPECT_FALSE(dynamic_cast<const Stmt::While &>(*block.statements.at(3))
+                     .counted.has_value());
+}
+
+TEST(OptimizerTest, DoesNotCountLoopsWhoseCounterAClosureAssigns) {
+    RunResult result = run_optimized(R"(
+        fun f() {
+            var i = 0;
+            fun reset() { i = 100; }
+            while (i < 10) { if (i == 3) reset(); print i; i = i + 1; }
+            print i;
+        }
+        f();
+    )");
+    EXPECT_EQ(result.output, "0\n1\n2\n100\n101\n");
+
+    auto &f =
+        dynamic_cast<const Stmt::Function &>(*result.program.statements.at(0));
+    auto &loop = dynamic_cast<const Stmt::While &>(*f.body.at(2));
+    EXPECT_FALSE(loop.counted.has_value());
+}
@@ -2,23 +2,117 @@
 
 #include "src/logging.h"
 
+#include <algorithm>
+
+namespace {
+
+// Whether evaluating `expr` can make a closure, which would keep the
+// environment it is evaluated in.
+bool makes_closures(const Expr *expr) {
+    if (expr == nullptr) {
+        return false;
+    }
+    switch (expr->kind) {
+    case ExprKind::ASSIGN:
+        return makes_closures(static_cast<const Expr::Assign &>(*expr).value);
+    case ExprKind::BINARY: {
+        const auto &binary = static_cast<const Expr::Binary &>(*expr);
+        return makes_closures(binary.left) or makes_closures(binary.right);
+    }
+    case ExprKind::CALL: {
+        const auto &call = static_cast<const Expr::Call &>(*expr);
+        return makes_closures(call.callee) or
+               std::ranges::any_of(call.arguments, [](const Expr *argument) {
+                   return makes_closures(argument);
+               });
+    }
+    case ExprKind::GET:
+        return makes_closures(static_cast<const Expr::Get &>(*expr).object);
+    case ExprKind::GROUPING:
+        return makes_closures(
+            static_cast<const Expr::Grouping &>(*expr).expression);
+    case ExprKind::LAMBDA:
+        return true;
+    case ExprKind::LOGICAL: {
+        const auto &logical = static_cast<const Expr::Logical &>(*expr);
+        return makes_closures(logical.left) or makes_closures(logical.right);
+    }
+    case ExprKind::SET: {
+        const auto &set = static_cast<const Expr::Set &>(*expr);
+        return makes_closures(set.object) or makes_closures(set.value);
+    }
+    case ExprKind::UNARY:
+        return makes_closures(static_cast<const Expr::Unary &>(*expr).right);
+    case ExprKind::LITERAL:
+    case ExprKind::SUPER:
+    case ExprKind::THIS:
+    case ExprKind::VARIABLE:
+        return false;
+    }
+    return true;
+}
+
+bool makes_closures(const Stmt *stmt) {
+    if (stmt == nullptr) {
+        return false;
+    }
+    switch (stmt->kind) {
+    case StmtKind::BLOCK:
+        return std::ranges::any_of(
+            static_cast<const Stmt::Block &>(*stmt).statements,
+            [](const Stmt *nested) { return makes_closures(nested); });
+    case StmtKind::CLASS:
+    case StmtKind::FUNCTION:
+        return true;
+    case StmtKind::EXPRESSION:
+        return makes_closures(
+            static_cast<const Stmt::Expression &>(*stmt).expression);
+    case StmtKind::IF: {
+        const auto &if_stmt = static_cast<const Stmt::If &>(*stmt);
+        return makes_closures(if_stmt.condition) or
+               makes_closures(if_stmt.then_branch) or
+               makes_closures(if_stmt.else_branch);
+    }
+    case StmtKind::PRINT:
+        return makes_closures(
+            static_cast<const Stmt::Print &>(*stmt).expression);
+    case StmtKind::RETURN:
+        return makes_closures(static_cast<const Stmt::Return &>(*stmt).value);
+    case StmtKind::VAR:
+        return makes_closures(
+            static_cast<const Stmt::Var &>(*stmt).initializer);
+    case StmtKind::WHILE: {
+        const auto &while_stmt = static_cast<const Stmt::While &>(*stmt);
+        return makes_closures(while_stmt.condition) or
+               makes_closures(while_stmt.body);
+    }
+    }
+    return true;
+}
+
+} // namespace
+
 Resolver::Resolver(AbstractInterpreter &interpreter)
-    : interpreter(interpreter), scopes(), current_function(FunctionType::NONE),
+    : interpreter(&interpreter), scopes(), current_function(FunctionType::NONE),
       current_class(ClassType::NONE), m_had_error(false) {}
 
-void Resolver::resolve(const std::shared_ptr<Expr> &expr) {
+Resolver::Resolver()
+    : interpreter(nullptr), scopes(), current_function(FunctionType::NONE),
+      current_class(ClassType::NONE), m_had_error(false) {}
+
+void Resolver::resolve(const Expr *expr) {
     if (expr) {
-        expr->accept(*this);
+        dispatch(*expr, *this);
     }
 }
 
-void Resolver::resolve(const std::shared_ptr<Stmt> &stmt) {
+void Resolver::resolve(const Stmt *stmt) {
     if (stmt) {
-        stmt->accept(*this);
+        dispatch(*stmt, *this);
     }
 }
 
-void Resolver::resolve(const std::vector<std::shared_ptr<Stmt>> &stmts) {
+void Resolver::resolve(const std::pmr::vector<Stmt *> &stmts) {
     for (const auto &stmt : stmts) {
         resolve(stmt);
     }
@@ -28,7 +122,7 @@ bool Resolver::had_error() const { return m_had_error; }
 
 void Resolver::visit_assign_expr(const Expr::Assign &expr) {
     resolve(expr.value);
-    resolve_local(expr, expr.name);
+    resolve_variable(expr, expr.name, expr.global);
 }
 
 void Resolver::visit_binary_expr(const Expr::Binary &expr) {
@@ -97,13 +191,13 @@ void Resolver::visit_variable_expr(const Expr::Variable &var) {
             var.name, "Can't read local variable in its own initializer.");
         return;
     }
-    resolve_local(var, var.name);
+    resolve_variable(var, var.name, var.global);
 }
 
 void Resolver::visit_block_stmt(const Stmt::Block &block) {
-    begin_scope();
+    begin_scope(needs_environment(block));
     resolve(block.statements);
-    end_scope();
+    end_scope(block.statements);
 }
 
 void Resolver::visit_expression_stmt(const Stmt::Expression &stmt) {
@@ -133,9 +227,6 @@ void Resolver::visit_class_stmt(const Stmt::Class &stmt) {
         scopes.back().define("super");
     }
 
-    begin_scope();
-    scopes.back().define("this");
-
     for (const auto &method : stmt.methods) {
         FunctionType function_type = method->name.lexeme == "init"
                                          ? FunctionType::INITIALIZER
@@ -143,8 +234,6 @@ void Resolver::visit_class_stmt(const Stmt::Class &stmt) {
         resolve_function(*method, function_type);
     }
 
-    end_scope();
-
     if (stmt.superclass != nullptr) {
         end_scope();
     }
@@ -180,6 +269,12 @@ void Resolver::visit_return_stmt(const Stmt::Return &stmt) {
                                  "Can't return a value from an initializer.");
         }
         resolve(stmt.value);
+        if (interpreter != nullptr and
+            current_function != FunctionType::INITIALIZER and
+            stmt.value->kind == ExprKind::CALL) {
+            interpreter->resolve_tail_call(
+                static_cast<const Expr::Call &>(*stmt.value));
+        }
     }
 }
 
@@ -196,10 +291,43 @@ void Resolver::visit_while_stmt(const Stmt::While &stmt) {
     resolve(stmt.body);
 }
 
-void Resolver::begin_scope() { scopes.emplace_back(); }
+void Resolver::begin_scope(bool has_environment) {
+    if (has_environment or scopes.empty()) {
+        scopes.emplace_back(has_environment);
+    } else {
+        scopes.emplace_back(false, scopes.back().size());
+    }
+}
 
 void Resolver::end_scope() { scopes.pop_back(); }
 
+void Resolver::end_scope(const std::pmr::vector<Stmt *> &body) {
+    const Scope &scope = scopes.back();
+    if (!scope.has_environment()) {
+        if (scopes.size() > 1) {
+            scopes[scopes.size() - 2].make_room_for(scope);
+        }
+    } else if (interpreter != nullptr) {
+        interpreter->resolve_scope(body, scope.size());
+    }
+    end_scope();
+}
+
+bool Resolver::needs_environment(const Stmt::Block &block) const {
+    bool declares_locals =
+        std::ranges::any_of(block.statements, [](const Stmt *stmt) {
+            return stmt->kind == StmtKind::VAR or
+                   stmt->kind == StmtKind::FUNCTION or
+                   stmt->kind == StmtKind::CLASS;
+        });
+    if (!declares_locals) {
+        return false;
+    }
+    bool in_local_environment =
+        std::ranges::any_of(scopes, &Scope::has_environment);
+    return !in_local_environment or makes_closures(&block);
+}
+
 void Resolver::declare(const Token &var) {
     if (scopes.empty()) {
         return;
@@ -212,6 +340,9 @@ void Resolver::declare(const Token &var) {
     }
 
     scope.declare(var.lexeme);
+    if (interpreter != nullptr) {
+        interpreter->resolve_declaration(var, scope.slot(var.lexeme));
+    }
 }
 
 void Resolver::define(const Token &var) {
@@ -223,13 +354,31 @@ void Resolver::define(const Token &var) {
     scope.define(var.lexeme);
 }
 
-void Resolver::resolve_local(const Expr &expr, const Token &token) {
+bool Resolver::resolve_local(const Expr &expr, const Token &token) {
+    // The number of environments between the current one and the one the
+    // variable is in.
+    int depth = 0;
     for (auto scope_it = scopes.rbegin(); scope_it != scopes.rend();
          ++scope_it) {
         if (scope_it->in_scope(token.lexeme)) {
-            interpreter.resolve(&expr,
-                                static_cast<int>(scope_it - scopes.rbegin()));
+            if (interpreter != nullptr) {
+                interpreter->resolve(&expr, depth,
+                                     scope_it->slot(token.lexeme));
+            }
+            // The innermost declaration shadows the outer ones.
+            return true;
         }
+        if (scope_it->has_environment()) {
+            ++depth;
+        }
+    }
+    return false;
+}
+
+void Resolver::resolve_variable(const Expr &expr, const Token &token,
+                                GlobalCache &global) {
+    if (!resolve_local(expr, token) and interpreter != nullptr) {
+        interpreter->resolve_global(global, token.lexeme);
     }
 }
 
@@ -238,19 +387,24 @@ void Resolver::resolve_function(const Stmt::Function &function,
     resolve_function(function.params, function.body, type);
 }
 
-void Resolver::resolve_function(const std::vector<Token> &params,
-                                const std::vector<std::shared_ptr<Stmt>> &body,
+void Resolver::resolve_function(const std::pmr::vector<Token> &params,
+                                const std::pmr::vector<Stmt *> &body,
                                 FunctionType type) {
     FunctionType enclosing_function = current_function;
     current_function = type;
 
     begin_scope();
+    if (type == FunctionType::METHOD or type == FunctionType::INITIALIZER) {
+        // Methods take their receiver in slot 0 of their own frame, so
+        // calling one does not need a bound copy of it.
+        scopes.back().define("this");
+    }
     for (const Token &param : params) {
         declare(param);
         define(param);
     }
     resolve(body);
-    end_scope();
+    end_scope(body);
 
     current_function = enclosing_function;
 }
@@ -264,17 +418,43 @@ std::string Resolver::report_resolve_error(const Token &token,
     return report_token_error(token, message);
 }
 
-void Scope::declare(const std::string &name) { map[name] = false; }
+Scope::Scope(bool has_environment, size_t first_slot)
+    : map(), m_has_environment(has_environment), next_slot(first_slot) {}
 
-void Scope::define(const std::string &name) { map[name] = true; }
+void Scope::declare(std::string_view name) {
+    auto [it, inserted] = map.try_emplace(name, Variable{false, next_slot});
+    if (inserted) {
+        ++next_slot;
+    }
+    it->second.defined = false;
+}
 
-bool Scope::in_scope(const std::string &name) const {
+void Scope::define(std::string_view name) {
+    auto [it, inserted] = map.try_emplace(name, Variable{true, next_slot});
+    if (inserted) {
+        ++next_slot;
+    }
+    it->second.defined = true;
+}
+
+bool Scope::in_scope(std::string_view name) const {
     return map.contains(name);
 }
 
-VariableStatus Scope::check_scope(const std::string &name) const {
+VariableStatus Scope::check_scope(std::string_view name) const {
     if (!in_scope(name)) {
         return VariableStatus::UNKNOWN;
     }
-    return map.at(name) ? VariableStatus::DEFINED : VariableStatus::DECLARED;
+    return map.at(name).defined ? VariableStatus::DEFINED
+                                : VariableStatus::DECLARED;
+}
+
+size_t Scope::slot(std::string_view name) const { return map.at(name).slot; }
+
+size_t Scope::size() const { return next_slot; }
+
+void Scope::make_room_for(const Scope &nested) {
+    next_slot = std::max(next_slot, nested.next_slot);
 }
+
+bool Scope::has_environment() const { return m_has_environment; }
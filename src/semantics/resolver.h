@@ -4,32 +4,58 @@
 #include "src/syntactics/expr.h"
 #include "src/syntactics/stmt.h"
 
-#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 enum class VariableStatus { UNKNOWN, DECLARED, DEFINED };
 
 struct Scope {
-    Scope() = default;
+    // A scope without an environment of its own keeps its locals in the one
+    // enclosing it, from `first_slot` on.
+    explicit Scope(bool has_environment = true, size_t first_slot = 0);
 
-    void declare(const std::string &name);
-    void define(const std::string &name);
+    void declare(std::string_view name);
+    void define(std::string_view name);
 
-    bool in_scope(const std::string &name) const;
-    VariableStatus check_scope(const std::string &name) const;
+    bool in_scope(std::string_view name) const;
+    VariableStatus check_scope(std::string_view name) const;
+
+    // The environment slot of a variable in this scope. Slots are handed out
+    // in declaration order.
+    size_t slot(std::string_view name) const;
+    // The slot the next variable declared in the environment takes, which
+    // for a scope with an environment is the number of slots it needs.
+    size_t size() const;
+
+    // Hands the slots taken by `nested`, which shares this scope's
+    // environment, on to the variables declared here after it.
+    void make_room_for(const Scope &nested);
+
+    bool has_environment() const;
 
   private:
-    std::unordered_map<std::string, bool> map;
+    struct Variable {
+        bool defined;
+        size_t slot;
+    };
+
+    // Names view the source of the program being resolved.
+    std::unordered_map<std::string_view, Variable> map;
+    bool m_has_environment;
+    size_t next_slot;
 };
 
 struct Resolver final : ExprVisitor, StmtVisitor {
     Resolver(AbstractInterpreter &interpreter);
+    // Only reports static errors, for engines that do their own name
+    // resolution (e.g. the bytecode compiler).
+    Resolver();
 
-    void resolve(const std::shared_ptr<Expr> &expr);
-    void resolve(const std::shared_ptr<Stmt> &stmt);
-    void resolve(const std::vector<std::shared_ptr<Stmt>> &stmts);
+    void resolve(const Expr *expr);
+    void resolve(const Stmt *stmt);
+    void resolve(const std::pmr::vector<Stmt *> &stmts);
 
     bool had_error() const;
 
@@ -43,6 +69,12 @@ struct Resolver final : ExprVisitor, StmtVisitor {
 
     enum class ClassType { NONE, CLASS, SUBCLASS };
 
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
     void visit_assign_expr(const Expr::Assign &expr) override;
     void visit_binary_expr(const Expr::Binary &expr) override;
     void visit_call_expr(const Expr::Call &expr) override;
@@ -67,24 +99,33 @@ struct Resolver final : ExprVisitor, StmtVisitor {
     void visit_var_stmt(const Stmt::Var &stmt) override;
     void visit_while_stmt(const Stmt::While &stmt) override;
 
-    void begin_scope();
+    void begin_scope(bool has_environment = true);
     void end_scope();
+    void end_scope(const std::pmr::vector<Stmt *> &body);
 
     void declare(const Token &var);
     void define(const Token &var);
 
-    void resolve_local(const Expr &expr, const Token &token);
+    // Whether `block` needs an environment of its own: it declares locals
+    // and some closure might capture them, or there is no local environment
+    // around it to keep them in.
+    bool needs_environment(const Stmt::Block &block) const;
+
+    // Returns whether `token` names a local variable.
+    bool resolve_local(const Expr &expr, const Token &token);
+    void resolve_variable(const Expr &expr, const Token &token,
+                          GlobalCache &global);
 
     void resolve_function(const Stmt::Function &function, FunctionType type);
-    void resolve_function(const std::vector<Token> &params,
-                          const std::vector<std::shared_ptr<Stmt>> &body,
+    void resolve_function(const std::pmr::vector<Token> &params,
+                          const std::pmr::vector<Stmt *> &body,
                           FunctionType type);
 
     std::string report_resolve_error(const Token &token,
                                      const std::string &message,
                                      bool warning = false);
 
-    AbstractInterpreter &interpreter;
+    AbstractInterpreter *interpreter;
     std::vector<Scope> scopes;
     FunctionType current_function;
     ClassType current_class;
@@ -1,3 +0,0 @@
-#include "src/semantics/return.h"
-
-Return::Return(LoxObject obj) : return_value(std::move(obj)) {}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "src/semantics/testing.h"
+
+#include "src/syntactics/parser.h"
+#include "src/syntactics/scanner.h"
+
+CapturedOutput::CapturedOutput()
+    : output(), cout_buf(std::cout.rdbuf(output.rdbuf())),
+      cerr_buf(std::cerr.rdbuf(output.rdbuf())) {}
+
+CapturedOutput::~CapturedOutput() {
+    std::cout.rdbuf(cout_buf);
+    std::cerr.rdbuf(cerr_buf);
+}
+
+std::string CapturedOutput::str() const { return output.str(); }
+
+Program parse(const std::string &source) {
+    Parser parser(Scanner(std::stringstream{source}));
+    return parser.parse();
+}
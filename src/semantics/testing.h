@@ -0,0 +1,95 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "src/semantics/abstract_interpreter.h"
+#include "src/semantics/garbage_collector.h"
+#include "src/semantics/interpreter.h"
+#include "src/semantics/optimizer.h"
+#include "src/semantics/resolver.h"
+#include "src/syntactics/program.h"
+
+#include <concepts>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+// Helpers for tests that run Lox source on an engine.
+
+// Redirects std::cout and std::cerr into a string while it lives.
+struct CapturedOutput {
+    CapturedOutput();
+    ~CapturedOutput();
+
+    CapturedOutput(const CapturedOutput &) = delete;
+    CapturedOutput &operator=(const CapturedOutput &) = delete;
+
+    std::string str() const;
+
+  private:
+    std::stringstream output;
+    std::streambuf *cout_buf;
+    std::streambuf *cerr_buf;
+};
+
+Program parse(const std::string &source);
+
+struct RunResult {
+    // Kept so that tests can inspect what the engine, or the Optimizer, made
+    // of it.
+    Program program;
+    // Everything the engine wrote to stdout and stderr.
+    std::string output;
+};
+
+// Parses and resolves `source`, runs it through an Optimizer with
+// `optimizer`, if given, and then on `engine`.
+template <typename Engine>
+RunResult run_on(Engine &engine, const std::string &source,
+                 std::optional<OptimizerSettings> optimizer = std::nullopt) {
+    CapturedOutput output;
+    RunResult result{parse(source), ""};
+    AbstractInterpreter *interpreter = nullptr;
+    if constexpr (std::derived_from<Engine, AbstractInterpreter>) {
+        interpreter = &engine;
+        Resolver{engine}.resolve(result.program.statements);
+    } else {
+        Resolver{}.resolve(result.program.statements);
+    }
+    if (optimizer.has_value()) {
+        Optimizer(*result.program.arena, interpreter, *optimizer)
+            .optimize(result.program.statements);
+    }
+    engine.interpret(result.program.statements);
+    result.output = output.str();
+    return result;
+}
+
+// Like run_on(), on a fresh engine, which collects garbage with
+// `gc_settings` if it is one of the tree-walking ones.
+template <typename Engine>
+RunResult run(const std::string &source,
+              std::optional<OptimizerSettings> optimizer = std::nullopt,
+              const GcSettings &gc_settings = {}) {
+    Engine engine;
+    if constexpr (std::derived_from<Engine, AbstractInterpreter>) {
+        engine.configure_gc(gc_settings);
+    }
+    return run_on(engine, source, optimizer);
+}
+
+// Expects `source` to print the same on Engine as on the Interpreter, both
+// running it through the Optimizer first if `optimize`, which marks the loops
+// that the engines run with a native counter.
+template <typename Engine>
+void expect_same_output(const std::string &source, bool optimize = false) {
+    std::optional<OptimizerSettings> optimizer;
+    if (optimize) {
+        optimizer.emplace();
+    }
+    EXPECT_EQ(run<Engine>(source, optimizer).output,
+              run<Interpreter>(source, optimizer).output)
+        << "for program:\n"
+        << source;
+}
@@ -0,0 +1,25 @@
+#include "src/syntactics/ast_arena.h"
+
+namespace {
+
+// Most programs fit in the first block; later ones grow geometrically.
+constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+} // namespace
+
+AstArena::AstArena() : AstArena(INITIAL_BLOCK_SIZE) {}
+
+AstArena::AstArena(size_t initial_block_size)
+    : buffer(initial_block_size), destructors() {}
+
+std::string_view AstArena::copy(std::string_view text) {
+    char *memory = static_cast<char *>(buffer.allocate(text.size(), 1));
+    text.copy(memory, text.size());
+    return {memory, text.size()};
+}
+
+AstArena::~AstArena() {
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+        it->destroy(it->node);
+    }
+}
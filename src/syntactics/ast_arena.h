@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Owns the nodes of a parsed program. Nodes, and the lists they hold, are
+// bump-allocated from a few large blocks, which are freed together with the
+// arena. Nodes are referred to by plain pointers, valid as long as the arena.
+struct AstArena {
+    AstArena();
+    // For when the nodes are known to be few, e.g. a single declaration.
+    explicit AstArena(size_t initial_block_size);
+    // Destroys every node, in reverse order of creation.
+    ~AstArena();
+
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    template <typename Node, typename... Args>
+    Node *make(Args &&...args) {
+        void *memory = buffer.allocate(sizeof(Node), alignof(Node));
+        Node *node = new (memory) Node(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<Node>) {
+            destructors.push_back(
+                {node, [](void *node) { static_cast<Node *>(node)->~Node(); }});
+        }
+        return node;
+    }
+
+    // A copy of `text` in the arena, for text that is in no source, like the
+    // value of a string constant the optimizer folded.
+    std::string_view copy(std::string_view text);
+
+    // An empty list whose elements go in the arena.
+    template <typename T>
+    std::pmr::vector<T> list() {
+        return std::pmr::vector<T>(&buffer);
+    }
+
+  private:
+    struct Destructor {
+        void *node;
+        void (*destroy)(void *);
+    };
+
+    std::pmr::monotonic_buffer_resource buffer;
+    std::vector<Destructor> destructors;
+};
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "src/syntactics/ast_arena.h"
+#include "src/syntactics/parser.h"
+#include "src/syntactics/scanner.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Appends its id to `log` when destroyed.
+struct Logged {
+    Logged(int id, std::vector<int> &log) : id(id), log(log) {}
+    ~Logged() { log.push_back(id); }
+
+    int id;
+    std::vector<int> &log;
+};
+
+} // namespace
+
+TEST(AstArenaTest, DestroysNodesInReverseOrder) {
+    std::vector<int> log;
+    {
+        AstArena arena;
+        arena.make<Logged>(1, log);
+        arena.make<Logged>(2, log);
+        EXPECT_TRUE(log.empty());
+    }
+    EXPECT_EQ(log, (std::vector<int>{2, 1}));
+}
+
+TEST(AstArenaTest, ListsAllocateFromTheArena) {
+    AstArena arena;
+    auto list = arena.list<int *>();
+    list.push_back(arena.make<int>(7));
+    EXPECT_EQ(*list.front(), 7);
+
+    auto moved = std::move(list);
+    EXPECT_EQ(moved.get_allocator(), arena.list<int *>().get_allocator());
+}
+
+TEST(AstArenaTest, ParsedProgramOwnsItsNodes) {
+    Scanner scanner(std::stringstream{
+        "fun f(a, b) { return a + b; } print f(1, 2);"});
+    Program program = Parser(std::move(scanner)).parse();
+    ASSERT_EQ(program.statements.size(), 2);
+
+    auto &function = dynamic_cast<const Stmt::Function &>(
+        *program.statements.at(0));
+    EXPECT_EQ(function.params.size(), 2);
+    EXPECT_EQ(function.params.get_allocator(),
+              program.statements.get_allocator());
+    auto &ret = dynamic_cast<const Stmt::Return &>(*function.body.at(0));
+    EXPECT_EQ(ret.value->kind, ExprKind::BINARY);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// The operand types a Binary node has specialised itself to. A node starts
+// UNINITIALIZED and specialises on the operands of its first evaluation; a
+// specialised node whose operands stop matching falls back to GENERIC for
+// good, so it cannot flip back and forth.
+enum class BinarySpecialization : uint8_t {
+    UNINITIALIZED,
+    // Both operands are numbers: arithmetic, comparisons and equality.
+    NUMBER,
+    // Both operands are strings: concatenation.
+    STRING,
+    GENERIC,
+};
+
+inline std::string_view to_string(BinarySpecialization specialization) {
+    switch (specialization) {
+    case BinarySpecialization::UNINITIALIZED:
+        return "uninitialized";
+    case BinarySpecialization::NUMBER:
+        return "number";
+    case BinarySpecialization::STRING:
+        return "string";
+    case BinarySpecialization::GENERIC:
+    default:
+        return "generic";
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Finding where runs of characters the scanner skips over end. Each function
+// returns the index of the first character at or after `from` that is not
+// part of the run, or text.size() if the run goes to the end. Where SSE2 is
+// available they look at 16 characters at a time, and go one at a time near
+// the end of the text so that they never read past it.
+namespace char_runs {
+
+enum CharClass : uint8_t {
+    DIGIT = 1 << 0,
+    // Letters and '_'.
+    ALPHA = 1 << 1,
+    // Whitespace other than '\n', which the scanner counts lines by.
+    BLANK = 1 << 2,
+};
+
+inline constexpr std::array<uint8_t, 256> classes = [] {
+    std::array<uint8_t, 256> table{};
+    for (int c = '0'; c <= '9'; ++c)
+        table[c] = DIGIT;
+    for (int c = 'a'; c <= 'z'; ++c)
+        table[c] = ALPHA;
+    for (int c = 'A'; c <= 'Z'; ++c)
+        table[c] = ALPHA;
+    table['_'] = ALPHA;
+    table[' '] = BLANK;
+    table['\r'] = BLANK;
+    table['\t'] = BLANK;
+    return table;
+}();
+
+inline bool is(char c, uint8_t char_class) {
+    return classes[static_cast<unsigned char>(c)] & char_class;
+}
+
+#if defined(__SSE2__)
+namespace detail {
+
+constexpr size_t WIDTH = sizeof(__m128i);
+
+inline __m128i load(std::string_view text, size_t at) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + at));
+}
+
+// Lanes of `chars` in [low, low + count), for count < 128. SSE2 only compares
+// signed bytes, so the range is shifted to start at -128.
+inline __m128i in_range(__m128i chars, char low, char count) {
+    __m128i shifted = _mm_add_epi8(chars, _mm_set1_epi8(-128 - low));
+    return _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + count));
+}
+
+// Whether any lane of `lanes` is set, and if so, the index of the first one
+// counted from `at`.
+inline bool first_set(__m128i lanes, size_t at, size_t &index) {
+    int mask = _mm_movemask_epi8(lanes);
+    if (mask == 0)
+        return false;
+    index = at + __builtin_ctz(mask);
+    return true;
+}
+
+} // namespace detail
+#endif
+
+// Skips ' ', '\r' and '\t'.
+inline size_t skip_blanks(std::string_view text, size_t from) {
+#if defined(__SSE2__)
+    for (size_t index; from + detail::WIDTH <= text.size();
+         from += detail::WIDTH) {
+        __m128i chars = detail::load(text, from);
+        __m128i blanks = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r'))),
+            _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t')));
+        __m128i others = _mm_xor_si128(blanks, _mm_set1_epi8(-1));
+        if (detail::first_set(others, from, index))
+            return index;
+    }
+#endif
+    while (from < text.size() and is(text[from], BLANK))
+        ++from;
+    return from;
+}
+
+// Skips letters, digits and '_'.
+inline size_t skip_identifier(std::string_view text, size_t from) {
+#if defined(__SSE2__)
+    for (size_t index; from + detail::WIDTH <= text.size();
+         from += detail::WIDTH) {
+        __m128i chars = detail::load(text, from);
+        // Setting 0x20 lowercases letters, and moves no other character onto
+        // one.
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        __m128i identifier = _mm_or_si128(
+            _mm_or_si128(detail::in_range(lower, 'a', 26),
+                         detail::in_range(chars, '0', 10)),
+            _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')));
+        __m128i others = _mm_xor_si128(identifier, _mm_set1_epi8(-1));
+        if (detail::first_set(others, from, index))
+            return index;
+    }
+#endif
+    while (from < text.size() and is(text[from], ALPHA | DIGIT))
+        ++from;
+    return from;
+}
+
+// Skips to the '\n' that ends the line.
+inline size_t find_line_end(std::string_view text, size_t from) {
+#if defined(__SSE2__)
+    for (size_t index; from + detail::WIDTH <= text.size();
+         from += detail::WIDTH) {
+        __m128i chars = detail::load(text, from);
+        if (detail::first_set(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')), from,
+                              index))
+            return index;
+    }
+#endif
+    while (from < text.size() and text[from] != '\n')
+        ++from;
+    return from;
+}
+
+// Skips to the '"' that ends a string, or to a '\n' inside it.
+inline size_t find_string_end(std::string_view text, size_t from) {
+#if defined(__SSE2__)
+    for (size_t index; from + detail::WIDTH <= text.size();
+         from += detail::WIDTH) {
+        __m128i chars = detail::load(text, from);
+        __m128i ends =
+            _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('"')),
+                         _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+        if (detail::first_set(ends, from, index))
+            return index;
+    }
+#endif
+    while (from < text.size() and text[from] != '"' and text[from] != '\n')
+        ++from;
+    return from;
+}
+
+} // namespace char_runs
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "src/syntactics/char_runs.h"
+
+#include <cctype>
+#include <string>
+
+namespace {
+
+// Runs of every length up to a few vectors, each followed by `end`, so that
+// the run ends within a vector, on its edge, and in the characters after the
+// last whole vector.
+void expect_runs_end(size_t (*skip)(std::string_view, size_t), char in_run,
+                     char end) {
+    for (size_t prefix = 0; prefix < 3; ++prefix) {
+        for (size_t length = 0; length < 50; ++length) {
+            std::string text = std::string(prefix, end) +
+                               std::string(length, in_run) + end + "  ";
+            EXPECT_EQ(skip(text, prefix), prefix + length)
+                << "prefix " << prefix << ", length " << length;
+
+            std::string unended =
+                std::string(prefix, end) + std::string(length, in_run);
+            EXPECT_EQ(skip(unended, prefix), unended.size())
+                << "prefix " << prefix << ", length " << length;
+        }
+    }
+}
+
+} // namespace
+
+TEST(CharRunsTest, SkipsBlanks) {
+    expect_runs_end(char_runs::skip_blanks, ' ', '\n');
+    expect_runs_end(char_runs::skip_blanks, '\t', 'x');
+    EXPECT_EQ(char_runs::skip_blanks(" \r\t \t\t\r   \r  \t  \t  \t\n", 0), 20);
+}
+
+TEST(CharRunsTest, SkipsIdentifiers) {
+    expect_runs_end(char_runs::skip_identifier, 'a', ' ');
+    expect_runs_end(char_runs::skip_identifier, 'Z', '(');
+    expect_runs_end(char_runs::skip_identifier, '_', '.');
+
+    std::string identifier = "abcxyzABCXYZ_0189";
+    for (char c = 1; c > 0; ++c) {
+        bool in_identifier = identifier.find(c) != std::string::npos or
+                             std::isalnum(c);
+        std::string text = identifier + identifier + c;
+        EXPECT_EQ(char_runs::skip_identifier(text, 0),
+                  text.size() - (in_identifier ? 0 : 1))
+            << "char " << int(c);
+    }
+    // Bytes of UTF-8 characters end identifiers, as they did when the scanner
+    // checked isalnum.
+    EXPECT_EQ(char_runs::skip_identifier("abcdefghijklmnopq\xc3\xa9z", 0), 17);
+}
+
+TEST(CharRunsTest, FindsLineEnds) {
+    expect_runs_end(char_runs::find_line_end, '/', '\n');
+    expect_runs_end(char_runs::find_line_end, '"', '\n');
+}
+
+TEST(CharRunsTest, FindsStringEnds) {
+    expect_runs_end(char_runs::find_string_end, 'a', '"');
+    expect_runs_end(char_runs::find_string_end, ' ', '\n');
+}
+
+TEST(CharRunsTest, ClassifiesCharacters) {
+    EXPECT_TRUE(char_runs::is('7', char_runs::DIGIT));
+    EXPECT_FALSE(char_runs::is('7', char_runs::ALPHA));
+    EXPECT_TRUE(char_runs::is('_', char_runs::ALPHA));
+    EXPECT_TRUE(char_runs::is('q', char_runs::ALPHA | char_runs::DIGIT));
+    EXPECT_TRUE(char_runs::is('\r', char_runs::BLANK));
+    EXPECT_FALSE(char_runs::is('\n', char_runs::BLANK));
+    EXPECT_FALSE(char_runs::is('\xe9', char_runs::ALPHA));
+}
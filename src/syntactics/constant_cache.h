@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Where an engine keeps the value it made of a literal, cached on the literal
+// so that evaluating it again makes nothing. The index is only meaningful to
+// the engine whose id is `engine_id`.
+struct ConstantCache {
+    static constexpr uint64_t NO_ENGINE = UINT64_MAX;
+
+    bool valid_for(uint64_t id) const { return engine_id == id; }
+
+    uint64_t engine_id = NO_ENGINE;
+    size_t index = 0;
+};
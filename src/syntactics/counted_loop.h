@@ -0,0 +1,20 @@
+#pragma once
+
+#include "src/syntactics/expr.h"
+#include "src/syntactics/token.h"
+
+// A while loop that counts a local number towards a limit. Its condition
+// compares the local, on its left, with an expression that evaluates the same
+// on every iteration, and its body is a block whose last statement adds a
+// number to the local and is the only one in the program that assigns to it.
+// The Optimizer sets Stmt::While::counted to one of these when it finds such
+// a loop, for engines to run it with the counter in a C++ double rather than
+// by evaluating the condition and the last statement of the body.
+struct CountedLoop {
+    const Expr::Variable *counter;
+    const Expr *limit;
+    // One of <, <=, > and >=.
+    TokenType comparison;
+    // What the last statement of the body adds to the counter.
+    double step;
+};
@@ -1,69 +1,68 @@
 #include "src/syntactics/expr.h"
 
-Expr::Assign::Assign(Token name, std::shared_ptr<Expr> value)
-    : name(std::move(name)), value(std::move(value)) {}
+Expr::Assign::Assign(Token name, Expr *value)
+    : Expr(ExprKind::ASSIGN), name(std::move(name)), value(std::move(value)) {}
 
 void Expr::Assign::accept(ExprVisitor &visitor) const {
     visitor.visit_assign_expr(*this);
 }
 
-Expr::Binary::Binary(std::shared_ptr<Expr> left, Token op,
-                     std::shared_ptr<Expr> right)
-    : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+Expr::Binary::Binary(Expr *left, Token op, Expr *right)
+    : Expr(ExprKind::BINARY), left(std::move(left)), op(std::move(op)),
+      right(std::move(right)) {}
 
 void Expr::Binary::accept(ExprVisitor &visitor) const {
     visitor.visit_binary_expr(*this);
 }
 
-Expr::Call::Call(std::shared_ptr<Expr> callee, Token paren,
-                 std::vector<std::shared_ptr<Expr>> arguments)
-    : callee(std::move(callee)), paren(std::move(paren)),
+Expr::Call::Call(Expr *callee, Token paren, std::pmr::vector<Expr *> arguments)
+    : Expr(ExprKind::CALL), callee(std::move(callee)), paren(std::move(paren)),
       arguments(std::move(arguments)) {}
 
 void Expr::Call::accept(ExprVisitor &visitor) const {
     visitor.visit_call_expr(*this);
 }
 
-Expr::Get::Get(std::shared_ptr<Expr> object, Token name)
-    : object(std::move(object)), name(std::move(name)) {}
+Expr::Get::Get(Expr *object, Token name)
+    : Expr(ExprKind::GET), object(std::move(object)), name(std::move(name)) {}
 
 void Expr::Get::accept(ExprVisitor &visitor) const {
     visitor.visit_get_expr(*this);
 }
 
-Expr::Grouping::Grouping(std::shared_ptr<Expr> expression)
-    : expression(std::move(expression)) {}
+Expr::Grouping::Grouping(Expr *expression)
+    : Expr(ExprKind::GROUPING), expression(std::move(expression)) {}
 
 void Expr::Grouping::accept(ExprVisitor &visitor) const {
     visitor.visit_grouping_expr(*this);
 }
 
-Expr::Lambda::Lambda(Token keyword, std::vector<Token> params,
-                     std::vector<std::shared_ptr<Stmt>> body)
-    : keyword(std::move(keyword)), params(std::move(params)),
-      body(std::move(body)) {}
+Expr::Lambda::Lambda(Token keyword, std::pmr::vector<Token> params,
+                     std::pmr::vector<Stmt *> body)
+    : Expr(ExprKind::LAMBDA), keyword(std::move(keyword)),
+      params(std::move(params)), body(std::move(body)) {}
 
 void Expr::Lambda::accept(ExprVisitor &visitor) const {
     visitor.visit_lambda_expr(*this);
 }
 
-Expr::Literal::Literal(Token value) : value(std::move(value)) {}
+Expr::Literal::Literal(Token value)
+    : Expr(ExprKind::LITERAL), value(std::move(value)) {}
 
 void Expr::Literal::accept(ExprVisitor &visitor) const {
     visitor.visit_literal_expr(*this);
 }
 
-Expr::Logical::Logical(std::shared_ptr<Expr> left, Token op,
-                       std::shared_ptr<Expr> right)
-    : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+Expr::Logical::Logical(Expr *left, Token op, Expr *right)
+    : Expr(ExprKind::LOGICAL), left(std::move(left)), op(std::move(op)),
+      right(std::move(right)) {}
 
 void Expr::Logical::accept(ExprVisitor &visitor) const {
     visitor.visit_logical_expr(*this);
 }
 
-Expr::Set::Set(std::shared_ptr<Expr> object, Token name,
-               std::shared_ptr<Expr> value)
-    : object(std::move(object)), name(std::move(name)),
+Expr::Set::Set(Expr *object, Token name, Expr *value)
+    : Expr(ExprKind::SET), object(std::move(object)), name(std::move(name)),
       value(std::move(value)) {}
 
 void Expr::Set::accept(ExprVisitor &visitor) const {
@@ -71,26 +70,29 @@ void Expr::Set::accept(ExprVisitor &visitor) const {
 }
 
 Expr::Super::Super(Token keyword, Token method)
-    : keyword(std::move(keyword)), method(std::move(method)) {}
+    : Expr(ExprKind::SUPER), keyword(std::move(keyword)),
+      method(std::move(method)) {}
 
 void Expr::Super::accept(ExprVisitor &visitor) const {
     visitor.visit_super_expr(*this);
 }
 
-Expr::This::This(Token keyword) : keyword(std::move(keyword)) {}
+Expr::This::This(Token keyword)
+    : Expr(ExprKind::THIS), keyword(std::move(keyword)) {}
 
 void Expr::This::accept(ExprVisitor &visitor) const {
     visitor.visit_this_expr(*this);
 }
 
-Expr::Unary::Unary(Token op, std::shared_ptr<Expr> right)
-    : op(std::move(op)), right(std::move(right)) {}
+Expr::Unary::Unary(Token op, Expr *right)
+    : Expr(ExprKind::UNARY), op(std::move(op)), right(std::move(right)) {}
 
 void Expr::Unary::accept(ExprVisitor &visitor) const {
     visitor.visit_unary_expr(*this);
 }
 
-Expr::Variable::Variable(Token name) : name(std::move(name)) {}
+Expr::Variable::Variable(Token name)
+    : Expr(ExprKind::VARIABLE), name(std::move(name)) {}
 
 void Expr::Variable::accept(ExprVisitor &visitor) const {
     visitor.visit_variable_expr(*this);
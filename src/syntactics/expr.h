@@ -1,15 +1,36 @@
 #pragma once
+#include "src/syntactics/binary_specialization.h"
+#include "src/syntactics/constant_cache.h"
+#include "src/syntactics/global_cache.h"
+#include "src/syntactics/property_cache.h"
 #include "src/syntactics/stmt.fwd.h"
 #include "src/syntactics/token.h"
-#include <memory>
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 
 struct ExprVisitor;
 
+enum class ExprKind : uint8_t {
+    ASSIGN,
+    BINARY,
+    CALL,
+    GET,
+    GROUPING,
+    LAMBDA,
+    LITERAL,
+    LOGICAL,
+    SET,
+    SUPER,
+    THIS,
+    UNARY,
+    VARIABLE,
+};
+
 struct Expr {
     virtual void accept(ExprVisitor &visitor) const = 0;
 
-    Expr() = default;
+    explicit Expr(ExprKind kind) : kind(kind) {}
     Expr(const Expr &) = default;
     Expr &operator=(const Expr &) = default;
     Expr(Expr &&) = default;
@@ -17,6 +38,9 @@ struct Expr {
 
     virtual ~Expr() = default;
 
+    // The concrete type of the node, for dispatch().
+    ExprKind kind;
+
     struct Assign;
     struct Binary;
     struct Call;
@@ -33,71 +57,75 @@ struct Expr {
 };
 
 struct Expr::Assign : Expr {
-    Assign(Token name, std::shared_ptr<Expr> value);
+    Assign(Token name, Expr *value);
     virtual void accept(ExprVisitor &visitor) const override;
     Token name;
-    std::shared_ptr<Expr> value;
+    Expr *value;
+    mutable GlobalCache global{};
 };
 
 struct Expr::Binary : Expr {
-    Binary(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right);
+    Binary(Expr *left, Token op, Expr *right);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> left;
+    Expr *left;
     Token op;
-    std::shared_ptr<Expr> right;
+    Expr *right;
+    mutable BinarySpecialization specialization{};
 };
 
 struct Expr::Call : Expr {
-    Call(std::shared_ptr<Expr> callee, Token paren,
-         std::vector<std::shared_ptr<Expr>> arguments);
+    Call(Expr *callee, Token paren, std::pmr::vector<Expr *> arguments);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> callee;
+    Expr *callee;
     Token paren;
-    std::vector<std::shared_ptr<Expr>> arguments;
+    std::pmr::vector<Expr *> arguments;
 };
 
 struct Expr::Get : Expr {
-    Get(std::shared_ptr<Expr> object, Token name);
+    Get(Expr *object, Token name);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> object;
+    Expr *object;
     Token name;
+    mutable PropertyCache cache{};
 };
 
 struct Expr::Grouping : Expr {
-    Grouping(std::shared_ptr<Expr> expression);
+    Grouping(Expr *expression);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> expression;
+    Expr *expression;
 };
 
 struct Expr::Lambda : Expr {
-    Lambda(Token keyword, std::vector<Token> params,
-           std::vector<std::shared_ptr<Stmt>> body);
+    Lambda(Token keyword, std::pmr::vector<Token> params,
+           std::pmr::vector<Stmt *> body);
     virtual void accept(ExprVisitor &visitor) const override;
     Token keyword;
-    std::vector<Token> params;
-    std::vector<std::shared_ptr<Stmt>> body;
+    std::pmr::vector<Token> params;
+    std::pmr::vector<Stmt *> body;
 };
 
 struct Expr::Literal : Expr {
     Literal(Token value);
     virtual void accept(ExprVisitor &visitor) const override;
     Token value;
+    mutable ConstantCache constant{};
 };
 
 struct Expr::Logical : Expr {
-    Logical(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right);
+    Logical(Expr *left, Token op, Expr *right);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> left;
+    Expr *left;
     Token op;
-    std::shared_ptr<Expr> right;
+    Expr *right;
 };
 
 struct Expr::Set : Expr {
-    Set(std::shared_ptr<Expr> object, Token name, std::shared_ptr<Expr> value);
+    Set(Expr *object, Token name, Expr *value);
     virtual void accept(ExprVisitor &visitor) const override;
-    std::shared_ptr<Expr> object;
+    Expr *object;
     Token name;
-    std::shared_ptr<Expr> value;
+    Expr *value;
+    mutable PropertyCache cache{};
 };
 
 struct Expr::Super : Expr {
@@ -114,16 +142,17 @@ struct Expr::This : Expr {
 };
 
 struct Expr::Unary : Expr {
-    Unary(Token op, std::shared_ptr<Expr> right);
+    Unary(Token op, Expr *right);
     virtual void accept(ExprVisitor &visitor) const override;
     Token op;
-    std::shared_ptr<Expr> right;
+    Expr *right;
 };
 
 struct Expr::Variable : Expr {
     Variable(Token name);
     virtual void accept(ExprVisitor &visitor) const override;
     Token name;
+    mutable GlobalCache global{};
 };
 
 struct ExprVisitor {
@@ -141,3 +170,49 @@ struct ExprVisitor {
     virtual void visit_unary_expr(const Expr::Unary &expr) = 0;
     virtual void visit_variable_expr(const Expr::Variable &expr) = 0;
 };
+
+// Calls the visit method for the concrete type of `expr`.
+template <typename Visitor>
+void dispatch(const Expr &expr, Visitor &visitor) {
+    switch (expr.kind) {
+    case ExprKind::ASSIGN:
+        visitor.visit_assign_expr(static_cast<const Expr::Assign &>(expr));
+        return;
+    case ExprKind::BINARY:
+        visitor.visit_binary_expr(static_cast<const Expr::Binary &>(expr));
+        return;
+    case ExprKind::CALL:
+        visitor.visit_call_expr(static_cast<const Expr::Call &>(expr));
+        return;
+    case ExprKind::GET:
+        visitor.visit_get_expr(static_cast<const Expr::Get &>(expr));
+        return;
+    case ExprKind::GROUPING:
+        visitor.visit_grouping_expr(static_cast<const Expr::Grouping &>(expr));
+        return;
+    case ExprKind::LAMBDA:
+        visitor.visit_lambda_expr(static_cast<const Expr::Lambda &>(expr));
+        return;
+    case ExprKind::LITERAL:
+        visitor.visit_literal_expr(static_cast<const Expr::Literal &>(expr));
+        return;
+    case ExprKind::LOGICAL:
+        visitor.visit_logical_expr(static_cast<const Expr::Logical &>(expr));
+        return;
+    case ExprKind::SET:
+        visitor.visit_set_expr(static_cast<const Expr::Set &>(expr));
+        return;
+    case ExprKind::SUPER:
+        visitor.visit_super_expr(static_cast<const Expr::Super &>(expr));
+        return;
+    case ExprKind::THIS:
+        visitor.visit_this_expr(static_cast<const Expr::This &>(expr));
+        return;
+    case ExprKind::UNARY:
+        visitor.visit_unary_expr(static_cast<const Expr::Unary &>(expr));
+        return;
+    case ExprKind::VARIABLE:
+        visitor.visit_variable_expr(static_cast<const Expr::Variable &>(expr));
+        return;
+    }
+}
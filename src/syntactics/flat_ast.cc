@@ -0,0 +1,40 @@
+#include "src/syntactics/flat_ast.h"
+
+FlatAst::Index FlatAst::add(Kind kind, Index token, Index first_operand,
+                            Index second_operand, Index third_operand) {
+    kinds.push_back(kind);
+    token_indices.push_back(token);
+    first.push_back(first_operand);
+    second.push_back(second_operand);
+    third.push_back(third_operand);
+    depths.push_back(GLOBAL);
+    slots.push_back(NONE);
+    return static_cast<Index>(kinds.size() - 1);
+}
+
+FlatAst::Index FlatAst::add_token(const Token &token) {
+    tokens.push_back(&token);
+    return static_cast<Index>(tokens.size() - 1);
+}
+
+FlatAst::Index FlatAst::add_list(std::span<const Index> elements) {
+    Index start = static_cast<Index>(lists.size());
+    lists.push_back(static_cast<Index>(elements.size()));
+    lists.insert(lists.end(), elements.begin(), elements.end());
+    return start;
+}
+
+FlatAst::Index FlatAst::add_property_cache() {
+    property_caches.emplace_back();
+    return static_cast<Index>(property_caches.size() - 1);
+}
+
+std::span<const FlatAst::Index> FlatAst::list(Index start) const {
+    return {lists.data() + start + 1, lists[start]};
+}
+
+const Token &FlatAst::token(Index node) const {
+    return *tokens[token_indices[node]];
+}
+
+size_t FlatAst::size() const { return kinds.size(); }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "src/syntactics/property_cache.h"
+#include "src/syntactics/token.h"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// A program's nodes laid out flat, for walking them without chasing
+// pointers. Node i is row i of the parallel arrays below: its children are
+// node indices, lists of them are stored in `lists`, and its token is an
+// index into `tokens`, which point into the parsed program the nodes were
+// flattened from. What the operands of each kind of node hold:
+//
+//   kind        token      first        second        third
+//   ASSIGN      name       value
+//   BINARY      op         left         right         op's TokenType
+//   AND, OR     op         left         right
+//   CALL        paren      callee       argument list
+//   TAIL_CALL   paren      callee       argument list
+//   GET         name       object       property cache
+//   LAMBDA      keyword    body list    declaration   slot count
+//   LITERAL                constant
+//   SET         name       object       value         property cache
+//   SUPER       method
+//   THIS        keyword
+//   UNARY       op         right        op's TokenType
+//   VARIABLE    name
+//   BLOCK                  statement list  slot count
+//   CLASS       name       superclass   method list
+//   EXPRESSION             expression
+//   FUNCTION    name       body list    declaration   slot count
+//   IF                     condition    then          else
+//   PRINT                  expression
+//   RETURN      keyword    value
+//   VAR         name       initializer
+//   WHILE                  condition    body
+//   COUNTED_WHILE          condition    body          step constant
+//
+// Constants and declarations index tables kept by the engine that built the
+// nodes. A BLOCK whose slot count is NONE runs in the environment enclosing
+// it. Groupings are flattened away.
+struct FlatAst {
+    using Index = uint32_t;
+    // An absent operand, e.g. the else branch of an if without one.
+    static constexpr Index NONE = std::numeric_limits<Index>::max();
+    // The depth of a name that lives in the global table.
+    static constexpr int32_t GLOBAL = -1;
+
+    enum class Kind : uint8_t {
+        ASSIGN,
+        BINARY,
+        AND,
+        OR,
+        CALL,
+        // A call that is all a return statement returns.
+        TAIL_CALL,
+        GET,
+        LAMBDA,
+        LITERAL,
+        SET,
+        SUPER,
+        THIS,
+        UNARY,
+        VARIABLE,
+        BLOCK,
+        CLASS,
+        EXPRESSION,
+        FUNCTION,
+        IF,
+        PRINT,
+        RETURN,
+        VAR,
+        WHILE,
+        // A while loop the Optimizer found to count, see CountedLoop. Its
+        // condition is a BINARY node comparing a VARIABLE, the counter, with
+        // the limit, and its body a BLOCK.
+        COUNTED_WHILE,
+    };
+
+    // Appends a node, at the global depth, and returns its index.
+    Index add(Kind kind, Index token = NONE, Index first = NONE,
+              Index second = NONE, Index third = NONE);
+    Index add_token(const Token &token);
+    // Stores `elements` in `lists` as their count followed by the elements,
+    // and returns where they start.
+    Index add_list(std::span<const Index> elements);
+    Index add_property_cache();
+
+    std::span<const Index> list(Index start) const;
+    const Token &token(Index node) const;
+    size_t size() const;
+
+    std::vector<Kind> kinds;
+    std::vector<Index> token_indices;
+    std::vector<Index> first;
+    std::vector<Index> second;
+    std::vector<Index> third;
+    // Where the Resolver found the variable a node names or declares:
+    // `depth` environments up at `slot`, or at `slot` of the global table.
+    std::vector<int32_t> depths;
+    std::vector<Index> slots;
+
+    std::vector<Index> lists;
+    std::vector<const Token *> tokens;
+    std::vector<PropertyCache> property_caches;
+};
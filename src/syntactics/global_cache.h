@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The slot of a global variable, cached on the expression that names it.
+// The slot is only meaningful in the global table whose id is `table_id`; a
+// node evaluated against another table looks its name up again.
+struct GlobalCache {
+    static constexpr uint64_t NO_TABLE = UINT64_MAX;
+
+    bool valid_for(uint64_t id) const { return table_id == id; }
+
+    uint64_t table_id = NO_TABLE;
+    size_t slot = 0;
+};
@@ -2,34 +2,71 @@
 #include "src/logging.h"
 #include "src/syntactics/parser.h"
 
-Parser::Parser(std::vector<Token> tokens)
-    : tokens(std::move(tokens)), curr(0), m_had_error(false) {}
+#include <fmt/format.h>
+#include <iostream>
 
-std::vector<std::shared_ptr<Stmt>> Parser::parse() {
-    std::vector<std::shared_ptr<Stmt>> statements;
+namespace {
+
+// Deeper expressions are a parse error rather than a stack overflow here, or in
+// the engines, which also recurse into subexpressions. Every level takes
+// several frames of each, so this stays well within a small or sanitized
+// stack.
+constexpr size_t MAX_EXPRESSION_DEPTH = 256;
+
+// Engines keep many declarations, like those of functions, after running them,
+// so their arenas start small and grow as needed.
+constexpr size_t DECLARATION_BLOCK_SIZE = 512;
+
+} // namespace
+
+Parser::Parser(Scanner scanner)
+    : scanner(std::move(scanner)),
+      window{Token(nullptr), Token(nullptr), Token(nullptr), Token(nullptr)},
+      curr(0), m_had_error(false), held_errors(),
+      arena(std::make_unique<AstArena>()), declares_functions(false),
+      expression_depth(0) {
+    window[0] = this->scanner.next_token();
+    window[1] = this->scanner.next_token();
+}
+
+Program Parser::parse() {
+    auto statements = arena->list<Stmt *>();
     while (!is_at_end()) {
         try {
-            statements.push_back(std::move(declaration()));
+            statements.push_back(declaration());
         } catch (const ParseError &error) {
         }
     }
-    return statements;
+    print_held_errors();
+    return {scanner.source(), std::move(arena), std::move(statements),
+            declares_functions};
 }
 
-bool Parser::had_error() const { return m_had_error; }
+std::optional<Program> Parser::parse_declaration() {
+    if (is_at_end()) {
+        return std::nullopt;
+    }
+    arena = std::make_unique<AstArena>(DECLARATION_BLOCK_SIZE);
+    declares_functions = false;
+    auto statements = arena->list<Stmt *>();
+    statements.push_back(declaration());
+    print_held_errors();
+    return Program{scanner.source(), std::move(arena), std::move(statements),
+                   declares_functions};
+}
+
+bool Parser::had_error() const { return m_had_error or scanner.had_error; }
 
 bool Parser::is_at_end() const { return peek().type == END_OF_FILE; }
 
-const Token &Parser::peek() const { return tokens[curr]; }
+const Token &Parser::peek() const { return window[curr % WINDOW_SIZE]; }
 
 const Token &Parser::peek_next() const {
-    if (curr + 1 >= tokens.size())
-        return tokens[curr];
-    return tokens[curr + 1];
+    return window[(curr + 1) % WINDOW_SIZE];
 }
 
 const Token &Parser::previous() const {
-    return tokens[curr == 0 ? curr : curr - 1];
+    return window[(curr == 0 ? curr : curr - 1) % WINDOW_SIZE];
 }
 
 bool Parser::check(TokenType token_type) const {
@@ -37,20 +74,33 @@ bool Parser::check(TokenType token_type) const {
 }
 
 const Token &Parser::advance() {
-    if (!is_at_end()) {
-        return tokens[curr++];
+    if (is_at_end()) {
+        return peek();
+    }
+    curr++;
+    // The slot of the token before the previous one. At the end, the scanner
+    // keeps returning END_OF_FILE.
+    window[(curr + 1) % WINDOW_SIZE] = scanner.next_token();
+    return previous();
+}
+
+const Token &Parser::consume(TokenType type, std::string_view message) {
+    if (!check(type)) {
+        throw parse_error(peek(), std::string(message));
     }
-    return tokens[curr];
+    return advance();
 }
 
-const Token &Parser::consume(TokenType type, const std::string &message) {
+const Token &Parser::consume(TokenType type, std::string_view message,
+                             std::string_view kind) {
     if (!check(type)) {
-        throw parse_error(peek(), message);
+        throw parse_error(peek(), fmt::format(fmt::runtime(message), kind));
     }
     return advance();
 }
 
-std::shared_ptr<Stmt> Parser::declaration() {
+Stmt *Parser::declaration() {
+    size_t depth = expression_depth;
     try {
         if (match(CLASS)) {
             return class_declaration();
@@ -70,45 +120,45 @@ std::shared_ptr<Stmt> Parser::declaration() {
 
         return statement();
     } catch (const ParseError &error) {
+        expression_depth = depth;
         synchronize();
         return nullptr;
     }
 }
 
-std::shared_ptr<Stmt> Parser::var_declaration() {
+Stmt *Parser::var_declaration() {
     Token name = consume(IDENTIFIER, "Expect variable name.");
-    std::shared_ptr<Expr> initializer = nullptr;
+    Expr *initializer = nullptr;
     if (match(EQUAL)) {
         initializer = expression();
     }
 
     consume(SEMICOLON, "Expect ';' after variable declaration.");
-    return make_shared<Stmt::Var>(name, std::move(initializer));
+    return arena->make<Stmt::Var>(name, initializer);
 }
 
-std::shared_ptr<Stmt> Parser::class_declaration() {
+Stmt *Parser::class_declaration() {
     Token name = consume(IDENTIFIER, "Expect class name.");
 
-    std::shared_ptr<Expr::Variable> superclass = nullptr;
+    Expr::Variable *superclass = nullptr;
     if (match(LESS)) {
-        superclass = std::make_shared<Expr::Variable>(
+        superclass = arena->make<Expr::Variable>(
             consume(IDENTIFIER, "Expect superclass name."));
     }
 
     consume(LEFT_BRACE, "Expect '{' before class body.");
 
-    std::vector<std::shared_ptr<Stmt::Function>> methods;
+    auto methods = arena->list<Stmt::Function *>();
     while (!check(RIGHT_BRACE) && !is_at_end()) {
-        methods.emplace_back(
-            std::static_pointer_cast<Stmt::Function>(function("method")));
+        methods.push_back(static_cast<Stmt::Function *>(function("method")));
     }
 
     consume(RIGHT_BRACE, "Expect '}' after class body.");
 
-    return std::make_shared<Stmt::Class>(name, superclass, std::move(methods));
+    return arena->make<Stmt::Class>(name, superclass, std::move(methods));
 }
 
-std::shared_ptr<Stmt> Parser::statement() {
+Stmt *Parser::statement() {
     if (match(IF)) {
         return if_statement();
     }
@@ -125,50 +175,49 @@ std::shared_ptr<Stmt> Parser::statement() {
         return print_statement();
     }
     if (match(LEFT_BRACE)) {
-        return make_shared<Stmt::Block>(block_stmt_list());
+        return arena->make<Stmt::Block>(block_stmt_list());
     }
     return expression_statement();
 }
 
-std::vector<std::shared_ptr<Stmt>> Parser::block_stmt_list() {
-    std::vector<std::shared_ptr<Stmt>> statements;
+std::pmr::vector<Stmt *> Parser::block_stmt_list() {
+    auto statements = arena->list<Stmt *>();
 
     while (!check(RIGHT_BRACE) and !is_at_end()) {
-        statements.push_back(std::move(declaration()));
+        statements.push_back(declaration());
     }
 
     consume(RIGHT_BRACE, "Expect '}' after block.");
     return statements;
 }
 
-std::shared_ptr<Stmt> Parser::if_statement() {
+Stmt *Parser::if_statement() {
     consume(LEFT_PAREN, "Expect '(' after 'if'.");
     auto condition = expression();
     consume(RIGHT_PAREN, "Expect ')' after if condition.");
 
     auto then_branch = statement();
-    std::shared_ptr<Stmt> else_branch;
+    Stmt *else_branch = nullptr;
     if (match(ELSE)) {
         else_branch = statement();
     }
 
-    return std::make_shared<Stmt::If>(
-        std::move(condition), std::move(then_branch), std::move(else_branch));
+    return arena->make<Stmt::If>(condition, then_branch, else_branch);
 }
 
-std::shared_ptr<Stmt> Parser::while_statement() {
+Stmt *Parser::while_statement() {
     consume(LEFT_PAREN, "Expect '(' after 'while'.");
     auto condition = expression();
     consume(RIGHT_PAREN, "Expect ')' after condition.");
     auto body = statement();
 
-    return std::make_shared<Stmt::While>(std::move(condition), std::move(body));
+    return arena->make<Stmt::While>(condition, body);
 }
 
-std::shared_ptr<Stmt> Parser::for_statement() {
+Stmt *Parser::for_statement() {
     consume(LEFT_PAREN, "Expect '(' after 'for'.");
 
-    std::shared_ptr<Stmt> initializer;
+    Stmt *initializer;
     if (match(SEMICOLON)) {
         initializer = nullptr;
     } else if (match(VAR)) {
@@ -177,7 +226,7 @@ std::shared_ptr<Stmt> Parser::for_statement() {
         initializer = expression_statement();
     }
 
-    std::shared_ptr<Expr> condition;
+    Expr *condition;
     if (check(SEMICOLON)) {
         condition = nullptr;
     } else {
@@ -185,7 +234,7 @@ std::shared_ptr<Stmt> Parser::for_statement() {
     }
     consume(SEMICOLON, "Expect ';' after loop condition.");
 
-    std::shared_ptr<Expr> increment;
+    Expr *increment = nullptr;
     if (!check(RIGHT_PAREN)) {
         increment = expression();
     }
@@ -195,169 +244,155 @@ std::shared_ptr<Stmt> Parser::for_statement() {
 
     if (increment) {
         // Extend body
-        // Initializer of vectors do not work, so we use two push backs.
-        std::vector<std::shared_ptr<Stmt>> extended_body;
-        extended_body.push_back(std::move(body));
-        extended_body.push_back(
-            std::make_shared<Stmt::Expression>(std::move(increment)));
-        body = std::make_shared<Stmt::Block>(std::move(extended_body));
+        auto extended_body = arena->list<Stmt *>();
+        extended_body.push_back(body);
+        extended_body.push_back(arena->make<Stmt::Expression>(increment));
+        body = arena->make<Stmt::Block>(std::move(extended_body));
     }
     if (not condition) {
-        condition = std::make_shared<Expr::Literal>(Token(true));
+        condition = arena->make<Expr::Literal>(Token(true));
     }
-    body = std::make_shared<Stmt::While>(std::move(condition), std::move(body));
+    body = arena->make<Stmt::While>(condition, body);
     if (initializer) {
-        std::vector<std::shared_ptr<Stmt>> encapsulating_block_list;
-        encapsulating_block_list.push_back(std::move(initializer));
-        encapsulating_block_list.push_back(std::move(body));
-        body =
-            std::make_shared<Stmt::Block>(std::move(encapsulating_block_list));
+        auto encapsulating_block_list = arena->list<Stmt *>();
+        encapsulating_block_list.push_back(initializer);
+        encapsulating_block_list.push_back(body);
+        body = arena->make<Stmt::Block>(std::move(encapsulating_block_list));
     }
     return body;
 }
 
-std::shared_ptr<Stmt> Parser::print_statement() {
+Stmt *Parser::print_statement() {
     auto expr = expression();
     consume(SEMICOLON, "Expect ; after value.");
-    return make_shared<Stmt::Print>(std::move(expr));
+    return arena->make<Stmt::Print>(expr);
 }
 
-std::shared_ptr<Stmt> Parser::return_statement() {
+Stmt *Parser::return_statement() {
     Token keyword = previous();
-    std::shared_ptr<Expr> value = nullptr;
+    Expr *value = nullptr;
     if (!check(SEMICOLON)) {
         value = expression();
     }
 
     consume(SEMICOLON, "Expect ';' after return value.");
-    return std::make_shared<Stmt::Return>(keyword, std::move(value));
+    return arena->make<Stmt::Return>(keyword, value);
 }
 
-std::shared_ptr<Stmt> Parser::expression_statement() {
+Stmt *Parser::expression_statement() {
     auto expr = expression();
     consume(SEMICOLON, "Expect ; after value.");
-    return make_shared<Stmt::Expression>(std::move(expr));
+    return arena->make<Stmt::Expression>(expr);
 }
 
-std::shared_ptr<Expr> Parser::expression() { return assignment(); }
-
-std::shared_ptr<Stmt> Parser::function(const std::string &kind) {
-    Token name = consume(IDENTIFIER, "Expect " + kind + " name.");
+Stmt *Parser::function(std::string_view kind) {
+    declares_functions = true;
+    Token name = consume(IDENTIFIER, "Expect {} name.", kind);
     auto [parameters, body] = finish_function(kind);
-    return std::make_shared<Stmt::Function>(name, parameters, std::move(body));
-}
-
-std::shared_ptr<Expr> Parser::assignment() {
-    auto expr = or_expr();
+    return arena->make<Stmt::Function>(name, std::move(parameters),
+                                       std::move(body));
+}
+
+enum class Parser::Precedence : uint8_t {
+    // Not an infix operator.
+    NONE,
+    ASSIGNMENT,
+    OR,
+    AND,
+    EQUALITY,
+    COMPARISON,
+    TERM,
+    FACTOR,
+    UNARY,
+};
+
+Parser::Precedence Parser::infix_precedence(TokenType type) {
+    static constexpr auto precedences = [] {
+        std::array<Precedence, END_OF_FILE + 1> precedences{};
+        precedences[EQUAL] = Precedence::ASSIGNMENT;
+        precedences[OR] = Precedence::OR;
+        precedences[AND] = Precedence::AND;
+        precedences[BANG_EQUAL] = Precedence::EQUALITY;
+        precedences[EQUAL_EQUAL] = Precedence::EQUALITY;
+        precedences[GREATER] = Precedence::COMPARISON;
+        precedences[GREATER_EQUAL] = Precedence::COMPARISON;
+        precedences[LESS] = Precedence::COMPARISON;
+        precedences[LESS_EQUAL] = Precedence::COMPARISON;
+        precedences[MINUS] = Precedence::TERM;
+        precedences[PLUS] = Precedence::TERM;
+        precedences[SLASH] = Precedence::FACTOR;
+        precedences[STAR] = Precedence::FACTOR;
+        return precedences;
+    }();
+    return precedences[type];
+}
+
+Expr *Parser::expression() {
+    return parse_precedence(Precedence::ASSIGNMENT);
+}
+
+Expr *Parser::parse_precedence(Precedence precedence) {
+    if (expression_depth == MAX_EXPRESSION_DEPTH) {
+        throw parse_error(peek(), "Expression nests too deeply.");
+    }
+    expression_depth++;
 
-    if (match(EQUAL)) {
-        Token equals = previous();
-        auto value = assignment();
-
-        if (auto var_expr = std::dynamic_pointer_cast<Expr::Variable>(expr)) {
-            return make_shared<Expr::Assign>(var_expr->name, std::move(value));
-        } else if (auto get_expr = std::dynamic_pointer_cast<Expr::Get>(expr)) {
-            return make_shared<Expr::Set>(get_expr->object, get_expr->name,
-                                          value);
+    auto expr = unary();
+    // An operator's right operand only takes operators that bind more tightly,
+    // so operators of the same precedence associate to the left. Assignment
+    // associates to the right.
+    for (Precedence infix = infix_precedence(peek().type);
+         infix != Precedence::NONE and infix >= precedence;
+         infix = infix_precedence(peek().type)) {
+        Token op = advance();
+        if (infix == Precedence::ASSIGNMENT) {
+            expr = assignment(expr, op);
+            continue;
         }
 
-        report_parse_error(equals, "Invalid assignment target.");
-    }
-
-    return expr;
-}
-
-std::shared_ptr<Expr> Parser::or_expr() {
-    auto expr = and_expr();
-
-    while (match(OR)) {
-        Token op = previous();
-        auto right = and_expr();
-        expr = std::make_shared<Expr::Logical>(std::move(expr), op,
-                                               std::move(right));
-    }
-
-    return expr;
-}
-
-std::shared_ptr<Expr> Parser::and_expr() {
-    auto expr = equality();
-
-    while (match(AND)) {
-        Token op = previous();
-        auto right = equality();
-        expr = std::make_shared<Expr::Logical>(std::move(expr), op,
-                                               std::move(right));
+        auto right = parse_precedence(
+            static_cast<Precedence>(static_cast<uint8_t>(infix) + 1));
+        if (infix == Precedence::OR or infix == Precedence::AND) {
+            expr = arena->make<Expr::Logical>(expr, op, right);
+        } else {
+            expr = arena->make<Expr::Binary>(expr, op, right);
+        }
     }
 
+    expression_depth--;
     return expr;
 }
 
-std::shared_ptr<Expr> Parser::equality() {
-    auto expr = comparison();
-    while (match(BANG_EQUAL, EQUAL_EQUAL)) {
-        Token op = previous();
-        auto right = comparison();
-        auto left = std::move(expr);
-        expr = std::make_shared<Expr::Binary>(std::move(left), op,
-                                              std::move(right));
-    }
-    return expr;
-}
-
-std::shared_ptr<Expr> Parser::comparison() {
-    auto expr = term();
-    while (match(GREATER, GREATER_EQUAL, LESS, LESS_EQUAL)) {
-        Token op = previous();
-        auto right = term();
-        auto left = std::move(expr);
-        expr = std::make_shared<Expr::Binary>(std::move(left), op,
-                                              std::move(right));
-    }
-    return expr;
-}
+Expr *Parser::assignment(Expr *target, const Token &equals) {
+    auto value = parse_precedence(Precedence::ASSIGNMENT);
 
-std::shared_ptr<Expr> Parser::term() {
-    auto expr = factor();
-    while (match(MINUS, PLUS)) {
-        Token op = previous();
-        auto right = factor();
-        auto left = std::move(expr);
-        expr = std::make_shared<Expr::Binary>(std::move(left), op,
-                                              std::move(right));
+    if (auto var_expr = dynamic_cast<Expr::Variable *>(target)) {
+        return arena->make<Expr::Assign>(var_expr->name, value);
+    } else if (auto get_expr = dynamic_cast<Expr::Get *>(target)) {
+        return arena->make<Expr::Set>(get_expr->object, get_expr->name, value);
     }
-    return expr;
-}
 
-std::shared_ptr<Expr> Parser::factor() {
-    auto expr = unary();
-    while (match(STAR, SLASH)) {
-        Token op = previous();
-        auto right = unary();
-        auto left = std::move(expr);
-        expr = std::make_shared<Expr::Binary>(std::move(left), op,
-                                              std::move(right));
-    }
-    return expr;
+    report_parse_error(equals, "Invalid assignment target.");
+    return target;
 }
 
-std::shared_ptr<Expr> Parser::unary() {
+Expr *Parser::unary() {
     if (match(MINUS, BANG)) {
         Token op = previous();
-        auto right = unary();
-        return std::make_shared<Expr::Unary>(op, std::move(right));
+        auto right = parse_precedence(Precedence::UNARY);
+        return arena->make<Expr::Unary>(op, right);
     }
     return call();
 }
 
-std::shared_ptr<Expr> Parser::call() {
+Expr *Parser::call() {
     auto expr = primary();
     while (true) {
         if (match(LEFT_PAREN)) {
-            expr = finish_call(std::move(expr));
+            expr = finish_call(expr);
         } else if (match(DOT)) {
             Token name = consume(IDENTIFIER, "Expect property name after '.'.");
-            expr = std::make_shared<Expr::Get>(expr, name);
+            expr = arena->make<Expr::Get>(expr, name);
         } else {
             break;
         }
@@ -366,36 +401,38 @@ std::shared_ptr<Expr> Parser::call() {
     return expr;
 }
 
-std::shared_ptr<Expr> Parser::primary() {
+Expr *Parser::primary() {
     auto token = advance();
-    std::shared_ptr<Expr> expr;
+    Expr *expr;
     switch (token.type) {
     case NUMBER:
     case STRING:
     case TRUE:
     case FALSE:
     case NIL:
-        expr = std::make_shared<Expr::Literal>(token);
+        expr = arena->make<Expr::Literal>(token);
         break;
     case LEFT_PAREN: {
         auto inner_expr = expression();
         consume(RIGHT_PAREN, "Expect ')' after expression");
-        expr = std::make_shared<Expr::Grouping>(std::move(inner_expr));
+        expr = arena->make<Expr::Grouping>(inner_expr);
     } break;
     case IDENTIFIER:
-        expr = std::make_shared<Expr::Variable>(token);
+        expr = arena->make<Expr::Variable>(token);
         break;
     case FUN: {
+        declares_functions = true;
         auto [parameters, body] = finish_function("lambda");
-        expr = std::make_shared<Expr::Lambda>(token, parameters, body);
+        expr = arena->make<Expr::Lambda>(token, std::move(parameters),
+                                         std::move(body));
     } break;
     case THIS:
-        expr = std::make_shared<Expr::This>(token);
+        expr = arena->make<Expr::This>(token);
         break;
     case SUPER: {
         consume(DOT, "Expect '.' after 'super'.");
         Token method = consume(IDENTIFIER, "Expect superclass method name.");
-        expr = std::make_shared<Expr::Super>(token, method);
+        expr = arena->make<Expr::Super>(token, method);
     } break;
     default:
         throw parse_error(peek(), "Expect expression");
@@ -403,10 +440,10 @@ std::shared_ptr<Expr> Parser::primary() {
     return expr;
 }
 
-std::pair<std::vector<Token>, std::vector<std::shared_ptr<Stmt>>>
-Parser::finish_function(const std::string &kind) {
-    consume(LEFT_PAREN, "Expect '(' after " + kind + " declaration.");
-    std::vector<Token> parameters;
+std::pair<std::pmr::vector<Token>, std::pmr::vector<Stmt *>>
+Parser::finish_function(std::string_view kind) {
+    consume(LEFT_PAREN, "Expect '(' after {} declaration.", kind);
+    auto parameters = arena->list<Token>();
     if (!check(RIGHT_PAREN)) {
         do {
             if (parameters.size() >= 255) {
@@ -418,13 +455,13 @@ Parser::finish_function(const std::string &kind) {
         } while (match(COMMA));
     }
     consume(RIGHT_PAREN, "Expect ')' after parameters.");
-    consume(LEFT_BRACE, "Expect '{' before " + kind + " body.");
+    consume(LEFT_BRACE, "Expect '{{' before {} body.", kind);
     auto body = block_stmt_list();
-    return {parameters, body};
+    return {std::move(parameters), std::move(body)};
 }
 
-std::shared_ptr<Expr> Parser::finish_call(std::shared_ptr<Expr> callee) {
-    std::vector<std::shared_ptr<Expr>> arguments;
+Expr *Parser::finish_call(Expr *callee) {
+    auto arguments = arena->list<Expr *>();
     if (!check(RIGHT_PAREN)) {
         do {
             if (arguments.size() > 255) {
@@ -437,8 +474,7 @@ std::shared_ptr<Expr> Parser::finish_call(std::shared_ptr<Expr> callee) {
 
     Token paren = consume(RIGHT_PAREN, "Expect ')' after arguments.");
 
-    return make_shared<Expr::Call>(std::move(callee), paren,
-                                   std::move(arguments));
+    return arena->make<Expr::Call>(callee, paren, std::move(arguments));
 }
 
 Parser::ParseError::ParseError(const std::string &what)
@@ -479,5 +515,14 @@ void Parser::synchronize() {
 std::string Parser::report_parse_error(const Token &token,
                                        const std::string &message) {
     m_had_error = true;
-    return report_token_error(token, message);
+    return held_errors.emplace_back(report_token_error(token, message, false));
+}
+
+void Parser::print_held_errors() {
+    if (!scanner.had_error) {
+        for (const std::string &message : held_errors) {
+            std::cerr << message << std::endl;
+        }
+    }
+    held_errors.clear();
 }
\ No newline at end of file
@@ -1,18 +1,34 @@
 #pragma once
 
+#include "src/syntactics/ast_arena.h"
 #include "src/syntactics/expr.h"
+#include "src/syntactics/program.h"
+#include "src/syntactics/scanner.h"
 #include "src/syntactics/stmt.h"
 #include "src/syntactics/token.h"
 #include "src/tp_utils.h"
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
+// Parses the tokens of a scanner as it scans them, so that only the few the
+// parser looks at are kept at a time.
 struct Parser {
-    explicit Parser(std::vector<Token> tokens);
+    explicit Parser(Scanner scanner);
 
-    std::vector<std::shared_ptr<Stmt>> parse();
+    // Parses the whole source. Can only be called once, and not along with
+    // parse_declaration: the program takes the parser's arena.
+    Program parse();
+    // Parses the next top-level declaration into a program of its own, so that
+    // it can run, and possibly be freed, before the rest is parsed. Returns
+    // nothing at the end of the source.
+    std::optional<Program> parse_declaration();
     struct ParseError : std::runtime_error {
         explicit ParseError(const std::string &what);
     };
@@ -36,44 +52,65 @@ struct Parser {
     const Token &peek_next() const;
     const Token &previous() const;
     const Token &advance();
-    const Token &consume(TokenType type, const std::string &message);
+    const Token &consume(TokenType type, std::string_view message);
+    // Reports `message` with `kind` in place of its {}, e.g. "Expect {} name.".
+    const Token &consume(TokenType type, std::string_view message,
+                         std::string_view kind);
 
-    std::shared_ptr<Stmt> declaration();
-    std::shared_ptr<Stmt> var_declaration();
-    std::shared_ptr<Stmt> class_declaration();
-    std::shared_ptr<Stmt> function(const std::string &kind);
-    std::shared_ptr<Stmt> statement();
-    std::vector<std::shared_ptr<Stmt>> block_stmt_list();
-    std::shared_ptr<Stmt> if_statement();
-    std::shared_ptr<Stmt> while_statement();
-    std::shared_ptr<Stmt> for_statement();
-    std::shared_ptr<Stmt> print_statement();
-    std::shared_ptr<Stmt> return_statement();
-    std::shared_ptr<Stmt> expression_statement();
+    Stmt *declaration();
+    Stmt *var_declaration();
+    Stmt *class_declaration();
+    Stmt *function(std::string_view kind);
+    Stmt *statement();
+    std::pmr::vector<Stmt *> block_stmt_list();
+    Stmt *if_statement();
+    Stmt *while_statement();
+    Stmt *for_statement();
+    Stmt *print_statement();
+    Stmt *return_statement();
+    Stmt *expression_statement();
 
-    std::shared_ptr<Expr> expression();
-    std::shared_ptr<Expr> assignment();
-    std::shared_ptr<Expr> or_expr();
-    std::shared_ptr<Expr> and_expr();
-    std::shared_ptr<Expr> equality();
-    std::shared_ptr<Expr> comparison();
-    std::shared_ptr<Expr> term();
-    std::shared_ptr<Expr> factor();
-    std::shared_ptr<Expr> unary();
-    std::shared_ptr<Expr> call();
-    std::shared_ptr<Expr> primary();
+    // How tightly infix operators bind, from loosest to tightest.
+    enum class Precedence : uint8_t;
+    static Precedence infix_precedence(TokenType type);
 
-    std::pair<std::vector<Token>, std::vector<std::shared_ptr<Stmt>>>
-    finish_function(const std::string &kind);
-    std::shared_ptr<Expr> finish_call(std::shared_ptr<Expr> callee);
+    Expr *expression();
+    // Parses an expression whose infix operators all bind at least as tightly
+    // as `precedence`.
+    Expr *parse_precedence(Precedence precedence);
+    Expr *assignment(Expr *target, const Token &equals);
+    Expr *unary();
+    Expr *call();
+    Expr *primary();
+
+    std::pair<std::pmr::vector<Token>, std::pmr::vector<Stmt *>>
+    finish_function(std::string_view kind);
+    Expr *finish_call(Expr *callee);
 
     std::string report_parse_error(const Token &token,
                                    const std::string &message);
     ParseError parse_error(const Token &token, const std::string &message);
+    // Prints the parse errors held back so far, unless the scanner reported
+    // an error meanwhile.
+    void print_held_errors();
 
     void synchronize();
 
-    std::vector<Token> tokens;
+    // The previous token, the current one and the one after it are in
+    // `window`, at their index modulo its size.
+    static constexpr size_t WINDOW_SIZE = 4;
+
+    Scanner scanner;
+    std::array<Token, WINDOW_SIZE> window;
+    // The index of the current token.
     size_t curr;
     bool m_had_error;
+    // Parse errors wait here until the tokens they were found in are known to
+    // have scanned cleanly: as when the whole script was scanned before it
+    // was parsed, a script with scanner errors reports only those.
+    std::vector<std::string> held_errors;
+    std::unique_ptr<AstArena> arena;
+    bool declares_functions;
+    // How many expressions the one being parsed is nested in.
+    size_t expression_depth;
 };
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "src/syntactics/parser.h"
+#include "src/syntactics/scanner.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Prints operators and their operands as nested lists, e.g. "(+ 1 2)".
+std::string print(const Expr &expr) {
+    if (auto binary = dynamic_cast<const Expr::Binary *>(&expr)) {
+        return "(" + std::string(binary->op.lexeme) + " " +
+               print(*binary->left) + " " + print(*binary->right) + ")";
+    }
+    if (auto unary = dynamic_cast<const Expr::Unary *>(&expr)) {
+        return "(" + std::string(unary->op.lexeme) + " " +
+               print(*unary->right) + ")";
+    }
+    if (auto grouping = dynamic_cast<const Expr::Grouping *>(&expr)) {
+        return "(group " + print(*grouping->expression) + ")";
+    }
+    return std::string(dynamic_cast<const Expr::Literal &>(expr).value.lexeme);
+}
+
+// Parses `source`, which must be a single expression, and prints it.
+std::string print_expression(const std::string &source) {
+    Parser parser(Scanner(std::stringstream{source + ";"}));
+    Program program = parser.parse();
+    EXPECT_FALSE(parser.had_error()) << source;
+    auto &statement =
+        dynamic_cast<const Stmt::Expression &>(*program.statements.at(0));
+    return print(*statement.expression);
+}
+
+} // namespace
+
+TEST(ParserTest, ParsesOneDeclarationAtATime) {
+    Parser parser(Scanner(std::stringstream{
+        "var a = 1; fun f() { return a; } print (fun () {})(); { a = 2; }"}));
+    std::vector<Program> programs;
+    while (auto program = parser.parse_declaration()) {
+        programs.push_back(std::move(*program));
+    }
+    EXPECT_FALSE(parser.had_error());
+    ASSERT_EQ(programs.size(), 4);
+
+    std::vector<StmtKind> kinds;
+    std::vector<bool> declares_functions;
+    for (const Program &program : programs) {
+        ASSERT_EQ(program.statements.size(), 1);
+        kinds.push_back(program.statements[0]->kind);
+        declares_functions.push_back(program.declares_functions);
+        // Each has an arena of its own, and all of them view one source.
+        EXPECT_NE(program.arena, nullptr);
+        EXPECT_EQ(program.source, programs[0].source);
+    }
+    EXPECT_EQ(kinds, (std::vector{StmtKind::VAR, StmtKind::FUNCTION,
+                                  StmtKind::PRINT, StmtKind::BLOCK}));
+    EXPECT_EQ(declares_functions, (std::vector{false, true, true, false}));
+}
+
+TEST(ParserTest, ReportsErrorsOfTheScannerAndParser) {
+    std::stringstream errors;
+    auto *cerr_buf = std::cerr.rdbuf(errors.rdbuf());
+
+    Parser scanner_error(
+        Scanner(std::stringstream{"print (1;\nprint 1 # 2;\n\"open"}));
+    scanner_error.parse();
+    EXPECT_TRUE(scanner_error.had_error());
+    // Only the scanner's errors, as when the whole script was scanned before
+    // it was parsed, not the parse errors they cause.
+    EXPECT_EQ(errors.str(), "[line 2] Error: Unexpected character: #\n"
+                            "[line 3] Error: Unterminated string.\n");
+
+    errors.str("");
+    Parser parser_error(Scanner(std::stringstream{"print (1;\nprint 2;"}));
+    Program program = parser_error.parse();
+    EXPECT_TRUE(parser_error.had_error());
+    EXPECT_EQ(errors.str(),
+              "[line 1] Error at ';': Expect ')' after expression\n");
+    // It picks up again after the statement with the error.
+    EXPECT_EQ(program.statements.size(), 2);
+
+    std::cerr.rdbuf(cerr_buf);
+}
+
+TEST(ParserTest, BindsOperatorsByPrecedence) {
+    EXPECT_EQ(print_expression("1 + 2 * 3 - 4 / 5"),
+              "(- (+ 1 (* 2 3)) (/ 4 5))");
+    EXPECT_EQ(print_expression("1 - 2 - 3"), "(- (- 1 2) 3)");
+    EXPECT_EQ(print_expression("1 < 2 == 3 >= 4 != 5"),
+              "(!= (== (< 1 2) (>= 3 4)) 5)");
+    EXPECT_EQ(print_expression("-1 * !2 - --3"),
+              "(- (* (- 1) (! 2)) (- (- 3)))");
+    EXPECT_EQ(print_expression("(1 + 2) * 3"), "(* (group (+ 1 2)) 3)");
+}
+
+TEST(ParserTest, AssignsToTheRight) {
+    Parser parser(Scanner(std::stringstream{"a = b.c = 1 or 2 and 3;"}));
+    Program program = parser.parse();
+    ASSERT_FALSE(parser.had_error());
+
+    auto &statement =
+        dynamic_cast<const Stmt::Expression &>(*program.statements.at(0));
+    auto &assign = dynamic_cast<const Expr::Assign &>(*statement.expression);
+    EXPECT_EQ(assign.name.lexeme, "a");
+    auto &set = dynamic_cast<const Expr::Set &>(*assign.value);
+    EXPECT_EQ(set.name.lexeme, "c");
+    auto &logical_or = dynamic_cast<const Expr::Logical &>(*set.value);
+    EXPECT_EQ(logical_or.op.type, OR);
+    EXPECT_EQ(dynamic_cast<const Expr::Logical &>(*logical_or.right).op.type,
+              AND);
+}
+
+TEST(ParserTest, ReportsInvalidAssignmentTargetsAndGoesOn) {
+    Parser parser(Scanner(std::stringstream{"a + b = 1; -a = 2; print 3;"}));
+    Program program = parser.parse();
+    EXPECT_TRUE(parser.had_error());
+    // The assignment is dropped, but the statements are kept.
+    EXPECT_EQ(program.statements.size(), 3);
+}
+
+TEST(ParserTest, RejectsExpressionsNestedTooDeeply) {
+    auto nested = [](size_t depth) {
+        return std::string(depth, '(') + "1" + std::string(depth, ')') +
+               "; print -" + std::string(depth, '-') + "1;";
+    };
+
+    Parser shallow(Scanner(std::stringstream{nested(250)}));
+    shallow.parse();
+    EXPECT_FALSE(shallow.had_error());
+
+    // Rather than overflowing the stack.
+    Parser deep(Scanner(std::stringstream{nested(100000)}));
+    Program program = deep.parse();
+    EXPECT_TRUE(deep.had_error());
+    EXPECT_EQ(program.statements.size(), 2);
+}
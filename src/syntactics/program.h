@@ -0,0 +1,21 @@
+#pragma once
+
+#include "src/syntactics/ast_arena.h"
+#include "src/syntactics/source.h"
+#include "src/syntactics/stmt.h"
+
+#include <memory>
+#include <vector>
+
+// A parsed program: its top-level statements, the arena that owns them and
+// every node below them, and the source their tokens view. Engines may keep
+// pointers to nodes, e.g. in the functions a program declares, so a program
+// must outlive the engines that ran it.
+struct Program {
+    std::shared_ptr<const Source> source;
+    std::unique_ptr<AstArena> arena;
+    std::pmr::vector<Stmt *> statements;
+    // Whether the program declares any function, method or lambda, which
+    // engines refer to the nodes of for as long as it can be called.
+    bool declares_functions;
+};
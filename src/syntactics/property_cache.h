@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct LoxFunction;
+struct Shape;
+
+// The inline cache of a property access, filled in by the interpreter. Each
+// entry remembers how the property resolves on instances of one shape, so a
+// hit skips the name lookups. Entries are keyed on the shape's id rather than
+// its address: a matching id means the shape, and so its class and the
+// pointers below, are still alive.
+struct PropertyCache {
+    static constexpr size_t CAPACITY = 4;
+
+    struct Entry {
+        uint64_t shape_id;
+        // The slot of the field, when the property is one.
+        size_t slot;
+        // Get: the method the property resolves to when it is not a field.
+        LoxFunction *method;
+        // Set: the shape an instance moves to when the property is a new
+        // field, stored in `slot`.
+        Shape *transition;
+    };
+
+    const Entry *find(uint64_t shape_id) const {
+        for (size_t i = 0; i < size; ++i) {
+            if (entries[i].shape_id == shape_id) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Once the cache holds CAPACITY shapes, new ones replace the oldest.
+    void add(const Entry &entry) {
+        if (size < CAPACITY) {
+            entries[size++] = entry;
+        } else {
+            entries[next_eviction] = entry;
+            next_eviction = (next_eviction + 1) % CAPACITY;
+        }
+    }
+
+    std::array<Entry, CAPACITY> entries{};
+    size_t size = 0;
+    size_t next_eviction = 0;
+};
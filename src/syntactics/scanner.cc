@@ -1,53 +1,107 @@
 #include "src/logging.h"
+#include "src/syntactics/char_runs.h"
 #include "src/syntactics/scanner.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <iostream>
-#include <sstream>
-#include <unordered_map>
+#include <limits>
+#include <thread>
 
-const std::unordered_map<std::string, TokenType> keywords{
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr std::array<Keyword, 16> keywords{{
     {"and", AND},   {"class", CLASS}, {"else", ELSE},     {"false", FALSE},
     {"for", FOR},   {"fun", FUN},     {"if", IF},         {"nil", NIL},
     {"or", OR},     {"print", PRINT}, {"return", RETURN}, {"super", SUPER},
-    {"this", THIS}, {"true", TRUE},   {"var", VAR},       {"while", WHILE}};
+    {"this", THIS}, {"true", TRUE},   {"var", VAR},       {"while", WHILE},
+}};
 
-Scanner::Scanner(std::istream &&is)
-    : had_error(false), token_start_idx(0), curr_idx(0), line(1) {
-    std::ostringstream ss;
-    ss << is.rdbuf();
-    source = ss.str();
+// Every keyword is 2 to 6 characters long, and no two of them share both their
+// second character and their length, so those pick each one a slot of its own.
+constexpr size_t keyword_slot(std::string_view text) {
+    return (static_cast<unsigned char>(text[1]) + (text.size() << 3)) & 31;
 }
 
+constexpr std::array<Keyword, 32> keyword_table = [] {
+    std::array<Keyword, 32> table{};
+    for (const Keyword &keyword : keywords)
+        table[keyword_slot(keyword.text)] = keyword;
+    return table;
+}();
+
+constexpr TokenType keyword_or_identifier(std::string_view text) {
+    if (text.size() < 2 or text.size() > 6)
+        return IDENTIFIER;
+    const Keyword &keyword = keyword_table[keyword_slot(text)];
+    return keyword.text == text ? keyword.type : IDENTIFIER;
+}
+
+static_assert([] {
+    for (const Keyword &keyword : keywords) {
+        if (keyword_or_identifier(keyword.text) != keyword.type)
+            return false;
+    }
+    return true;
+}());
+
+// Chunks smaller than this are not worth handing to a thread.
+constexpr size_t MIN_CHUNK_SIZE = 1 << 16;
+// With a few chunks per thread, a thread that finishes early can take another
+// rather than wait on one with a slow chunk.
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+} // namespace
+
+Scanner::Scanner(std::shared_ptr<const Source> source)
+    : had_error(false), m_source(std::move(source)), text(m_source->text()),
+      tokens(), handed_out(0), first_line(0), deferred_errors(), chunks(),
+      token_start_idx(0), curr_idx(0), line(1) {}
+
+Scanner::Scanner(std::istream &&is) : Scanner(std::make_unique<Source>(is)) {}
+
 Token &Scanner::add_token(TokenType type) {
     return tokens.emplace_back(type, curr_token(), line);
 }
 Token &Scanner::add_token(TokenType type, double number) {
-    return tokens.emplace_back(
-        type, source.substr(token_start_idx, curr_idx - token_start_idx), line,
-        number);
+    return tokens.emplace_back(type, curr_token(), line, number);
 }
-Token &Scanner::add_token(TokenType type, std::string literal) {
-    return tokens.emplace_back(
-        type, source.substr(token_start_idx, curr_idx - token_start_idx), line,
-        std::move(literal));
+Token &Scanner::add_token(TokenType type, std::string_view literal) {
+    return tokens.emplace_back(type, curr_token(), line, literal);
 }
 
 void Scanner::log_error(const std::string &message) {
+    if (deferred_errors.has_value()) {
+        deferred_errors->push_back({tokens.size(), line, message});
+        return;
+    }
     had_error = true;
     error(line, message);
 }
 
-bool Scanner::is_at_end() const { return curr_idx >= source.length(); }
+void Scanner::report_error(const Error &deferred) {
+    had_error = true;
+    error(first_line + deferred.line, deferred.message);
+}
+
+bool Scanner::is_at_end() const { return curr_idx >= text.length(); }
 
-std::string Scanner::curr_token() {
-    return source.substr(token_start_idx, curr_idx - token_start_idx);
+std::string_view Scanner::curr_token() const {
+    return text.substr(token_start_idx, curr_idx - token_start_idx);
 }
 
-char Scanner::advance() { return source[curr_idx++]; }
+char Scanner::advance() { return text[curr_idx++]; }
 bool Scanner::match(char expected) {
     if (is_at_end())
         return false;
-    if (source[curr_idx] != expected)
+    if (text[curr_idx] != expected)
         return false;
 
     curr_idx++;
@@ -57,25 +111,158 @@ bool Scanner::match(char expected) {
 char Scanner::peek() const {
     if (is_at_end())
         return '\0';
-    return source[curr_idx];
+    return text[curr_idx];
 }
 char Scanner::peek_next() const {
-    if (curr_idx + 1 >= source.length())
+    if (curr_idx + 1 >= text.length())
         return '\0';
-    return source[curr_idx + 1];
+    return text[curr_idx + 1];
 }
 
-std::vector<Token> Scanner::scan_tokens() {
+TokenBuffer Scanner::scan_tokens() {
+    // Growing the tokens as they are scanned copies them and faults in fresh
+    // pages every time, which took longer than the scanning itself. Tokens
+    // rarely average under two characters each with what separates them, and
+    // the pages of the reservation that are never written to cost only
+    // address space.
+    tokens.reserve(text.size() / 2 + 1);
     while (!is_at_end()) {
         scan_token();
         token_start_idx = curr_idx;
     }
     add_token(END_OF_FILE);
-    return tokens;
+    return {m_source, std::move(tokens)};
+}
+
+TokenBuffer Scanner::scan_tokens(size_t thread_count) {
+    scan_ahead(thread_count);
+    size_t token_count = 1;
+    for (const Chunk &chunk : chunks)
+        token_count += chunk.tokens.size();
+
+    std::vector<Token> all;
+    all.reserve(token_count);
+    do {
+        all.push_back(next_token());
+    } while (all.back().type != END_OF_FILE);
+    return {m_source, std::move(all)};
 }
 
-bool is_identifier_start(char c) { return isalpha(c) || c == '_'; }
-bool is_identifier(char c) { return isalnum(c) || c == '_'; }
+void Scanner::scan_ahead(size_t thread_count) {
+    // Every chunk but the first starts at the start of a line, where the only
+    // token that could be under way is a string, since comments end with
+    // their line.
+    size_t chunk_count =
+        thread_count <= 1 ? 1
+                          : std::min(thread_count * CHUNKS_PER_THREAD,
+                                     text.size() / MIN_CHUNK_SIZE);
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunk_count; ++i) {
+        size_t line_end = char_runs::find_line_end(
+            text, std::max(i * text.size() / chunk_count, bounds.back()));
+        if (line_end + 1 >= text.size())
+            break;
+        bounds.push_back(line_end + 1);
+    }
+    bounds.push_back(text.size());
+    chunk_count = bounds.size() - 1;
+
+    // Each chunk is scanned as if no string were under way at its start.
+    std::vector<Scanner> scanners;
+    scanners.reserve(chunk_count);
+    for (size_t i = 0; i < chunk_count; ++i)
+        scanners.emplace_back(m_source);
+    std::atomic<size_t> next_chunk = 0;
+    auto scan_chunks = [&] {
+        for (size_t i; (i = next_chunk++) < chunk_count;)
+            scanners[i].scan_chunk(bounds[i], bounds[i + 1]);
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(thread_count, chunk_count); ++i)
+        threads.emplace_back(scan_chunks);
+    scan_chunks();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    // A chunk was scanned right if the one before it stopped at its start.
+    // If a string ran on into it instead, it is scanned again from the end of
+    // the string, or dropped if the string runs past it too. That is rare
+    // enough to be done here, one chunk at a time.
+    chunks.reserve(chunk_count);
+    for (size_t i = 0; i < chunk_count; ++i) {
+        Scanner &scanner = scanners[i];
+        if (curr_idx >= bounds[i + 1])
+            continue;
+        if (curr_idx != bounds[i])
+            scanner.scan_chunk(curr_idx, bounds[i + 1]);
+        chunks.push_back({std::move(scanner.tokens),
+                          std::move(*scanner.deferred_errors), line});
+        line += scanner.line;
+        curr_idx = scanner.curr_idx;
+    }
+    token_start_idx = curr_idx;
+    std::reverse(chunks.begin(), chunks.end());
+}
+
+void Scanner::scan_chunk(size_t begin, size_t end) {
+    tokens.clear();
+    tokens.reserve((end - begin) / 2 + 1);
+    deferred_errors.emplace();
+    token_start_idx = curr_idx = begin;
+    line = 0;
+    while (curr_idx < end) {
+        scan_token();
+        token_start_idx = curr_idx;
+    }
+}
+
+void Scanner::take_chunk() {
+    report_deferred_errors(tokens.size());
+    Chunk &chunk = chunks.back();
+    tokens = std::move(chunk.tokens);
+    handed_out = 0;
+    first_line = chunk.first_line;
+    deferred_errors = std::move(chunk.errors);
+    std::reverse(deferred_errors->begin(), deferred_errors->end());
+    chunks.pop_back();
+}
+
+void Scanner::report_deferred_errors(size_t token_index) {
+    if (!deferred_errors.has_value())
+        return;
+    for (; !deferred_errors->empty() and
+           deferred_errors->back().token_index <= token_index;
+         deferred_errors->pop_back())
+        report_error(deferred_errors->back());
+}
+
+Token Scanner::next_token() {
+    while (handed_out == tokens.size() and !chunks.empty()) {
+        take_chunk();
+    }
+    if (handed_out == tokens.size()) {
+        report_deferred_errors(tokens.size());
+        deferred_errors.reset();
+        first_line = 0;
+        tokens.clear();
+        handed_out = 0;
+        while (tokens.empty() and !is_at_end()) {
+            scan_token();
+            token_start_idx = curr_idx;
+        }
+        if (tokens.empty()) {
+            return Token(END_OF_FILE, curr_token(), line);
+        }
+    }
+    report_deferred_errors(handed_out);
+    Token token = tokens[handed_out++];
+    token.line += static_cast<int>(first_line);
+    return token;
+}
+
+const std::shared_ptr<const Source> &Scanner::source() const {
+    return m_source;
+}
 
 void Scanner::scan_token() {
     char c = advance();
@@ -125,8 +312,7 @@ void Scanner::scan_token() {
     case '/':
         if (match('/')) {
             // A comment goes until the end of the line.
-            while (peek() != '\n' and !is_at_end())
-                advance();
+            curr_idx = char_runs::find_line_end(text, curr_idx);
         } else {
             add_token(SLASH);
         }
@@ -137,14 +323,15 @@ void Scanner::scan_token() {
     case ' ':
     case '\r':
     case '\t':
+        curr_idx = char_runs::skip_blanks(text, curr_idx);
         break;
     case '\n':
         line++;
         break;
     default:
-        if (isdigit(c)) {
+        if (char_runs::is(c, char_runs::DIGIT)) {
             number();
-        } else if (is_identifier_start(c)) {
+        } else if (char_runs::is(c, char_runs::ALPHA)) {
             identifier();
         } else {
             log_error(std::string("Unexpected character: ") + c);
@@ -154,42 +341,47 @@ void Scanner::scan_token() {
 }
 
 void Scanner::string() {
-    while (peek() != '"' and !is_at_end()) {
-        if (peek() == '\n')
-            line++;
-        advance();
+    curr_idx = char_runs::find_string_end(text, curr_idx);
+    while (peek() == '\n') {
+        line++;
+        curr_idx = char_runs::find_string_end(text, curr_idx + 1);
     }
     if (is_at_end()) {
         log_error("Unterminated string.");
         return;
     }
     advance();
-    add_token(STRING, source.substr(token_start_idx + 1,
-                                    curr_idx - token_start_idx - 2));
+    add_token(STRING, curr_token().substr(1, curr_idx - token_start_idx - 2));
 }
 
 void Scanner::number() {
-    while (isdigit(peek()))
+    while (char_runs::is(peek(), char_runs::DIGIT))
         advance();
 
     // Look for a fractional part.
-    if (peek() == '.' and isdigit(peek_next())) {
+    if (peek() == '.' and char_runs::is(peek_next(), char_runs::DIGIT)) {
         // Consume the "."
         advance();
 
-        while (isdigit(peek()))
+        while (char_runs::is(peek(), char_runs::DIGIT))
             advance();
     }
 
-    add_token(NUMBER, std::stod(curr_token()));
+    std::string_view digits = curr_token();
+    double value = 0;
+    auto [end, ec] =
+        std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec == std::errc::result_out_of_range) {
+        // Too large for a double, or too close to 0 when all the digits
+        // before the "." are 0, which is what strtod makes of it as well.
+        value = digits.find_first_not_of("0.") < digits.find('.')
+                    ? std::numeric_limits<double>::infinity()
+                    : 0;
+    }
+    add_token(NUMBER, value);
 }
 
 void Scanner::identifier() {
-    while (is_identifier(peek())) {
-        advance();
-    }
-
-    auto type_it = keywords.find(curr_token());
-    TokenType type = type_it == keywords.end() ? IDENTIFIER : type_it->second;
-    add_token(type, curr_token());
+    curr_idx = char_runs::skip_identifier(text, curr_idx);
+    add_token(keyword_or_identifier(curr_token()));
 }
\ No newline at end of file
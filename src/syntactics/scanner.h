@@ -1,26 +1,69 @@
 #pragma once
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "src/syntactics/source.h"
 #include "src/syntactics/token.h"
 
 struct Scanner {
+    explicit Scanner(std::shared_ptr<const Source> source);
     explicit Scanner(std::istream &&is);
 
     Token &add_token(TokenType type);
     Token &add_token(TokenType type, double number);
-    Token &add_token(TokenType type, std::string literal);
-    std::vector<Token> scan_tokens();
+    Token &add_token(TokenType type, std::string_view literal);
+    // Scans the whole source at once. Can only be called once, and not along
+    // with next_token.
+    TokenBuffer scan_tokens();
+    // As scan_tokens, but scanning as scan_ahead(thread_count) does.
+    TokenBuffer scan_tokens(size_t thread_count);
+    // Scans the whole source at once, in chunks of whole lines, on up to
+    // `thread_count` threads, for next_token to hand the tokens out. They,
+    // and any errors reported on the way, come out as if scanned one at a
+    // time. Sources too small to split are scanned on this thread.
+    void scan_ahead(size_t thread_count);
+    // Scans just the next token; at the end of the source, an END_OF_FILE
+    // token every time.
+    Token next_token();
+
+    const std::shared_ptr<const Source> &source() const;
 
     bool had_error;
 
   private:
+    struct Error {
+        // How many tokens of its chunk were scanned before it.
+        size_t token_index;
+        size_t line;
+        std::string message;
+    };
+
+    // Tokens scanned ahead, whose lines count on from `first_line`.
+    struct Chunk {
+        std::vector<Token> tokens;
+        std::vector<Error> errors;
+        size_t first_line;
+    };
+
+    // Scans the tokens that start in [begin, end) of the source, counting
+    // lines from 0. The last one may run past `end`; scanning stops after it.
+    void scan_chunk(size_t begin, size_t end);
+    // Makes the next chunk scanned ahead the tokens being handed out.
+    void take_chunk();
+    // Reports the errors kept from scanning ahead that come before the
+    // token at `token_index`, where scanning one token at a time would have
+    // found them.
+    void report_deferred_errors(size_t token_index);
+
     void log_error(const std::string &error);
+    void report_error(const Error &deferred);
     bool is_at_end() const;
 
-    std::string curr_token();
+    std::string_view curr_token() const;
 
     char advance();
     bool match(char expected);
@@ -32,8 +75,18 @@ struct Scanner {
     void number();
     void identifier();
 
-    std::string source;
+    std::shared_ptr<const Source> m_source;
+    std::string_view text;
+    // The tokens scanned, of which the first `handed_out` have been handed
+    // out, with what their lines are counted from.
     std::vector<Token> tokens;
+    size_t handed_out;
+    size_t first_line;
+    // Errors are reported as they are found, unless scanning ahead, which
+    // keeps them here, by how many tokens come before them, until then.
+    std::optional<std::vector<Error>> deferred_errors;
+    // The chunks scanned ahead and not yet handed out, last first.
+    std::vector<Chunk> chunks;
     size_t token_start_idx;
     size_t curr_idx;
     size_t line;
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include "src/syntactics/parser.h"
+#include "src/syntactics/scanner.h"
+
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+TEST(ScannerTest, TokensViewTheSource) {
+    TokenBuffer buffer =
+        Scanner(std::stringstream{"var name = \"text\" + 1.5;"}).scan_tokens();
+    ASSERT_EQ(buffer.tokens.size(), 8);
+    std::string_view source = buffer.source->text();
+
+    for (const Token &token : buffer.tokens) {
+        EXPECT_GE(token.lexeme.data(), source.data());
+        EXPECT_LE(token.lexeme.data() + token.lexeme.size(),
+                  source.data() + source.size());
+    }
+    EXPECT_EQ(buffer.tokens[1].lexeme, "name");
+    EXPECT_FALSE(buffer.tokens[1].literal.has_value());
+    EXPECT_EQ(buffer.tokens[3].lexeme, "\"text\"");
+    EXPECT_EQ(std::get<std::string_view>(buffer.tokens[3].literal.value()),
+              "text");
+    EXPECT_EQ(std::get<double>(buffer.tokens[5].literal.value()), 1.5);
+    EXPECT_EQ(buffer.tokens.back().type, END_OF_FILE);
+}
+
+TEST(ScannerTest, ScansNumbersOutOfRangeAsStrtodDoes) {
+    std::string huge = "1" + std::string(400, '0');
+    std::string tiny = "0." + std::string(400, '0') + "1";
+    TokenBuffer buffer =
+        Scanner(std::stringstream{huge + " " + huge + ".5 " + tiny})
+            .scan_tokens();
+    ASSERT_EQ(buffer.tokens.size(), 4);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(std::get<double>(buffer.tokens[i].literal.value()),
+                  std::strtod(std::string(buffer.tokens[i].lexeme).c_str(),
+                              nullptr))
+            << buffer.tokens[i].lexeme;
+    }
+    EXPECT_EQ(std::get<double>(buffer.tokens[0].literal.value()),
+              std::numeric_limits<double>::infinity());
+}
+
+TEST(ScannerTest, ProgramKeepsTheSource) {
+    Program program =
+        Parser(Scanner(std::stringstream{"print greeting;"})).parse();
+    ASSERT_EQ(program.statements.size(), 1);
+
+    auto &print = dynamic_cast<const Stmt::Print &>(*program.statements[0]);
+    auto &variable = dynamic_cast<const Expr::Variable &>(*print.expression);
+    EXPECT_EQ(variable.name.lexeme, "greeting");
+    EXPECT_EQ(variable.name.lexeme.data(), program.source->text().data() + 6);
+}
+
+TEST(ScannerTest, RecognisesKeywords) {
+    TokenBuffer buffer =
+        Scanner(std::stringstream{"and class else false for fun if nil or "
+                                  "print return super this true var while "
+                                  "an classes whiles i fo _and vars"})
+            .scan_tokens();
+    std::vector<TokenType> types;
+    for (const Token &token : buffer.tokens)
+        types.push_back(token.type);
+
+    std::vector<TokenType> expected{
+        AND,        CLASS,      ELSE,       FALSE,      FOR,
+        FUN,        IF,         NIL,        OR,         PRINT,
+        RETURN,     SUPER,      THIS,       TRUE,       VAR,
+        WHILE,      IDENTIFIER, IDENTIFIER, IDENTIFIER, IDENTIFIER,
+        IDENTIFIER, IDENTIFIER, IDENTIFIER, END_OF_FILE};
+    EXPECT_EQ(types, expected);
+}
+
+TEST(ScannerTest, CountsLinesInCommentsAndStrings) {
+    TokenBuffer buffer = Scanner(std::stringstream{
+                                     "// a comment\n"
+                                     "\t  print \"one\ntwo\n\"; // another\n"
+                                     "   x"})
+                             .scan_tokens();
+    ASSERT_EQ(buffer.tokens.size(), 5);
+    EXPECT_EQ(buffer.tokens[0].line, 2);
+    EXPECT_EQ(buffer.tokens[1].line, 4);
+    EXPECT_EQ(std::get<std::string_view>(buffer.tokens[1].literal.value()),
+              "one\ntwo\n");
+    EXPECT_EQ(buffer.tokens[3].lexeme, "x");
+    EXPECT_EQ(buffer.tokens[3].line, 5);
+}
+
+TEST(ScannerTest, NextTokenScansOneTokenAtATime) {
+    std::string source = "fun f(a) { // comment\n return a * 2; }";
+    TokenBuffer buffer = Scanner(std::stringstream{source}).scan_tokens();
+
+    Scanner scanner(std::stringstream{source});
+    for (const Token &expected : buffer.tokens) {
+        Token token = scanner.next_token();
+        EXPECT_EQ(token.type, expected.type);
+        EXPECT_EQ(token.lexeme, expected.lexeme);
+        EXPECT_EQ(token.line, expected.line);
+    }
+    EXPECT_EQ(scanner.next_token().type, END_OF_FILE);
+    EXPECT_EQ(scanner.next_token().type, END_OF_FILE);
+}
+
+namespace {
+
+// A source big enough to be scanned in chunks, with strings that run over
+// lines, one of them over several whole chunks, and quotes in comments.
+std::string chunked_source() {
+    std::string source;
+    for (int i = 0; source.size() < (1 << 20); ++i) {
+        source += "var a = \"one\ntwo\"; // \"not a string\n";
+        source += "print a + 12.5 * b.c(d, e) != !f;\n";
+        if (i % 7 == 0)
+            source += "fun g() { return \"\n\n\"; }\n";
+        if (i == 5000)
+            source += "\"" + std::string(300000, '\n') + "\";\n";
+    }
+    return source;
+}
+
+void expect_same_tokens(const std::vector<Token> &tokens,
+                        const std::vector<Token> &expected) {
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(tokens[i].type, expected[i].type);
+        EXPECT_EQ(tokens[i].lexeme.data(), expected[i].lexeme.data());
+        EXPECT_EQ(tokens[i].lexeme.size(), expected[i].lexeme.size());
+        EXPECT_EQ(tokens[i].line, expected[i].line);
+        EXPECT_EQ(tokens[i].literal, expected[i].literal);
+    }
+}
+
+} // namespace
+
+TEST(ScannerTest, ScansInChunksAsAtOnce) {
+    auto source = std::make_shared<const Source>(chunked_source());
+    TokenBuffer expected = Scanner(source).scan_tokens();
+
+    for (size_t threads : {2, 3, 16}) {
+        Scanner scanner(source);
+        TokenBuffer buffer = scanner.scan_tokens(threads);
+        EXPECT_FALSE(scanner.had_error);
+        expect_same_tokens(buffer.tokens, expected.tokens);
+    }
+
+    Scanner scanner(source);
+    scanner.scan_ahead(4);
+    std::vector<Token> tokens;
+    do {
+        tokens.push_back(scanner.next_token());
+    } while (tokens.back().type != END_OF_FILE);
+    expect_same_tokens(tokens, expected.tokens);
+    EXPECT_EQ(scanner.next_token().type, END_OF_FILE);
+}
+
+TEST(ScannerTest, ReportsErrorsOfChunksInOrder) {
+    // The unterminated string runs over the chunks after it.
+    auto source = std::make_shared<const Source>(
+        chunked_source() + "@\n" + chunked_source() + "#\"" +
+        std::string(300000, '\n'));
+
+    testing::internal::CaptureStderr();
+    TokenBuffer expected = Scanner(source).scan_tokens();
+    std::string expected_errors = testing::internal::GetCapturedStderr();
+    EXPECT_NE(expected_errors.find("Unexpected character: @"),
+              std::string::npos);
+    EXPECT_NE(expected_errors.find("Unterminated string."), std::string::npos);
+
+    Scanner scanner(source);
+    testing::internal::CaptureStderr();
+    TokenBuffer buffer = scanner.scan_tokens(8);
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), expected_errors);
+    EXPECT_TRUE(scanner.had_error);
+    expect_same_tokens(buffer.tokens, expected.tokens);
+}
+
+TEST(ScannerTest, ScanningAheadReportsErrorsWhenReachingThem) {
+    auto source = std::make_shared<const Source>(chunked_source() + "@\n" +
+                                                 chunked_source());
+    auto tokens_before_error = [](Scanner &scanner) {
+        size_t tokens = 0;
+        testing::internal::CaptureStderr();
+        while (!scanner.had_error) {
+            scanner.next_token();
+            ++tokens;
+        }
+        testing::internal::GetCapturedStderr();
+        return tokens;
+    };
+
+    Scanner expected(source);
+    Scanner scanner(source);
+    scanner.scan_ahead(4);
+    EXPECT_FALSE(scanner.had_error);
+    EXPECT_EQ(tokens_before_error(scanner), tokens_before_error(expected));
+}
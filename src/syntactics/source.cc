@@ -0,0 +1,61 @@
+#include "src/syntactics/source.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+std::unique_ptr<Source> Source::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat status;
+        void *mapping = MAP_FAILED;
+        // Empty files cannot be mapped, and pipes or terminals have no size
+        // to map.
+        if (fstat(fd, &status) == 0 and S_ISREG(status.st_mode) and
+            status.st_size > 0) {
+            mapping =
+                mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping != MAP_FAILED) {
+            // The scanner reads the file once, front to back.
+            madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+            return std::unique_ptr<Source>(
+                new Source(static_cast<const char *>(mapping),
+                           static_cast<size_t>(status.st_size)));
+        }
+    }
+
+    std::ifstream ifs(path);
+    return std::make_unique<Source>(ifs);
+}
+
+Source::Source(std::string contents)
+    : contents(std::move(contents)), mapping(nullptr), mapping_size(0) {}
+
+Source::Source(std::istream &is)
+    : contents(), mapping(nullptr), mapping_size(0) {
+    std::ostringstream ss;
+    ss << is.rdbuf();
+    contents = std::move(ss).str();
+}
+
+Source::Source(const char *mapping, size_t mapping_size)
+    : contents(), mapping(mapping), mapping_size(mapping_size) {}
+
+Source::~Source() {
+    if (mapping != nullptr) {
+        munmap(const_cast<char *>(mapping), mapping_size);
+    }
+}
+
+std::string_view Source::text() const {
+    if (mapping != nullptr) {
+        return {mapping, mapping_size};
+    }
+    return contents;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// The text of a program, which its tokens view. A script file is mapped
+// read-only rather than copied; anything that cannot be mapped, like a pipe,
+// is read into memory.
+struct Source {
+    // A file that cannot be opened reads as empty.
+    static std::unique_ptr<Source> open(const std::string &path);
+
+    explicit Source(std::string contents);
+    // Reads all of `is`.
+    explicit Source(std::istream &is);
+    ~Source();
+
+    Source(const Source &) = delete;
+    Source &operator=(const Source &) = delete;
+
+    std::string_view text() const;
+
+  private:
+    Source(const char *mapping, size_t mapping_size);
+
+    std::string contents;
+    const char *mapping;
+    size_t mapping_size;
+};
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "src/syntactics/source.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// A file with `contents`, removed at the end of the test.
+struct TemporaryFile {
+    explicit TemporaryFile(const std::string &contents)
+        : path(testing::TempDir() + "source_test.lox") {
+        std::ofstream(path) << contents;
+    }
+    ~TemporaryFile() { std::remove(path.c_str()); }
+
+    std::string path;
+};
+
+} // namespace
+
+TEST(SourceTest, MapsFiles) {
+    TemporaryFile file("print \"mapped\";\n");
+    auto source = Source::open(file.path);
+    EXPECT_EQ(source->text(), "print \"mapped\";\n");
+}
+
+TEST(SourceTest, EmptyAndMissingFilesReadAsEmpty) {
+    TemporaryFile file("");
+    EXPECT_EQ(Source::open(file.path)->text(), "");
+    EXPECT_EQ(Source::open(file.path + ".missing")->text(), "");
+}
+
+TEST(SourceTest, ReadsStreams) {
+    std::stringstream stream("var a = 1;");
+    EXPECT_EQ(Source(stream).text(), "var a = 1;");
+    EXPECT_EQ(Source(std::string("print a;")).text(), "print a;");
+}
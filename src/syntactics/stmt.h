@@ -1,15 +1,30 @@
 #pragma once
+#include "src/syntactics/counted_loop.h"
 #include "src/syntactics/expr.h"
 #include "src/syntactics/stmt.fwd.h"
-#include <memory>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <vector>
 
 struct StmtVisitor;
 
+enum class StmtKind : uint8_t {
+    BLOCK,
+    CLASS,
+    EXPRESSION,
+    IF,
+    FUNCTION,
+    PRINT,
+    RETURN,
+    VAR,
+    WHILE,
+};
+
 struct Stmt {
     virtual void accept(StmtVisitor &visitor) const = 0;
 
-    Stmt() = default;
+    explicit Stmt(StmtKind kind) : kind(kind) {}
     Stmt(const Stmt &) = default;
     Stmt &operator=(const Stmt &) = default;
     Stmt(Stmt &&) = default;
@@ -17,6 +32,9 @@ struct Stmt {
 
     virtual ~Stmt() = default;
 
+    // The concrete type of the node, for dispatch().
+    StmtKind kind;
+
     struct Block;
     struct Class;
     struct Expression;
@@ -29,69 +47,69 @@ struct Stmt {
 };
 
 struct Stmt::Block : Stmt {
-    Block(std::vector<std::shared_ptr<Stmt>> statements);
+    Block(std::pmr::vector<Stmt *> statements);
     virtual void accept(StmtVisitor &visitor) const override;
-    std::vector<std::shared_ptr<Stmt>> statements;
+    std::pmr::vector<Stmt *> statements;
 };
 
 struct Stmt::Class : Stmt {
-    Class(Token name, std::shared_ptr<Expr::Variable> superclass,
-          std::vector<std::shared_ptr<Stmt::Function>> methods);
+    Class(Token name, Expr::Variable *superclass,
+          std::pmr::vector<Stmt::Function *> methods);
     virtual void accept(StmtVisitor &visitor) const override;
     Token name;
-    std::shared_ptr<Expr::Variable> superclass;
-    std::vector<std::shared_ptr<Stmt::Function>> methods;
+    Expr::Variable *superclass;
+    std::pmr::vector<Stmt::Function *> methods;
 };
 
 struct Stmt::Expression : Stmt {
-    Expression(std::shared_ptr<Expr> expression);
+    Expression(Expr *expression);
     virtual void accept(StmtVisitor &visitor) const override;
-    std::shared_ptr<Expr> expression;
+    Expr *expression;
 };
 
 struct Stmt::If : Stmt {
-    If(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> then_branch,
-       std::shared_ptr<Stmt> else_branch);
+    If(Expr *condition, Stmt *then_branch, Stmt *else_branch);
     virtual void accept(StmtVisitor &visitor) const override;
-    std::shared_ptr<Expr> condition;
-    std::shared_ptr<Stmt> then_branch;
-    std::shared_ptr<Stmt> else_branch;
+    Expr *condition;
+    Stmt *then_branch;
+    Stmt *else_branch;
 };
 
 struct Stmt::Function : Stmt {
-    Function(Token name, std::vector<Token> params,
-             std::vector<std::shared_ptr<Stmt>> body);
+    Function(Token name, std::pmr::vector<Token> params,
+             std::pmr::vector<Stmt *> body);
     virtual void accept(StmtVisitor &visitor) const override;
     Token name;
-    std::vector<Token> params;
-    std::vector<std::shared_ptr<Stmt>> body;
+    std::pmr::vector<Token> params;
+    std::pmr::vector<Stmt *> body;
 };
 
 struct Stmt::Print : Stmt {
-    Print(std::shared_ptr<Expr> expression);
+    Print(Expr *expression);
     virtual void accept(StmtVisitor &visitor) const override;
-    std::shared_ptr<Expr> expression;
+    Expr *expression;
 };
 
 struct Stmt::Return : Stmt {
-    Return(Token keyword, std::shared_ptr<Expr> value);
+    Return(Token keyword, Expr *value);
     virtual void accept(StmtVisitor &visitor) const override;
     Token keyword;
-    std::shared_ptr<Expr> value;
+    Expr *value;
 };
 
 struct Stmt::Var : Stmt {
-    Var(Token name, std::shared_ptr<Expr> initializer);
+    Var(Token name, Expr *initializer);
     virtual void accept(StmtVisitor &visitor) const override;
     Token name;
-    std::shared_ptr<Expr> initializer;
+    Expr *initializer;
 };
 
 struct Stmt::While : Stmt {
-    While(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> body);
+    While(Expr *condition, Stmt *body);
     virtual void accept(StmtVisitor &visitor) const override;
-    std::shared_ptr<Expr> condition;
-    std::shared_ptr<Stmt> body;
+    Expr *condition;
+    Stmt *body;
+    mutable std::optional<CountedLoop> counted{};
 };
 
 struct StmtVisitor {
@@ -105,3 +123,38 @@ struct StmtVisitor {
     virtual void visit_var_stmt(const Stmt::Var &stmt) = 0;
     virtual void visit_while_stmt(const Stmt::While &stmt) = 0;
 };
+
+// Calls the visit method for the concrete type of `stmt`.
+template <typename Visitor>
+void dispatch(const Stmt &stmt, Visitor &visitor) {
+    switch (stmt.kind) {
+    case StmtKind::BLOCK:
+        visitor.visit_block_stmt(static_cast<const Stmt::Block &>(stmt));
+        return;
+    case StmtKind::CLASS:
+        visitor.visit_class_stmt(static_cast<const Stmt::Class &>(stmt));
+        return;
+    case StmtKind::EXPRESSION:
+        visitor.visit_expression_stmt(
+            static_cast<const Stmt::Expression &>(stmt));
+        return;
+    case StmtKind::IF:
+        visitor.visit_if_stmt(static_cast<const Stmt::If &>(stmt));
+        return;
+    case StmtKind::FUNCTION:
+        visitor.visit_function_stmt(static_cast<const Stmt::Function &>(stmt));
+        return;
+    case StmtKind::PRINT:
+        visitor.visit_print_stmt(static_cast<const Stmt::Print &>(stmt));
+        return;
+    case StmtKind::RETURN:
+        visitor.visit_return_stmt(static_cast<const Stmt::Return &>(stmt));
+        return;
+    case StmtKind::VAR:
+        visitor.visit_var_stmt(static_cast<const Stmt::Var &>(stmt));
+        return;
+    case StmtKind::WHILE:
+        visitor.visit_while_stmt(static_cast<const Stmt::While &>(stmt));
+        return;
+    }
+}
@@ -3,17 +3,17 @@
 #include "token.h"
 #include <sstream>
 
-Token::Token(TokenType type, std::string lexeme, int line)
-    : type(type), lexeme(std::move(lexeme)), line(line) {}
-Token::Token(TokenType type, std::string lexeme, int line, double number)
-    : type(type), lexeme(std::move(lexeme)), line(line), literal(number) {}
-Token::Token(TokenType type, std::string lexeme, int line, std::string literal)
-    : type(type), lexeme(std::move(lexeme)), line(line),
-      literal(std::move(literal)) {}
+Token::Token(TokenType type, std::string_view lexeme, int line)
+    : type(type), line(line), lexeme(lexeme) {}
+Token::Token(TokenType type, std::string_view lexeme, int line, double number)
+    : type(type), line(line), lexeme(lexeme), literal(number) {}
+Token::Token(TokenType type, std::string_view lexeme, int line,
+             std::string_view literal)
+    : type(type), line(line), lexeme(lexeme), literal(literal) {}
 
 Token::Token(bool val)
-    : type(val ? TRUE : FALSE), lexeme(val ? "true" : "false"), line(-1) {}
-Token::Token(std::nullptr_t nil) : type(NIL), lexeme("nil"), line(-1) {}
+    : type(val ? TRUE : FALSE), line(-1), lexeme(val ? "true" : "false") {}
+Token::Token(std::nullptr_t nil) : type(NIL), line(-1), lexeme("nil") {}
 
 std::string Token::literal_to_string() const {
     if (literal.has_value()) {
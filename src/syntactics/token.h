@@ -1,9 +1,14 @@
 #pragma once
 
+#include "src/syntactics/source.h"
+
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 enum TokenType {
     // Single-character tokens.
@@ -54,12 +59,16 @@ enum TokenType {
     END_OF_FILE
 };
 
-using TokenLiteral = std::variant<double, std::string>;
+// A string literal views its text, without the quotes, in the source.
+using TokenLiteral = std::variant<double, std::string_view>;
 
+// A token views its lexeme in the source it was scanned from, so copying it
+// allocates nothing; the source must outlive it (see TokenBuffer).
 struct Token {
-    Token(TokenType type, std::string lexeme, int line);
-    Token(TokenType type, std::string lexeme, int line, double number);
-    Token(TokenType type, std::string lexeme, int line, std::string literal);
+    Token(TokenType type, std::string_view lexeme, int line);
+    Token(TokenType type, std::string_view lexeme, int line, double number);
+    Token(TokenType type, std::string_view lexeme, int line,
+          std::string_view literal);
 
     // Create ghost tokens
     Token(bool val);
@@ -68,9 +77,15 @@ struct Token {
     std::string literal_to_string() const;
 
     TokenType type;
-    std::string lexeme;
     int line;
+    std::string_view lexeme;
     std::optional<TokenLiteral> literal;
 };
 
+// The tokens of a program together with the source they view.
+struct TokenBuffer {
+    std::shared_ptr<const Source> source;
+    std::vector<Token> tokens;
+};
+
 std::ostream &operator<<(std::ostream &os, const Token &token);
\ No newline at end of file
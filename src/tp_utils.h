@@ -1,8 +1,13 @@
 #pragma once
 
 #include <concepts>
+#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <variant>
 
 template <typename TypeToCheck, typename TypeToCheckAgainst>
 concept type_is =
@@ -28,3 +33,17 @@ auto variant_cast(const std::variant<Args...> &v)
 
 template <class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
 template <class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
+
+// Hashes strings and string views alike, so that a StringMap can be searched
+// with a token's lexeme without first copying it into a std::string.
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view string) const {
+        return std::hash<std::string_view>{}(string);
+    }
+};
+
+template <typename Value>
+using StringMap =
+    std::unordered_map<std::string, Value, StringHash, std::equal_to<>>;
@@ -0,0 +1,45 @@
+#include "src/vm/chunk.h"
+
+#include <bit>
+
+void Chunk::write(uint8_t byte, int line) {
+    code.push_back(byte);
+    lines.push_back(line);
+}
+
+void Chunk::write_short(uint16_t value, int line) {
+    write(static_cast<uint8_t>(value >> 8), line);
+    write(static_cast<uint8_t>(value & 0xff), line);
+}
+
+void Chunk::write_long(uint32_t value, int line) {
+    write(static_cast<uint8_t>(value >> 16), line);
+    write_short(static_cast<uint16_t>(value & 0xffff), line);
+}
+
+uint16_t Chunk::read_short(size_t offset) const {
+    return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+}
+
+void Chunk::patch_short(size_t offset, uint16_t value) {
+    code[offset] = static_cast<uint8_t>(value >> 8);
+    code[offset + 1] = static_cast<uint8_t>(value & 0xff);
+}
+
+size_t Chunk::add_constant(const Value &value) {
+    if (value.is_number()) {
+        auto [it, added] = number_constants.try_emplace(
+            std::bit_cast<uint64_t>(value.as_number()), constants.size());
+        if (!added) {
+            return it->second;
+        }
+    } else if (value.is_obj()) {
+        auto [it, added] =
+            object_constants.try_emplace(value.as_obj(), constants.size());
+        if (!added) {
+            return it->second;
+        }
+    }
+    constants.push_back(value);
+    return constants.size() - 1;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "src/vm/value.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Operand widths: constants, globals and jumps take a 16 bit operand, local
+// slots, upvalue indices and argument counts take a single byte.
+enum OpCode : uint8_t {
+    OP_CONSTANT,
+    // Like OP_CONSTANT, with a 24 bit operand for the constants that are past
+    // what 16 bits can index.
+    OP_CONSTANT_LONG,
+    OP_NIL,
+    OP_TRUE,
+    OP_FALSE,
+    OP_POP,
+    OP_GET_LOCAL,
+    OP_SET_LOCAL,
+    OP_GET_GLOBAL,
+    OP_DEFINE_GLOBAL,
+    OP_SET_GLOBAL,
+    OP_GET_UPVALUE,
+    OP_SET_UPVALUE,
+    OP_GET_PROPERTY,
+    OP_SET_PROPERTY,
+    OP_GET_SUPER,
+    OP_EQUAL,
+    OP_NOT_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_NOT,
+    OP_NEGATE,
+    OP_PRINT,
+    OP_JUMP,
+    OP_JUMP_IF_FALSE,
+    OP_LOOP,
+    // For loops the Optimizer found to count, see CountedLoop. Takes the
+    // slots of the counter and of the limit, the comparison opcode and a
+    // jump past the loop, taken once the comparison fails.
+    OP_TEST_COUNTER,
+    // Adds a number constant to the counter of such a loop.
+    OP_ADD_TO_LOCAL,
+    // Makes the call instruction right after it reuse the frame of the
+    // function calling, which returns whatever the call returns.
+    OP_TAIL,
+    OP_CALL,
+    OP_INVOKE,
+    OP_SUPER_INVOKE,
+    OP_CLOSURE,
+    OP_CLOSE_UPVALUE,
+    OP_RETURN,
+    OP_CLASS,
+    OP_INHERIT,
+    OP_METHOD,
+};
+
+struct Chunk {
+    void write(uint8_t byte, int line);
+    void write_short(uint16_t value, int line);
+    void write_long(uint32_t value, int line);
+    uint16_t read_short(size_t offset) const;
+    void patch_short(size_t offset, uint16_t value);
+
+    // Returns the index of the value in the constant pool, which it is only
+    // added to if no equal number or object is there yet.
+    size_t add_constant(const Value &value);
+
+    std::vector<uint8_t> code;
+    // Source line of every byte in `code`, used for runtime errors.
+    std::vector<int> lines;
+    std::vector<Value> constants;
+
+  private:
+    // Index of every number constant by its bits, so that 0 and -0 stay
+    // apart, and of every object constant, interned strings included.
+    std::unordered_map<uint64_t, size_t> number_constants;
+    std::unordered_map<const Obj *, size_t> object_constants;
+};
@@ -0,0 +1,683 @@
+#include "src/vm/compiler.h"
+
+#include "src/logging.h"
+#include "src/tp_utils.h"
+#include "src/vm/vm.h"
+
+#include <limits>
+#include <variant>
+
+namespace {
+
+constexpr int MAX_LOCALS = std::numeric_limits<uint8_t>::max() + 1;
+constexpr int MAX_UPVALUES = std::numeric_limits<uint8_t>::max() + 1;
+
+} // namespace
+
+BytecodeCompiler::BytecodeCompiler(VirtualMachine &vm)
+    : vm(vm), current(nullptr), current_class(nullptr), current_line(0),
+      m_had_error(false) {}
+
+ObjFunction *
+BytecodeCompiler::compile(const std::pmr::vector<Stmt *> &stmts,
+                          InterpreterMode mode) {
+    FunctionState script{nullptr, vm.allocate<ObjFunction>(),
+                         FunctionType::SCRIPT, {}, {}, 0};
+    script.locals.push_back({"", 0, false});
+    current = &script;
+
+    for (size_t i = 0; i < stmts.size(); ++i) {
+        auto expression = dynamic_cast<const Stmt::Expression *>(stmts[i]);
+        if (mode == InterpreterMode::INTERACTIVE and expression != nullptr and
+            i + 1 == stmts.size()) {
+            // The REPL echoes the value of a trailing expression statement.
+            compile(expression->expression);
+            emit(OP_PRINT, current_line);
+        } else {
+            compile(stmts[i]);
+        }
+    }
+    emit_return(current_line);
+
+    current = nullptr;
+    return m_had_error ? nullptr : script.function;
+}
+
+bool BytecodeCompiler::had_error() const { return m_had_error; }
+
+void BytecodeCompiler::compile(const Expr *expr) {
+    dispatch(*expr, *this);
+}
+
+void BytecodeCompiler::compile(const Stmt *stmt) {
+    if (stmt) {
+        dispatch(*stmt, *this);
+    }
+}
+
+void BytecodeCompiler::compile(
+    const std::pmr::vector<Stmt *> &stmts) {
+    for (const auto &stmt : stmts) {
+        compile(stmt);
+    }
+}
+
+void BytecodeCompiler::visit_assign_expr(const Expr::Assign &expr) {
+    compile(expr.value);
+    set_named_variable(expr.name);
+}
+
+void BytecodeCompiler::visit_binary_expr(const Expr::Binary &expr) {
+    compile(expr.left);
+    compile(expr.right);
+
+    int line = expr.op.line;
+    switch (expr.op.type) {
+    case MINUS:
+        emit(OP_SUBTRACT, line);
+        break;
+    case SLASH:
+        emit(OP_DIVIDE, line);
+        break;
+    case STAR:
+        emit(OP_MULTIPLY, line);
+        break;
+    case PLUS:
+        emit(OP_ADD, line);
+        break;
+    case GREATER:
+        emit(OP_GREATER, line);
+        break;
+    case GREATER_EQUAL:
+        emit(OP_GREATER_EQUAL, line);
+        break;
+    case LESS:
+        emit(OP_LESS, line);
+        break;
+    case LESS_EQUAL:
+        emit(OP_LESS_EQUAL, line);
+        break;
+    case EQUAL_EQUAL:
+        emit(OP_EQUAL, line);
+        break;
+    case BANG_EQUAL:
+        emit(OP_NOT_EQUAL, line);
+        break;
+    default:
+        break;
+    }
+}
+
+void BytecodeCompiler::visit_call_expr(const Expr::Call &expr) {
+    compile_call(expr, false);
+}
+
+void BytecodeCompiler::compile_call(const Expr::Call &expr,
+                                    bool in_tail_position) {
+    auto arg_count = static_cast<uint8_t>(expr.arguments.size());
+
+    // Method calls skip the bound method the tree-walker would create. The
+    // opcode byte carries the line of the property name and the argument
+    // count carries the line of the closing paren, so both kinds of runtime
+    // error are reported where the tree-walker reports them.
+    switch (expr.callee->kind) {
+    case ExprKind::GET: {
+        auto &get = static_cast<const Expr::Get &>(*expr.callee);
+        compile(get.object);
+        for (const auto &argument : expr.arguments) {
+            compile(argument);
+        }
+        if (in_tail_position) {
+            emit(OP_TAIL, get.name.line);
+        }
+        emit(OP_INVOKE, get.name.line);
+        emit_short(identifier_constant(get.name.lexeme), get.name.line);
+        emit(arg_count, expr.paren.line);
+        return;
+    }
+    case ExprKind::SUPER: {
+        auto &super = static_cast<const Expr::Super &>(*expr.callee);
+        named_variable("this", super.keyword.line);
+        for (const auto &argument : expr.arguments) {
+            compile(argument);
+        }
+        named_variable("super", super.keyword.line);
+        if (in_tail_position) {
+            emit(OP_TAIL, super.method.line);
+        }
+        emit(OP_SUPER_INVOKE, super.method.line);
+        emit_short(identifier_constant(super.method.lexeme),
+                   super.method.line);
+        emit(arg_count, expr.paren.line);
+        return;
+    }
+    default:
+        break;
+    }
+
+    compile(expr.callee);
+    for (const auto &argument : expr.arguments) {
+        compile(argument);
+    }
+    if (in_tail_position) {
+        emit(OP_TAIL, expr.paren.line);
+    }
+    emit(OP_CALL, arg_count, expr.paren.line);
+}
+
+void BytecodeCompiler::visit_get_expr(const Expr::Get &expr) {
+    compile(expr.object);
+    emit(OP_GET_PROPERTY, expr.name.line);
+    emit_short(identifier_constant(expr.name.lexeme), expr.name.line);
+}
+
+void BytecodeCompiler::visit_grouping_expr(const Expr::Grouping &expr) {
+    compile(expr.expression);
+}
+
+void BytecodeCompiler::visit_lambda_expr(const Expr::Lambda &expr) {
+    function(expr.keyword, expr.params, expr.body, FunctionType::FUNCTION,
+             true);
+}
+
+void BytecodeCompiler::visit_literal_expr(const Expr::Literal &expr) {
+    int line = expr.value.line;
+    switch (expr.value.type) {
+    case NIL:
+        emit(OP_NIL, line);
+        break;
+    case TRUE:
+        emit(OP_TRUE, line);
+        break;
+    case FALSE:
+        emit(OP_FALSE, line);
+        break;
+    default:
+        if (!expr.value.literal.has_value()) {
+            break;
+        }
+        std::visit(overloaded{
+                       [&](double number) { emit_constant(number, line); },
+                       [&](std::string_view string) {
+                           emit_constant(vm.intern(string), line);
+                       },
+                   },
+                   expr.value.literal.value());
+        break;
+    }
+}
+
+void BytecodeCompiler::visit_logical_expr(const Expr::Logical &expr) {
+    compile(expr.left);
+
+    int line = expr.op.line;
+    if (expr.op.type == OR) {
+        size_t else_jump = emit_jump(OP_JUMP_IF_FALSE, line);
+        size_t end_jump = emit_jump(OP_JUMP, line);
+        patch_jump(else_jump);
+        emit(OP_POP, line);
+        compile(expr.right);
+        patch_jump(end_jump);
+    } else {
+        size_t end_jump = emit_jump(OP_JUMP_IF_FALSE, line);
+        emit(OP_POP, line);
+        compile(expr.right);
+        patch_jump(end_jump);
+    }
+}
+
+void BytecodeCompiler::visit_set_expr(const Expr::Set &expr) {
+    compile(expr.object);
+    compile(expr.value);
+    emit(OP_SET_PROPERTY, expr.name.line);
+    emit_short(identifier_constant(expr.name.lexeme), expr.name.line);
+}
+
+void BytecodeCompiler::visit_super_expr(const Expr::Super &expr) {
+    named_variable("this", expr.keyword.line);
+    named_variable("super", expr.keyword.line);
+    emit(OP_GET_SUPER, expr.method.line);
+    emit_short(identifier_constant(expr.method.lexeme), expr.method.line);
+}
+
+void BytecodeCompiler::visit_this_expr(const Expr::This &expr) {
+    named_variable(expr.keyword);
+}
+
+void BytecodeCompiler::visit_unary_expr(const Expr::Unary &expr) {
+    compile(expr.right);
+    switch (expr.op.type) {
+    case BANG:
+        emit(OP_NOT, expr.op.line);
+        break;
+    case MINUS:
+        emit(OP_NEGATE, expr.op.line);
+        break;
+    default:
+        break;
+    }
+}
+
+void BytecodeCompiler::visit_variable_expr(const Expr::Variable &expr) {
+    named_variable(expr.name);
+}
+
+void BytecodeCompiler::visit_block_stmt(const Stmt::Block &stmt) {
+    begin_scope();
+    compile(stmt.statements);
+    end_scope();
+}
+
+void BytecodeCompiler::visit_class_stmt(const Stmt::Class &stmt) {
+    int line = stmt.name.line;
+    uint16_t name_constant = identifier_constant(stmt.name.lexeme);
+    declare_variable(stmt.name);
+
+    emit(OP_CLASS, line);
+    emit_short(name_constant, line);
+    define_variable(stmt.name);
+
+    ClassState class_state{current_class, false};
+    current_class = &class_state;
+
+    if (stmt.superclass != nullptr) {
+        const Token &superclass_name = stmt.superclass->name;
+        named_variable(superclass_name);
+
+        begin_scope();
+        add_local(Token(IDENTIFIER, "super", superclass_name.line));
+        mark_initialized();
+
+        named_variable(stmt.name);
+        emit(OP_INHERIT, superclass_name.line);
+        class_state.has_superclass = true;
+    }
+
+    named_variable(stmt.name);
+    for (const auto &method : stmt.methods) {
+        FunctionType type = method->name.lexeme == "init"
+                                ? FunctionType::INITIALIZER
+                                : FunctionType::METHOD;
+        function(method->name, method->params, method->body, type, false);
+        emit(OP_METHOD, method->name.line);
+        emit_short(identifier_constant(method->name.lexeme),
+                   method->name.line);
+    }
+    emit(OP_POP, line);
+
+    if (class_state.has_superclass) {
+        end_scope();
+    }
+
+    current_class = current_class->enclosing;
+}
+
+void BytecodeCompiler::visit_expression_stmt(const Stmt::Expression &stmt) {
+    compile(stmt.expression);
+    emit(OP_POP, current_line);
+}
+
+void BytecodeCompiler::visit_if_stmt(const Stmt::If &stmt) {
+    compile(stmt.condition);
+
+    size_t then_jump = emit_jump(OP_JUMP_IF_FALSE, current_line);
+    emit(OP_POP, current_line);
+    compile(stmt.then_branch);
+
+    size_t else_jump = emit_jump(OP_JUMP, current_line);
+    patch_jump(then_jump);
+    emit(OP_POP, current_line);
+    compile(stmt.else_branch);
+    patch_jump(else_jump);
+}
+
+void BytecodeCompiler::visit_function_stmt(const Stmt::Function &stmt) {
+    declare_variable(stmt.name);
+    // A function may refer to itself, so it is usable before its body is
+    // compiled.
+    mark_initialized();
+    function(stmt.name, stmt.params, stmt.body, FunctionType::FUNCTION, false);
+    define_variable(stmt.name);
+}
+
+void BytecodeCompiler::visit_print_stmt(const Stmt::Print &stmt) {
+    compile(stmt.expression);
+    emit(OP_PRINT, current_line);
+}
+
+void BytecodeCompiler::visit_return_stmt(const Stmt::Return &stmt) {
+    int line = stmt.keyword.line;
+    if (stmt.value == nullptr or current->type == FunctionType::INITIALIZER) {
+        emit_return(line);
+        return;
+    }
+
+    if (stmt.value->kind == ExprKind::CALL) {
+        compile_call(static_cast<const Expr::Call &>(*stmt.value), true);
+    } else {
+        compile(stmt.value);
+    }
+    emit(OP_RETURN, line);
+}
+
+void BytecodeCompiler::visit_var_stmt(const Stmt::Var &stmt) {
+    declare_variable(stmt.name);
+    if (stmt.initializer) {
+        compile(stmt.initializer);
+    } else {
+        emit(OP_NIL, stmt.name.line);
+    }
+    define_variable(stmt.name);
+}
+
+void BytecodeCompiler::visit_while_stmt(const Stmt::While &stmt) {
+    if (stmt.counted.has_value() and compile_counted_loop(stmt)) {
+        return;
+    }
+
+    size_t loop_start = current_chunk().code.size();
+    compile(stmt.condition);
+
+    size_t exit_jump = emit_jump(OP_JUMP_IF_FALSE, current_line);
+    emit(OP_POP, current_line);
+    compile(stmt.body);
+    emit_loop(loop_start, current_line);
+
+    patch_jump(exit_jump);
+    emit(OP_POP, current_line);
+}
+
+// The limit is evaluated once, into a local of its own, and the condition and
+// the last statement of the body become an instruction each.
+bool BytecodeCompiler::compile_counted_loop(const Stmt::While &stmt) {
+    const CountedLoop &loop = *stmt.counted;
+    int counter = resolve_local(*current, loop.counter->name.lexeme);
+    if (counter == -1 or current->locals.size() == MAX_LOCALS) {
+        return false;
+    }
+    uint8_t comparison;
+    switch (loop.comparison) {
+    case LESS:
+        comparison = OP_LESS;
+        break;
+    case LESS_EQUAL:
+        comparison = OP_LESS_EQUAL;
+        break;
+    case GREATER:
+        comparison = OP_GREATER;
+        break;
+    default:
+        comparison = OP_GREATER_EQUAL;
+        break;
+    }
+    int line = static_cast<const Expr::Binary &>(*stmt.condition).op.line;
+
+    begin_scope();
+    compile(loop.limit);
+    current->locals.push_back({"", current->scope_depth, false});
+    auto limit = static_cast<uint8_t>(current->locals.size() - 1);
+
+    size_t loop_start = current_chunk().code.size();
+    emit(OP_TEST_COUNTER, static_cast<uint8_t>(counter), line);
+    emit(limit, comparison, line);
+    size_t exit_jump = emit_jump_offset(line);
+
+    const auto &body = static_cast<const Stmt::Block &>(*stmt.body).statements;
+    begin_scope();
+    for (size_t i = 0; i + 1 < body.size(); ++i) {
+        compile(body[i]);
+    }
+    end_scope();
+    emit(OP_ADD_TO_LOCAL, static_cast<uint8_t>(counter), line);
+    emit_short(make_constant(loop.step), line);
+    emit_loop(loop_start, line);
+
+    patch_jump(exit_jump);
+    end_scope();
+    return true;
+}
+
+void BytecodeCompiler::function(const Token &name,
+                                const std::pmr::vector<Token> &params,
+                                const std::pmr::vector<Stmt *> &body,
+                                FunctionType type, bool is_lambda) {
+    FunctionState state{current, vm.allocate<ObjFunction>(), type, {}, {}, 0};
+    state.function->arity = static_cast<int>(params.size());
+    state.function->is_lambda = is_lambda;
+    if (!is_lambda) {
+        state.function->name = vm.intern(name.lexeme);
+    }
+
+    // Slot zero holds the receiver for methods and the callee otherwise.
+    state.locals.push_back(
+        {type == FunctionType::FUNCTION ? "" : "this", 0, false});
+    current = &state;
+
+    begin_scope();
+    for (const Token &param : params) {
+        declare_variable(param);
+        mark_initialized();
+    }
+    compile(body);
+    emit_return(name.line);
+
+    current = state.enclosing;
+
+    state.function->upvalue_count = static_cast<int>(state.upvalues.size());
+    emit(OP_CLOSURE, name.line);
+    emit_short(make_constant(state.function), name.line);
+    for (const Upvalue &upvalue : state.upvalues) {
+        emit(upvalue.is_local ? 1 : 0, upvalue.index, name.line);
+    }
+}
+
+void BytecodeCompiler::begin_scope() { ++current->scope_depth; }
+
+void BytecodeCompiler::end_scope() {
+    --current->scope_depth;
+
+    auto &locals = current->locals;
+    while (!locals.empty() and locals.back().depth > current->scope_depth) {
+        emit(locals.back().is_captured ? OP_CLOSE_UPVALUE : OP_POP,
+             current_line);
+        locals.pop_back();
+    }
+}
+
+void BytecodeCompiler::declare_variable(const Token &name) {
+    if (current->scope_depth == 0) {
+        return;
+    }
+    add_local(name);
+}
+
+void BytecodeCompiler::define_variable(const Token &name) {
+    if (current->scope_depth > 0) {
+        mark_initialized();
+        return;
+    }
+    emit(OP_DEFINE_GLOBAL, name.line);
+    emit_short(identifier_constant(name.lexeme), name.line);
+}
+
+void BytecodeCompiler::add_local(const Token &name) {
+    if (current->locals.size() == MAX_LOCALS) {
+        error(name, "Too many local variables in function.");
+        return;
+    }
+    current->locals.push_back({name.lexeme, -1, false});
+}
+
+void BytecodeCompiler::mark_initialized() {
+    if (current->scope_depth == 0) {
+        return;
+    }
+    current->locals.back().depth = current->scope_depth;
+}
+
+int BytecodeCompiler::resolve_local(FunctionState &state,
+                                    std::string_view name) {
+    for (int i = static_cast<int>(state.locals.size()) - 1; i >= 0; --i) {
+        if (state.locals[i].name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int BytecodeCompiler::resolve_upvalue(FunctionState &state,
+                                      std::string_view name) {
+    if (state.enclosing == nullptr) {
+        return -1;
+    }
+
+    int local = resolve_local(*state.enclosing, name);
+    if (local != -1) {
+        state.enclosing->locals[local].is_captured = true;
+        return add_upvalue(state, static_cast<uint8_t>(local), true);
+    }
+
+    int upvalue = resolve_upvalue(*state.enclosing, name);
+    if (upvalue != -1) {
+        return add_upvalue(state, static_cast<uint8_t>(upvalue), false);
+    }
+
+    return -1;
+}
+
+int BytecodeCompiler::add_upvalue(FunctionState &state, uint8_t index,
+                                  bool is_local) {
+    for (size_t i = 0; i < state.upvalues.size(); ++i) {
+        const Upvalue &upvalue = state.upvalues[i];
+        if (upvalue.index == index and upvalue.is_local == is_local) {
+            return static_cast<int>(i);
+        }
+    }
+
+    if (state.upvalues.size() == MAX_UPVALUES) {
+        error("Too many closure variables in function.");
+        return 0;
+    }
+
+    state.upvalues.push_back({index, is_local});
+    return static_cast<int>(state.upvalues.size()) - 1;
+}
+
+void BytecodeCompiler::named_variable(const Token &name) {
+    named_variable(name.lexeme, name.line);
+}
+
+void BytecodeCompiler::named_variable(std::string_view name, int line) {
+    if (int local = resolve_local(*current, name); local != -1) {
+        emit(OP_GET_LOCAL, static_cast<uint8_t>(local), line);
+    } else if (int upvalue = resolve_upvalue(*current, name); upvalue != -1) {
+        emit(OP_GET_UPVALUE, static_cast<uint8_t>(upvalue), line);
+    } else {
+        emit(OP_GET_GLOBAL, line);
+        emit_short(identifier_constant(name), line);
+    }
+}
+
+void BytecodeCompiler::set_named_variable(const Token &name) {
+    int line = name.line;
+    if (int local = resolve_local(*current, name.lexeme); local != -1) {
+        emit(OP_SET_LOCAL, static_cast<uint8_t>(local), line);
+    } else if (int upvalue = resolve_upvalue(*current, name.lexeme);
+               upvalue != -1) {
+        emit(OP_SET_UPVALUE, static_cast<uint8_t>(upvalue), line);
+    } else {
+        emit(OP_SET_GLOBAL, line);
+        emit_short(identifier_constant(name.lexeme), line);
+    }
+}
+
+Chunk &BytecodeCompiler::current_chunk() { return current->function->chunk; }
+
+void BytecodeCompiler::emit(uint8_t byte, int line) {
+    current_line = line;
+    current_chunk().write(byte, line);
+}
+
+void BytecodeCompiler::emit(uint8_t byte1, uint8_t byte2, int line) {
+    emit(byte1, line);
+    emit(byte2, line);
+}
+
+void BytecodeCompiler::emit_short(uint16_t value, int line) {
+    current_line = line;
+    current_chunk().write_short(value, line);
+}
+
+void BytecodeCompiler::emit_constant(const Value &value, int line) {
+    size_t constant = current_chunk().add_constant(value);
+    if (constant <= std::numeric_limits<uint16_t>::max()) {
+        emit(OP_CONSTANT, line);
+        emit_short(static_cast<uint16_t>(constant), line);
+    } else if (constant < (1 << 24)) {
+        emit(OP_CONSTANT_LONG, line);
+        current_chunk().write_long(static_cast<uint32_t>(constant), line);
+    } else {
+        error("Too many constants in one chunk.");
+    }
+}
+
+void BytecodeCompiler::emit_return(int line) {
+    if (current->type == FunctionType::INITIALIZER) {
+        emit(OP_GET_LOCAL, 0, line);
+    } else {
+        emit(OP_NIL, line);
+    }
+    emit(OP_RETURN, line);
+}
+
+uint16_t BytecodeCompiler::make_constant(const Value &value) {
+    size_t constant = current_chunk().add_constant(value);
+    if (constant > std::numeric_limits<uint16_t>::max()) {
+        error("Too many constants in one chunk.");
+        return 0;
+    }
+    return static_cast<uint16_t>(constant);
+}
+
+uint16_t BytecodeCompiler::identifier_constant(std::string_view name) {
+    return make_constant(vm.intern(name));
+}
+
+size_t BytecodeCompiler::emit_jump(uint8_t instruction, int line) {
+    emit(instruction, line);
+    return emit_jump_offset(line);
+}
+
+size_t BytecodeCompiler::emit_jump_offset(int line) {
+    emit_short(0xffff, line);
+    return current_chunk().code.size() - 2;
+}
+
+void BytecodeCompiler::patch_jump(size_t offset) {
+    // -2 to adjust for the bytecode for the jump offset itself.
+    size_t jump = current_chunk().code.size() - offset - 2;
+    if (jump > std::numeric_limits<uint16_t>::max()) {
+        error("Too much code to jump over.");
+    }
+    current_chunk().patch_short(offset, static_cast<uint16_t>(jump));
+}
+
+void BytecodeCompiler::emit_loop(size_t loop_start, int line) {
+    emit(OP_LOOP, line);
+
+    size_t offset = current_chunk().code.size() - loop_start + 2;
+    if (offset > std::numeric_limits<uint16_t>::max()) {
+        error("Loop body too large.");
+    }
+    emit_short(static_cast<uint16_t>(offset), line);
+}
+
+void BytecodeCompiler::error(const Token &token, const std::string &message) {
+    m_had_error = true;
+    report_token_error(token, message);
+}
+
+void BytecodeCompiler::error(const std::string &message) {
+    m_had_error = true;
+    ::error(current_line, message);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "src/semantics/interpreter_mode.h"
+#include "src/syntactics/expr.h"
+#include "src/syntactics/stmt.h"
+#include "src/vm/chunk.h"
+#include "src/vm/object.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct VirtualMachine;
+
+// Lowers a resolved program into bytecode. Static errors have already been
+// reported by the Resolver, so the only errors left are the bytecode limits
+// (number of locals, upvalues, constants and jump distances).
+struct BytecodeCompiler final : ExprVisitor, StmtVisitor {
+    explicit BytecodeCompiler(VirtualMachine &vm);
+
+    // Returns the top-level script function, or nullptr on error.
+    ObjFunction *compile(const std::pmr::vector<Stmt *> &stmts,
+                         InterpreterMode mode);
+
+    bool had_error() const;
+
+  private:
+    enum class FunctionType {
+        SCRIPT,
+        FUNCTION,
+        INITIALIZER,
+        METHOD,
+    };
+
+    struct Local {
+        // Views the source of the program being compiled.
+        std::string_view name;
+        // -1 while the local is declared but not yet initialized.
+        int depth;
+        bool is_captured;
+    };
+
+    struct Upvalue {
+        uint8_t index;
+        bool is_local;
+    };
+
+    struct FunctionState {
+        FunctionState *enclosing;
+        ObjFunction *function;
+        FunctionType type;
+        std::vector<Local> locals;
+        std::vector<Upvalue> upvalues;
+        int scope_depth;
+    };
+
+    struct ClassState {
+        ClassState *enclosing;
+        bool has_superclass;
+    };
+
+    // dispatch() calls the visit methods below directly.
+    template <typename Visitor>
+    friend void dispatch(const Expr &expr, Visitor &visitor);
+    template <typename Visitor>
+    friend void dispatch(const Stmt &stmt, Visitor &visitor);
+
+    void visit_assign_expr(const Expr::Assign &expr) override;
+    void visit_binary_expr(const Expr::Binary &expr) override;
+    void visit_call_expr(const Expr::Call &expr) override;
+    void visit_get_expr(const Expr::Get &expr) override;
+    void visit_grouping_expr(const Expr::Grouping &expr) override;
+    void visit_lambda_expr(const Expr::Lambda &expr) override;
+    void visit_literal_expr(const Expr::Literal &expr) override;
+    void visit_logical_expr(const Expr::Logical &expr) override;
+    void visit_set_expr(const Expr::Set &expr) override;
+    void visit_super_expr(const Expr::Super &expr) override;
+    void visit_this_expr(const Expr::This &expr) override;
+    void visit_unary_expr(const Expr::Unary &expr) override;
+    void visit_variable_expr(const Expr::Variable &expr) override;
+
+    void visit_block_stmt(const Stmt::Block &stmt) override;
+    void visit_class_stmt(const Stmt::Class &stmt) override;
+    void visit_expression_stmt(const Stmt::Expression &stmt) override;
+    void visit_if_stmt(const Stmt::If &stmt) override;
+    void visit_function_stmt(const Stmt::Function &stmt) override;
+    void visit_print_stmt(const Stmt::Print &stmt) override;
+    void visit_return_stmt(const Stmt::Return &stmt) override;
+    void visit_var_stmt(const Stmt::Var &stmt) override;
+    void visit_while_stmt(const Stmt::While &stmt) override;
+
+    void compile(const Expr *expr);
+    void compile(const Stmt *stmt);
+    void compile(const std::pmr::vector<Stmt *> &stmts);
+    void compile_call(const Expr::Call &expr, bool in_tail_position);
+    // Returns false, having emitted nothing, for the loop to be compiled as
+    // written.
+    bool compile_counted_loop(const Stmt::While &stmt);
+
+    void function(const Token &name, const std::pmr::vector<Token> &params,
+                  const std::pmr::vector<Stmt *> &body,
+                  FunctionType type, bool is_lambda);
+
+    void begin_scope();
+    void end_scope();
+
+    void declare_variable(const Token &name);
+    void define_variable(const Token &name);
+    void add_local(const Token &name);
+    void mark_initialized();
+
+    int resolve_local(FunctionState &state, std::string_view name);
+    int resolve_upvalue(FunctionState &state, std::string_view name);
+    int add_upvalue(FunctionState &state, uint8_t index, bool is_local);
+
+    void named_variable(const Token &name);
+    void named_variable(std::string_view name, int line);
+    void set_named_variable(const Token &name);
+
+    Chunk &current_chunk();
+    void emit(uint8_t byte, int line);
+    void emit(uint8_t byte1, uint8_t byte2, int line);
+    void emit_short(uint16_t value, int line);
+    void emit_constant(const Value &value, int line);
+    void emit_return(int line);
+    uint16_t make_constant(const Value &value);
+    uint16_t identifier_constant(std::string_view name);
+    size_t emit_jump(uint8_t instruction, int line);
+    // The offset operand of a jump, for patch_jump().
+    size_t emit_jump_offset(int line);
+    void patch_jump(size_t offset);
+    void emit_loop(size_t loop_start, int line);
+
+    void error(const Token &token, const std::string &message);
+    void error(const std::string &message);
+
+    VirtualMachine &vm;
+    FunctionState *current;
+    ClassState *current_class;
+    // Line of the last emitted instruction, used for limit errors.
+    int current_line;
+    bool m_had_error;
+};
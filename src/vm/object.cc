@@ -0,0 +1,66 @@
+#include "src/vm/object.h"
+
+Obj::Obj(ObjType type) : type(type), is_marked(false), next(nullptr) {}
+
+ObjString::ObjString(std::string chars, size_t hash)
+    : Obj(ObjType::STRING), chars(std::move(chars)), hash(hash) {}
+
+ObjFunction::ObjFunction()
+    : Obj(ObjType::FUNCTION), arity(0), upvalue_count(0), chunk(),
+      name(nullptr), is_lambda(false) {}
+
+ObjNative::ObjNative(NativeFn function, int arity)
+    : Obj(ObjType::NATIVE), function(function), arity(arity) {}
+
+ObjUpvalue::ObjUpvalue(Value *slot)
+    : Obj(ObjType::UPVALUE), location(slot), closed(),
+      next_upvalue(nullptr) {}
+
+ObjClosure::ObjClosure(ObjFunction *function)
+    : Obj(ObjType::CLOSURE), function(function),
+      upvalues(function->upvalue_count, nullptr) {}
+
+ObjClass::ObjClass(ObjString *name)
+    : Obj(ObjType::CLASS), name(name), methods() {}
+
+ObjInstance::ObjInstance(ObjClass *klass)
+    : Obj(ObjType::INSTANCE), klass(klass), fields() {}
+
+ObjBoundMethod::ObjBoundMethod(Value receiver, ObjClosure *method)
+    : Obj(ObjType::BOUND_METHOD), receiver(receiver), method(method) {}
+
+static std::ostream &print_function(std::ostream &os,
+                                    const ObjFunction *function) {
+    if (function->is_lambda) {
+        return os << "<anonymous function>";
+    }
+    if (function->name == nullptr) {
+        return os << "<script>";
+    }
+    return os << "<fun " << function->name->chars << ">";
+}
+
+std::ostream &operator<<(std::ostream &os, const Obj &obj) {
+    switch (obj.type) {
+    case ObjType::BOUND_METHOD:
+        return print_function(
+            os, static_cast<const ObjBoundMethod &>(obj).method->function);
+    case ObjType::CLASS:
+        return os << static_cast<const ObjClass &>(obj).name->chars;
+    case ObjType::CLOSURE:
+        return print_function(os,
+                              static_cast<const ObjClosure &>(obj).function);
+    case ObjType::FUNCTION:
+        return print_function(os, static_cast<const ObjFunction *>(&obj));
+    case ObjType::INSTANCE:
+        return os << static_cast<const ObjInstance &>(obj).klass->name->chars
+                  << " instance";
+    case ObjType::NATIVE:
+        return os << "<native fn>";
+    case ObjType::STRING:
+        return os << static_cast<const ObjString &>(obj).chars;
+    case ObjType::UPVALUE:
+        return os << "upvalue";
+    }
+    return os;
+}
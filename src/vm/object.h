@@ -0,0 +1,126 @@
+#pragma once
+
+#include "src/vm/chunk.h"
+#include "src/vm/value.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ObjType {
+    BOUND_METHOD,
+    CLASS,
+    CLOSURE,
+    FUNCTION,
+    INSTANCE,
+    NATIVE,
+    STRING,
+    UPVALUE,
+};
+
+struct Obj {
+    explicit Obj(ObjType type);
+    virtual ~Obj() = default;
+
+    ObjType type;
+    bool is_marked;
+    // Intrusive list of every object owned by the VM, used by the sweeper.
+    Obj *next;
+};
+
+struct ObjString final : Obj {
+    ObjString(std::string chars, size_t hash);
+
+    std::string chars;
+    size_t hash;
+};
+
+// Strings are interned, so pointer identity is string equality.
+struct ObjStringHash {
+    size_t operator()(const ObjString *string) const { return string->hash; }
+};
+
+using Table = std::unordered_map<ObjString *, Value, ObjStringHash>;
+
+struct ObjFunction final : Obj {
+    ObjFunction();
+
+    int arity;
+    int upvalue_count;
+    Chunk chunk;
+    // nullptr for lambdas and for the top-level script.
+    ObjString *name;
+    // Named functions are printed as "<fun name>", lambdas anonymously.
+    bool is_lambda;
+};
+
+struct VirtualMachine;
+
+using NativeFn = Value (*)(VirtualMachine &vm, int arg_count, Value *args);
+
+struct ObjNative final : Obj {
+    ObjNative(NativeFn function, int arity);
+
+    NativeFn function;
+    int arity;
+};
+
+struct ObjUpvalue final : Obj {
+    explicit ObjUpvalue(Value *slot);
+
+    // Points into the VM stack while open, and at `closed` afterwards.
+    Value *location;
+    Value closed;
+    ObjUpvalue *next_upvalue;
+};
+
+struct ObjClosure final : Obj {
+    explicit ObjClosure(ObjFunction *function);
+
+    ObjFunction *function;
+    std::vector<ObjUpvalue *> upvalues;
+};
+
+struct ObjClass final : Obj {
+    explicit ObjClass(ObjString *name);
+
+    ObjString *name;
+    Table methods;
+};
+
+struct ObjInstance final : Obj {
+    explicit ObjInstance(ObjClass *klass);
+
+    ObjClass *klass;
+    Table fields;
+};
+
+struct ObjBoundMethod final : Obj {
+    ObjBoundMethod(Value receiver, ObjClosure *method);
+
+    Value receiver;
+    ObjClosure *method;
+};
+
+inline bool is_obj_type(const Value &value, ObjType type) {
+    return value.is_obj() and value.as_obj()->type == type;
+}
+
+template <typename T>
+T *as_obj(const Value &value) {
+    return static_cast<T *>(value.as_obj());
+}
+
+inline bool is_string(const Value &value) {
+    return is_obj_type(value, ObjType::STRING);
+}
+
+inline bool is_instance(const Value &value) {
+    return is_obj_type(value, ObjType::INSTANCE);
+}
+
+inline bool is_class(const Value &value) {
+    return is_obj_type(value, ObjType::CLASS);
+}
+
+std::ostream &operator<<(std::ostream &os, const Obj &obj);
@@ -0,0 +1,53 @@
+#include "src/vm/value.h"
+
+#include "src/semantics/object/lox_object.h"
+#include "src/vm/object.h"
+
+bool Value::is_falsey() const {
+    switch (type) {
+    case Type::NIL:
+        return true;
+    case Type::BOOL:
+        return !as.boolean;
+    case Type::NUMBER:
+        return !static_cast<bool>(as.number);
+    case Type::OBJ:
+        if (as.obj->type == ObjType::STRING) {
+            return static_cast<ObjString *>(as.obj)->chars.empty();
+        }
+        return false;
+    }
+    return false;
+}
+
+bool Value::operator==(const Value &other) const {
+    if (type != other.type) {
+        return false;
+    }
+    switch (type) {
+    case Type::NIL:
+        return true;
+    case Type::BOOL:
+        return as.boolean == other.as.boolean;
+    case Type::NUMBER:
+        return as.number == other.as.number;
+    case Type::OBJ:
+        // Strings are interned, so identity is equality for every object.
+        return as.obj == other.as.obj;
+    }
+    return false;
+}
+
+std::ostream &operator<<(std::ostream &os, const Value &value) {
+    switch (value.type) {
+    case Value::Type::NIL:
+        return os << LoxNull{};
+    case Value::Type::BOOL:
+        return os << value.as_bool();
+    case Value::Type::NUMBER:
+        return os << value.as_number();
+    case Value::Type::OBJ:
+        return os << *value.as_obj();
+    }
+    return os;
+}
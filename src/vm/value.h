@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+struct Obj;
+
+struct Value {
+    enum class Type : uint8_t { NIL, BOOL, NUMBER, OBJ };
+
+    // Trivial so that the VM stack can be reserved without being touched;
+    // value-initialisation (`Value{}`) still yields nil.
+    Value() = default;
+    Value(bool boolean) : type(Type::BOOL), as{.boolean = boolean} {}
+    Value(double number) : type(Type::NUMBER), as{.number = number} {}
+    Value(Obj *obj) : type(Type::OBJ), as{.obj = obj} {}
+
+    bool is_nil() const { return type == Type::NIL; }
+    bool is_bool() const { return type == Type::BOOL; }
+    bool is_number() const { return type == Type::NUMBER; }
+    bool is_obj() const { return type == Type::OBJ; }
+
+    bool as_bool() const { return as.boolean; }
+    double as_number() const { return as.number; }
+    Obj *as_obj() const { return as.obj; }
+
+    // Mirrors the truthiness of LoxObject: nil, false, 0 and "" are falsey.
+    bool is_falsey() const;
+
+    bool operator==(const Value &other) const;
+
+    Type type;
+    union {
+        bool boolean;
+        double number;
+        Obj *obj;
+    } as;
+};
+
+// Prints a value exactly like the tree-walking interpreter prints the
+// equivalent LoxObject.
+std::ostream &operator<<(std::ostream &os, const Value &value);
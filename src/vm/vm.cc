@@ -0,0 +1,815 @@
+#include "src/vm/vm.h"
+
+#include "src/logging.h"
+#include "src/vm/compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <sstream>
+
+namespace {
+
+constexpr size_t INITIAL_GC_THRESHOLD = 1024 * 1024;
+constexpr size_t GC_HEAP_GROW_FACTOR = 2;
+
+Value clock_native(VirtualMachine &vm, int arg_count, Value *args) {
+    auto now = std::chrono::system_clock::now();
+    double seconds_since_epoch =
+        std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch())
+            .count();
+    return seconds_since_epoch;
+}
+
+Value string_native(VirtualMachine &vm, int arg_count, Value *args) {
+    std::stringstream ss;
+    ss << args[0];
+    return vm.intern(ss.str());
+}
+
+size_t object_size(const Obj *object) {
+    switch (object->type) {
+    case ObjType::BOUND_METHOD:
+        return sizeof(ObjBoundMethod);
+    case ObjType::CLASS:
+        return sizeof(ObjClass);
+    case ObjType::CLOSURE:
+        return sizeof(ObjClosure);
+    case ObjType::FUNCTION:
+        return sizeof(ObjFunction);
+    case ObjType::INSTANCE:
+        return sizeof(ObjInstance);
+    case ObjType::NATIVE:
+        return sizeof(ObjNative);
+    case ObjType::STRING:
+        return sizeof(ObjString) +
+               static_cast<const ObjString *>(object)->chars.size();
+    case ObjType::UPVALUE:
+        return sizeof(ObjUpvalue);
+    }
+    return 0;
+}
+
+} // namespace
+
+VirtualMachine::VirtualMachine()
+    : stack(INITIAL_FRAMES * FRAME_SLOTS), stack_top(stack.data()),
+      frames(INITIAL_FRAMES), frame_count(0), in_tail_call(false),
+      open_upvalues(nullptr), globals(), strings(),
+      init_string(nullptr), objects(nullptr), gray_stack(),
+      bytes_allocated(0), next_gc(INITIAL_GC_THRESHOLD), gc_enabled(false),
+      m_had_compile_error(false), m_had_runtime_error(false) {
+    init_string = intern("init");
+    define_native("clock", clock_native, 0);
+    define_native("string", string_native, 1);
+    gc_enabled = true;
+}
+
+VirtualMachine::~VirtualMachine() {
+    Obj *object = objects;
+    while (object != nullptr) {
+        Obj *next = object->next;
+        delete object;
+        object = next;
+    }
+}
+
+void VirtualMachine::interpret(const std::pmr::vector<Stmt *> &stmts,
+                               InterpreterMode mode) {
+    if (stmts.empty()) {
+        return;
+    }
+
+    gc_enabled = false;
+    BytecodeCompiler compiler(*this);
+    ObjFunction *function = compiler.compile(stmts, mode);
+    gc_enabled = true;
+    if (function == nullptr) {
+        m_had_compile_error = true;
+        return;
+    }
+
+    push(function);
+    ObjClosure *closure = allocate<ObjClosure>(function);
+    pop();
+    push(closure);
+    if (call(closure, 0, 0)) {
+        run();
+    }
+}
+
+bool VirtualMachine::had_compile_error() const { return m_had_compile_error; }
+
+bool VirtualMachine::had_runtime_error() const { return m_had_runtime_error; }
+
+void VirtualMachine::reset_runtime_error() {
+    m_had_compile_error = false;
+    m_had_runtime_error = false;
+}
+
+ObjString *VirtualMachine::intern(std::string_view chars) {
+    auto interned = strings.find(chars);
+    if (interned != strings.end()) {
+        return interned->second;
+    }
+
+    bytes_allocated += chars.size();
+    ObjString *string = allocate<ObjString>(
+        std::string(chars), std::hash<std::string_view>{}(chars));
+    strings.emplace(string->chars, string);
+    return string;
+}
+
+bool VirtualMachine::run() {
+    CallFrame *frame = &frames[frame_count - 1];
+    const uint8_t *ip = frame->ip;
+
+    auto read_byte = [&ip]() { return *ip++; };
+    auto read_short = [&ip]() {
+        ip += 2;
+        return static_cast<uint16_t>((ip[-2] << 8) | ip[-1]);
+    };
+    auto read_constant = [&]() -> const Value & {
+        return frame->closure->function->chunk.constants[read_short()];
+    };
+    auto read_string = [&]() { return as_obj<ObjString>(read_constant()); };
+    // Line of the byte `back` positions before the instruction pointer.
+    auto line_of = [&](size_t back) {
+        const Chunk &chunk = frame->closure->function->chunk;
+        return chunk.lines[ip - chunk.code.data() - back];
+    };
+    auto fail = [&](size_t back, const std::string &message) {
+        frame->ip = ip;
+        runtime_error(line_of(back), message);
+        return false;
+    };
+
+    // Operands are type checked exactly like Interpreter::check_numeric_op.
+#define NUMERIC_OPERANDS()                                                     \
+    if (!peek(0).is_number() or !peek(1).is_number()) {                        \
+        return fail(1, "Operands must be numbers.");                           \
+    }                                                                          \
+    double b = pop().as_number();                                              \
+    double a = pop().as_number();
+
+    while (true) {
+        uint8_t instruction = read_byte();
+        switch (instruction) {
+        case OP_CONSTANT:
+            push(read_constant());
+            break;
+        case OP_CONSTANT_LONG: {
+            size_t constant = read_byte() << 16;
+            constant |= read_short();
+            push(frame->closure->function->chunk.constants[constant]);
+            break;
+        }
+        case OP_NIL:
+            push(Value{});
+            break;
+        case OP_TRUE:
+            push(true);
+            break;
+        case OP_FALSE:
+            push(false);
+            break;
+        case OP_POP:
+            pop();
+            break;
+        case OP_GET_LOCAL:
+            push(frame->slots[read_byte()]);
+            break;
+        case OP_SET_LOCAL:
+            frame->slots[read_byte()] = peek(0);
+            break;
+        case OP_GET_GLOBAL: {
+            ObjString *name = read_string();
+            auto global = globals.find(name);
+            if (global == globals.end()) {
+                return fail(1, "Undefined variable '" + name->chars + "'.");
+            }
+            push(global->second);
+            break;
+        }
+        case OP_DEFINE_GLOBAL:
+            globals[read_string()] = peek(0);
+            pop();
+            break;
+        case OP_SET_GLOBAL: {
+            ObjString *name = read_string();
+            auto global = globals.find(name);
+            if (global == globals.end()) {
+                return fail(1, "Undefined variable '" + name->chars + "'.");
+            }
+            global->second = peek(0);
+            break;
+        }
+        case OP_GET_UPVALUE:
+            push(*frame->closure->upvalues[read_byte()]->location);
+            break;
+        case OP_SET_UPVALUE:
+            *frame->closure->upvalues[read_byte()]->location = peek(0);
+            break;
+        case OP_GET_PROPERTY: {
+            if (!is_instance(peek(0))) {
+                return fail(0, "Only instances have properties.");
+            }
+            ObjInstance *instance = as_obj<ObjInstance>(peek(0));
+            ObjString *name = read_string();
+
+            // Fields shadow methods.
+            auto field = instance->fields.find(name);
+            if (field != instance->fields.end()) {
+                pop();
+                push(field->second);
+                break;
+            }
+
+            frame->ip = ip;
+            if (!bind_method(instance->klass, name, line_of(1))) {
+                return false;
+            }
+            break;
+        }
+        case OP_SET_PROPERTY: {
+            if (!is_instance(peek(1))) {
+                return fail(0, "Only instances have fields.");
+            }
+            ObjInstance *instance = as_obj<ObjInstance>(peek(1));
+            instance->fields[read_string()] = peek(0);
+            Value value = pop();
+            pop();
+            push(value);
+            break;
+        }
+        case OP_GET_SUPER: {
+            ObjString *name = read_string();
+            ObjClass *superclass = as_obj<ObjClass>(pop());
+            frame->ip = ip;
+            if (!bind_method(superclass, name, line_of(1))) {
+                return false;
+            }
+            break;
+        }
+        case OP_EQUAL: {
+            Value b = pop();
+            Value a = pop();
+            push(a == b);
+            break;
+        }
+        case OP_NOT_EQUAL: {
+            Value b = pop();
+            Value a = pop();
+            push(!(a == b));
+            break;
+        }
+        case OP_GREATER: {
+            NUMERIC_OPERANDS();
+            push(a > b);
+            break;
+        }
+        case OP_GREATER_EQUAL: {
+            NUMERIC_OPERANDS();
+            push(a >= b);
+            break;
+        }
+        case OP_LESS: {
+            NUMERIC_OPERANDS();
+            push(a < b);
+            break;
+        }
+        case OP_LESS_EQUAL: {
+            NUMERIC_OPERANDS();
+            push(a <= b);
+            break;
+        }
+        case OP_ADD: {
+            if (peek(0).is_number() and peek(1).is_number()) {
+                double b = pop().as_number();
+                double a = pop().as_number();
+                push(a + b);
+            } else if (is_string(peek(0)) and is_string(peek(1))) {
+                // Keep both operands on the stack while allocating.
+                const std::string &b = as_obj<ObjString>(peek(0))->chars;
+                const std::string &a = as_obj<ObjString>(peek(1))->chars;
+                ObjString *result = intern(a + b);
+                pop();
+                pop();
+                push(result);
+            } else {
+                return fail(1, "Operands must be two numbers or two strings.");
+            }
+            break;
+        }
+        case OP_SUBTRACT: {
+            NUMERIC_OPERANDS();
+            push(a - b);
+            break;
+        }
+        case OP_MULTIPLY: {
+            NUMERIC_OPERANDS();
+            push(a * b);
+            break;
+        }
+        case OP_DIVIDE: {
+            NUMERIC_OPERANDS();
+            if (b == 0) {
+                return fail(1, "Division by zero.");
+            }
+            push(a / b);
+            break;
+        }
+        case OP_NOT:
+            push(pop().is_falsey());
+            break;
+        case OP_NEGATE:
+            if (!peek(0).is_number()) {
+                return fail(1, "Operand must be a number.");
+            }
+            push(-pop().as_number());
+            break;
+        case OP_PRINT:
+            std::cout << std::boolalpha << pop() << std::endl;
+            break;
+        case OP_JUMP: {
+            uint16_t offset = read_short();
+            ip += offset;
+            break;
+        }
+        case OP_JUMP_IF_FALSE: {
+            uint16_t offset = read_short();
+            if (peek(0).is_falsey()) {
+                ip += offset;
+            }
+            break;
+        }
+        case OP_LOOP: {
+            uint16_t offset = read_short();
+            ip -= offset;
+            break;
+        }
+        case OP_TEST_COUNTER: {
+            Value counter = frame->slots[read_byte()];
+            Value limit = frame->slots[read_byte()];
+            uint8_t comparison = read_byte();
+            uint16_t offset = read_short();
+            if (!counter.is_number() or !limit.is_number()) {
+                return fail(1, "Operands must be numbers.");
+            }
+            double a = counter.as_number();
+            double b = limit.as_number();
+            bool counting;
+            switch (comparison) {
+            case OP_LESS:
+                counting = a < b;
+                break;
+            case OP_LESS_EQUAL:
+                counting = a <= b;
+                break;
+            case OP_GREATER:
+                counting = a > b;
+                break;
+            default:
+                counting = a >= b;
+                break;
+            }
+            if (!counting) {
+                ip += offset;
+            }
+            break;
+        }
+        case OP_ADD_TO_LOCAL: {
+            // A number: OP_TEST_COUNTER checked, and nothing else in the loop
+            // assigns to it.
+            Value &counter = frame->slots[read_byte()];
+            counter = counter.as_number() + read_constant().as_number();
+            break;
+        }
+        case OP_TAIL:
+            in_tail_call = true;
+            break;
+        case OP_CALL: {
+            int arg_count = read_byte();
+            frame->ip = ip;
+            if (!call_value(peek(arg_count), arg_count, line_of(1))) {
+                return false;
+            }
+            in_tail_call = false;
+            frame = &frames[frame_count - 1];
+            ip = frame->ip;
+            break;
+        }
+        case OP_INVOKE: {
+            int name_line = line_of(0);
+            ObjString *method = read_string();
+            int arg_count = read_byte();
+            frame->ip = ip;
+            if (!invoke(method, arg_count, name_line, line_of(1))) {
+                return false;
+            }
+            in_tail_call = false;
+            frame = &frames[frame_count - 1];
+            ip = frame->ip;
+            break;
+        }
+        case OP_SUPER_INVOKE: {
+            int name_line = line_of(0);
+            ObjString *method = read_string();
+            int arg_count = read_byte();
+            ObjClass *superclass = as_obj<ObjClass>(pop());
+            frame->ip = ip;
+            if (!invoke_from_class(superclass, method, arg_count, name_line,
+                                   line_of(1))) {
+                return false;
+            }
+            in_tail_call = false;
+            frame = &frames[frame_count - 1];
+            ip = frame->ip;
+            break;
+        }
+        case OP_CLOSURE: {
+            ObjFunction *function = as_obj<ObjFunction>(read_constant());
+            ObjClosure *closure = allocate<ObjClosure>(function);
+            push(closure);
+            for (ObjUpvalue *&upvalue : closure->upvalues) {
+                uint8_t is_local = read_byte();
+                uint8_t index = read_byte();
+                if (is_local) {
+                    upvalue = capture_upvalue(frame->slots + index);
+                } else {
+                    upvalue = frame->closure->upvalues[index];
+                }
+            }
+            break;
+        }
+        case OP_CLOSE_UPVALUE:
+            close_upvalues(stack_top - 1);
+            pop();
+            break;
+        case OP_RETURN: {
+            Value result = pop();
+            close_upvalues(frame->slots);
+            --frame_count;
+            if (frame_count == 0) {
+                pop();
+                return true;
+            }
+
+            stack_top = frame->slots;
+            push(result);
+            frame = &frames[frame_count - 1];
+            ip = frame->ip;
+            break;
+        }
+        case OP_CLASS:
+            push(allocate<ObjClass>(read_string()));
+            break;
+        case OP_INHERIT: {
+            if (!is_class(peek(1))) {
+                return fail(1, "Superclass must be a class.");
+            }
+            ObjClass *superclass = as_obj<ObjClass>(peek(1));
+            ObjClass *subclass = as_obj<ObjClass>(peek(0));
+            // Copy-down inheritance: methods are fixed once the class
+            // statement has run, so the subclass can own the flattened table.
+            subclass->methods.insert(superclass->methods.begin(),
+                                     superclass->methods.end());
+            pop();
+            break;
+        }
+        case OP_METHOD: {
+            ObjString *name = read_string();
+            ObjClass *klass = as_obj<ObjClass>(peek(1));
+            klass->methods[name] = peek(0);
+            pop();
+            break;
+        }
+        }
+    }
+
+#undef NUMERIC_OPERANDS
+}
+
+void VirtualMachine::push(Value value) { *stack_top++ = value; }
+
+Value VirtualMachine::pop() { return *--stack_top; }
+
+Value VirtualMachine::peek(int distance) const {
+    return stack_top[-1 - distance];
+}
+
+bool VirtualMachine::call(ObjClosure *closure, int arg_count, int line) {
+    if (arg_count != closure->function->arity) {
+        runtime_error(line, "Expected " +
+                                std::to_string(closure->function->arity) +
+                                " arguments but got " +
+                                std::to_string(arg_count) + ".");
+        return false;
+    }
+
+    // A call in tail position moves the callee and its arguments down over
+    // the frame of the function calling and runs in that frame instead.
+    if (in_tail_call) {
+        in_tail_call = false;
+        CallFrame *frame = &frames[frame_count - 1];
+        close_upvalues(frame->slots);
+        Value *callee = stack_top - arg_count - 1;
+        std::copy(callee, stack_top, frame->slots);
+        stack_top = frame->slots + arg_count + 1;
+        frame->closure = closure;
+        frame->ip = closure->function->chunk.code.data();
+        return true;
+    }
+
+    if (frame_count == frames.size() or
+        stack_top + FRAME_SLOTS > stack.data() + stack.size()) {
+        grow_stacks();
+    }
+
+    CallFrame *frame = &frames[frame_count++];
+    frame->closure = closure;
+    frame->ip = closure->function->chunk.code.data();
+    frame->slots = stack_top - arg_count - 1;
+    return true;
+}
+
+bool VirtualMachine::call_value(Value callee, int arg_count, int line) {
+    if (callee.is_obj()) {
+        switch (callee.as_obj()->type) {
+        case ObjType::BOUND_METHOD: {
+            auto *bound = as_obj<ObjBoundMethod>(callee);
+            stack_top[-arg_count - 1] = bound->receiver;
+            return call(bound->method, arg_count, line);
+        }
+        case ObjType::CLASS: {
+            auto *klass = as_obj<ObjClass>(callee);
+            stack_top[-arg_count - 1] = allocate<ObjInstance>(klass);
+            auto initializer = klass->methods.find(init_string);
+            if (initializer != klass->methods.end()) {
+                return call(as_obj<ObjClosure>(initializer->second), arg_count,
+                            line);
+            }
+            if (arg_count != 0) {
+                runtime_error(line, "Expected 0 arguments but got " +
+                                        std::to_string(arg_count) + ".");
+                return false;
+            }
+            return true;
+        }
+        case ObjType::CLOSURE:
+            return call(as_obj<ObjClosure>(callee), arg_count, line);
+        case ObjType::NATIVE: {
+            auto *native = as_obj<ObjNative>(callee);
+            if (arg_count != native->arity) {
+                runtime_error(line, "Expected " +
+                                        std::to_string(native->arity) +
+                                        " arguments but got " +
+                                        std::to_string(arg_count) + ".");
+                return false;
+            }
+            Value result =
+                native->function(*this, arg_count, stack_top - arg_count);
+            stack_top -= arg_count + 1;
+            push(result);
+            return true;
+        }
+        default:
+            break;
+        }
+    }
+    runtime_error(line, "Can only call functions and classes.");
+    return false;
+}
+
+bool VirtualMachine::invoke(ObjString *name, int arg_count, int name_line,
+                            int call_line) {
+    Value receiver = peek(arg_count);
+    if (!is_instance(receiver)) {
+        runtime_error(name_line, "Only instances have properties.");
+        return false;
+    }
+
+    ObjInstance *instance = as_obj<ObjInstance>(receiver);
+    auto field = instance->fields.find(name);
+    if (field != instance->fields.end()) {
+        stack_top[-arg_count - 1] = field->second;
+        return call_value(field->second, arg_count, call_line);
+    }
+
+    return invoke_from_class(instance->klass, name, arg_count, name_line,
+                             call_line);
+}
+
+bool VirtualMachine::invoke_from_class(ObjClass *klass, ObjString *name,
+                                       int arg_count, int name_line,
+                                       int call_line) {
+    auto method = klass->methods.find(name);
+    if (method == klass->methods.end()) {
+        runtime_error(name_line, "Undefined property '" + name->chars + "'.");
+        return false;
+    }
+    return call(as_obj<ObjClosure>(method->second), arg_count, call_line);
+}
+
+bool VirtualMachine::bind_method(ObjClass *klass, ObjString *name, int line) {
+    auto method = klass->methods.find(name);
+    if (method == klass->methods.end()) {
+        runtime_error(line, "Undefined property '" + name->chars + "'.");
+        return false;
+    }
+
+    auto *bound = allocate<ObjBoundMethod>(
+        peek(0), as_obj<ObjClosure>(method->second));
+    pop();
+    push(bound);
+    return true;
+}
+
+ObjUpvalue *VirtualMachine::capture_upvalue(Value *local) {
+    ObjUpvalue *prev_upvalue = nullptr;
+    ObjUpvalue *upvalue = open_upvalues;
+    while (upvalue != nullptr and upvalue->location > local) {
+        prev_upvalue = upvalue;
+        upvalue = upvalue->next_upvalue;
+    }
+
+    if (upvalue != nullptr and upvalue->location == local) {
+        return upvalue;
+    }
+
+    ObjUpvalue *created_upvalue = allocate<ObjUpvalue>(local);
+    created_upvalue->next_upvalue = upvalue;
+    if (prev_upvalue == nullptr) {
+        open_upvalues = created_upvalue;
+    } else {
+        prev_upvalue->next_upvalue = created_upvalue;
+    }
+    return created_upvalue;
+}
+
+void VirtualMachine::close_upvalues(const Value *last) {
+    while (open_upvalues != nullptr and open_upvalues->location >= last) {
+        ObjUpvalue *upvalue = open_upvalues;
+        upvalue->closed = *upvalue->location;
+        upvalue->location = &upvalue->closed;
+        open_upvalues = upvalue->next_upvalue;
+    }
+}
+
+void VirtualMachine::define_native(std::string_view name, NativeFn function,
+                                   int arity) {
+    globals[intern(name)] = allocate<ObjNative>(function, arity);
+}
+
+void VirtualMachine::runtime_error(int line, const std::string &message) {
+    error(line, message);
+    m_had_runtime_error = true;
+    reset_stack();
+}
+
+void VirtualMachine::reset_stack() {
+    stack_top = stack.data();
+    frame_count = 0;
+    in_tail_call = false;
+    open_upvalues = nullptr;
+}
+
+void VirtualMachine::grow_stacks() {
+    if (frame_count == frames.size()) {
+        frames.resize(2 * frames.size());
+    }
+    if (stack_top + FRAME_SLOTS <= stack.data() + stack.size()) {
+        return;
+    }
+    Value *old_stack = stack.data();
+    stack.resize(2 * stack.size());
+    auto moved = [&](Value *slot) { return stack.data() + (slot - old_stack); };
+    stack_top = moved(stack_top);
+    for (size_t i = 0; i < frame_count; ++i) {
+        frames[i].slots = moved(frames[i].slots);
+    }
+    for (ObjUpvalue *upvalue = open_upvalues; upvalue != nullptr;
+         upvalue = upvalue->next_upvalue) {
+        upvalue->location = moved(upvalue->location);
+    }
+}
+
+void VirtualMachine::collect_garbage() {
+    mark_roots();
+    while (!gray_stack.empty()) {
+        Obj *object = gray_stack.back();
+        gray_stack.pop_back();
+        blacken_object(object);
+    }
+    sweep();
+    next_gc = std::max(bytes_allocated * GC_HEAP_GROW_FACTOR,
+                       INITIAL_GC_THRESHOLD);
+}
+
+void VirtualMachine::mark_roots() {
+    for (Value *slot = stack.data(); slot < stack_top; ++slot) {
+        mark_value(*slot);
+    }
+    for (size_t i = 0; i < frame_count; ++i) {
+        mark_object(frames[i].closure);
+    }
+    for (ObjUpvalue *upvalue = open_upvalues; upvalue != nullptr;
+         upvalue = upvalue->next_upvalue) {
+        mark_object(upvalue);
+    }
+    mark_table(globals);
+    mark_object(init_string);
+}
+
+void VirtualMachine::mark_value(const Value &value) {
+    if (value.is_obj()) {
+        mark_object(value.as_obj());
+    }
+}
+
+void VirtualMachine::mark_object(Obj *object) {
+    if (object == nullptr or object->is_marked) {
+        return;
+    }
+    object->is_marked = true;
+    gray_stack.push_back(object);
+}
+
+void VirtualMachine::mark_table(const Table &table) {
+    for (const auto &[key, value] : table) {
+        mark_object(key);
+        mark_value(value);
+    }
+}
+
+void VirtualMachine::blacken_object(Obj *object) {
+    switch (object->type) {
+    case ObjType::BOUND_METHOD: {
+        auto *bound = static_cast<ObjBoundMethod *>(object);
+        mark_value(bound->receiver);
+        mark_object(bound->method);
+        break;
+    }
+    case ObjType::CLASS: {
+        auto *klass = static_cast<ObjClass *>(object);
+        mark_object(klass->name);
+        mark_table(klass->methods);
+        break;
+    }
+    case ObjType::CLOSURE: {
+        auto *closure = static_cast<ObjClosure *>(object);
+        mark_object(closure->function);
+        for (ObjUpvalue *upvalue : closure->upvalues) {
+            mark_object(upvalue);
+        }
+        break;
+    }
+    case ObjType::FUNCTION: {
+        auto *function = static_cast<ObjFunction *>(object);
+        mark_object(function->name);
+        for (const Value &constant : function->chunk.constants) {
+            mark_value(constant);
+        }
+        break;
+    }
+    case ObjType::INSTANCE: {
+        auto *instance = static_cast<ObjInstance *>(object);
+        mark_object(instance->klass);
+        mark_table(instance->fields);
+        break;
+    }
+    case ObjType::UPVALUE:
+        mark_value(static_cast<ObjUpvalue *>(object)->closed);
+        break;
+    case ObjType::NATIVE:
+    case ObjType::STRING:
+        break;
+    }
+}
+
+void VirtualMachine::sweep() {
+    // The intern table holds its strings weakly.
+    std::erase_if(strings,
+                  [](const auto &entry) { return !entry.second->is_marked; });
+
+    Obj *previous = nullptr;
+    Obj *object = objects;
+    while (object != nullptr) {
+        if (object->is_marked) {
+            object->is_marked = false;
+            previous = object;
+            object = object->next;
+            continue;
+        }
+
+        Obj *unreached = object;
+        object = object->next;
+        if (previous != nullptr) {
+            previous->next = object;
+        } else {
+            objects = object;
+        }
+        bytes_allocated -= object_size(unreached);
+        delete unreached;
+    }
+}
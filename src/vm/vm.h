@@ -0,0 +1,117 @@
+#pragma once
+
+#include "src/semantics/interpreter_mode.h"
+#include "src/syntactics/stmt.h"
+#include "src/vm/object.h"
+#include "src/vm/value.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Stack based virtual machine executing the bytecode produced by
+// BytecodeCompiler. It is an alternative to the tree-walking Interpreter and
+// must produce exactly the same output for the same resolved program.
+struct VirtualMachine {
+    VirtualMachine();
+    ~VirtualMachine();
+
+    VirtualMachine(const VirtualMachine &) = delete;
+    VirtualMachine &operator=(const VirtualMachine &) = delete;
+
+    void interpret(const std::pmr::vector<Stmt *> &stmts,
+                   InterpreterMode mode = InterpreterMode::FILE);
+
+    bool had_compile_error() const;
+    bool had_runtime_error() const;
+    void reset_runtime_error();
+
+    // Every heap object is created through the VM so that it can be traced
+    // and reclaimed by the collector.
+    template <typename T, typename... Args>
+    T *allocate(Args &&...args) {
+        bytes_allocated += sizeof(T);
+        if (gc_enabled and bytes_allocated > next_gc) {
+            collect_garbage();
+        }
+        T *object = new T(std::forward<Args>(args)...);
+        object->next = objects;
+        objects = object;
+        return object;
+    }
+
+    ObjString *intern(std::string_view chars);
+
+  private:
+    // The stack slots a call needs at most: its locals and arguments, which
+    // are addressed by a byte, and the temporaries of expressions nested as
+    // deeply as the parser allows.
+    static constexpr size_t FRAME_SLOTS = 1024;
+    // Both stacks start with room for this many calls and grow on demand, so
+    // that calls nest as deeply as on the tree-walking engines.
+    static constexpr size_t INITIAL_FRAMES = 64;
+
+    struct CallFrame {
+        ObjClosure *closure;
+        const uint8_t *ip;
+        Value *slots;
+    };
+
+    bool run();
+
+    void push(Value value);
+    Value pop();
+    Value peek(int distance) const;
+
+    bool call(ObjClosure *closure, int arg_count, int line);
+    bool call_value(Value callee, int arg_count, int line);
+    bool invoke(ObjString *name, int arg_count, int name_line,
+                int call_line);
+    bool invoke_from_class(ObjClass *klass, ObjString *name, int arg_count,
+                           int name_line, int call_line);
+    bool bind_method(ObjClass *klass, ObjString *name, int line);
+
+    ObjUpvalue *capture_upvalue(Value *local);
+    void close_upvalues(const Value *last);
+
+    void define_native(std::string_view name, NativeFn function, int arity);
+
+    void runtime_error(int line, const std::string &message);
+    void reset_stack();
+    // Makes room for another call on both stacks, moving what points into
+    // the value stack along with it.
+    void grow_stacks();
+
+    void collect_garbage();
+    void mark_roots();
+    void mark_value(const Value &value);
+    void mark_object(Obj *object);
+    void mark_table(const Table &table);
+    void blacken_object(Obj *object);
+    void sweep();
+
+    std::vector<Value> stack;
+    Value *stack_top;
+    // Only the first `frame_count` are in use.
+    std::vector<CallFrame> frames;
+    size_t frame_count;
+    // Set by OP_TAIL for the call instruction that follows it.
+    bool in_tail_call;
+    ObjUpvalue *open_upvalues;
+
+    Table globals;
+    std::unordered_map<std::string_view, ObjString *> strings;
+    ObjString *init_string;
+
+    Obj *objects;
+    std::vector<Obj *> gray_stack;
+    size_t bytes_allocated;
+    size_t next_gc;
+    // The compiler keeps freshly created functions in C++ locals only, so
+    // collection is suspended while a program is being compiled.
+    bool gc_enabled;
+
+    bool m_had_compile_error;
+    bool m_had_runtime_error;
+};
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include "src/semantics/testing.h"
+#include "src/vm/vm.h"
+
+#include <string>
+
+namespace {
+
+// Expects `source` to print the same on the VM as on the Interpreter.
+void expect_same_output(const std::string &source, bool optimize = false) {
+    ::expect_same_output<VirtualMachine>(source, optimize);
+}
+
+} // namespace
+
+TEST(VirtualMachineTest, Arithmetic) {
+    EXPECT_EQ(run<VirtualMachine>("print 1 + 2;").output, "3\n");
+    expect_same_output("print 1 + 2 * 3 - 4 / 8;");
+    expect_same_output("print 1 / 3; print -0; print 100000000;");
+    expect_same_output("print 1 < 2; print 2 <= 1; print 3 > 2; print 1 >= 1;");
+    expect_same_output("print \"a\" + \"b\"; print \"a\" == \"a\";");
+    expect_same_output("print nil == nil; print nil == false; print 1 != 2;");
+}
+
+TEST(VirtualMachineTest, Truthiness) {
+    expect_same_output("print !nil; print !0; print !\"\"; print !\"a\";");
+    expect_same_output("print 0 or \"x\"; print 1 and 2; print nil and 1;");
+}
+
+TEST(VirtualMachineTest, Scopes) {
+    expect_same_output(
+        "var a = 1; { var a = 2; { var a = 3; print a; } print a; } print a;");
+    expect_same_output(
+        "for (var i = 0; i < 3; i = i + 1) { var j = i * 2; print j; }");
+}
+
+TEST(VirtualMachineTest, Closures) {
+    expect_same_output(R"(
+        fun counter() {
+            var n = 0;
+            return fun() { n = n + 1; return n; };
+        }
+        var a = counter();
+        var b = counter();
+        a(); a();
+        print a(); print b(); print a;
+    )");
+    expect_same_output(R"(
+        { var x = "before"; fun show() { print x; } x = "after"; show(); }
+    )");
+}
+
+TEST(VirtualMachineTest, Returns) {
+    expect_same_output(R"(
+        fun find(n) {
+            for (var i = 0; i < 10; i = i + 1) {
+                { if (i == n) { return i * 10; } }
+            }
+            return -1;
+        }
+        print find(3); print find(20);
+        fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }
+        print fib(15);
+        fun nothing() { return; }
+        print nothing();
+        fun after() { while (true) { return "done"; } print "unreachable"; }
+        print after();
+    )");
+}
+
+TEST(VirtualMachineTest, TailCalls) {
+    expect_same_output(R"(
+        fun id(x) { return x; }
+        fun make(n) { var get = fun () { return n; }; return id(get); }
+        print make(5)();
+        class A {
+            init(x) { this.x = x; }
+            get() { return this.x; }
+            copy() { return A(this.get()); }
+        }
+        class B < A { get() { return super.get(); } }
+        print B(2).copy().get();
+        fun native() { return clock(); }
+        print native() > 0;
+        fun fail(n) { if (n == 0) return nil + 1; return fail(n - 1); }
+        fail(3);
+    )");
+    // Far deeper than the VM would grow its stacks to if every call kept a
+    // frame.
+    RunResult deep = run<VirtualMachine>(R"(
+        fun even(n) { if (n == 0) return true; return odd(n - 1); }
+        fun odd(n) { if (n == 0) return false; return even(n - 1); }
+        print even(100001);
+    )");
+    EXPECT_EQ(deep.output, "false\n");
+}
+
+TEST(VirtualMachineTest, RecursesAsDeeplyAsTheInterpreter) {
+    expect_same_output(R"(
+        fun sum(n) { if (n == 0) return 0; return n + sum(n - 1); }
+        print sum(5000);
+        fun deep(n, f) {
+            if (n == 0) return f();
+            var result = deep(n - 1, f);
+            return result;
+        }
+        fun outer() {
+            // Captured while the stack grows under it.
+            var x = "before";
+            fun set() { x = "after"; return x; }
+            print deep(5000, set);
+            print x;
+        }
+        outer();
+    )");
+}
+
+TEST(VirtualMachineTest, LongScripts) {
+    // Uses `total` and "step" far more often, and more distinct numbers, than
+    // 16 bit constant operands can index.
+    std::string source = "var total = 0;\n";
+    for (int i = 0; i < 70000; ++i) {
+        source += "total = total + " + std::to_string(i) + ".5;\n";
+        source += "var step = \"step\";\n";
+    }
+    source += "print total; print step;\n";
+    expect_same_output(source);
+}
+
+TEST(VirtualMachineTest, CountedLoops) {
+    const std::string source = R"(
+        fun sum_to(n) {
+            var total = 0;
+            for (var i = 0; i < n; i = i + 1) total = total + i;
+            return total;
+        }
+        print sum_to(100);
+        for (var i = 10; i >= 0; i = i - 2.5) print i;
+        var limit = 3;
+        var last;
+        for (var i = 0; i < limit; i = i + 1) {
+            fun get() { return i; }
+            last = get;
+        }
+        print last();
+        fun first_over(n) {
+            for (var i = 0.5; i <= n * 2; i = 1 + i) if (i > n) return i;
+        }
+        print first_over(4);
+    )";
+    expect_same_output(source, true);
+    expect_same_output("for (var i = \"a\"; i < 3; i = i + 1) print i;",
+                       true);
+    expect_same_output("var n; for (var i = 0; i < n; i = i + 1) print i;",
+                       true);
+}
+
+TEST(VirtualMachineTest, Classes) {
+    expect_same_output(R"(
+        class A {
+            init(x) { this.x = x; }
+            get() { return this.x; }
+        }
+        class B < A {
+            init(x) { super.init(x); return; }
+            get() { return super.get() * 2; }
+        }
+        var b = B(21);
+        print b.get(); print b.init(3).x; print b; print B; print b.get;
+        var bound = b.get; print bound();
+        b.f = fun() { return "field"; }; print b.f();
+    )");
+}
+
+TEST(VirtualMachineTest, Natives) {
+    expect_same_output("print clock; print string(true) + string(1.5) + "
+                       "string(nil);");
+}
+
+TEST(VirtualMachineTest, RuntimeErrors) {
+    expect_same_output("print 1 + \"a\";");
+    expect_same_output("print -\"x\";");
+    expect_same_output("print 1 / 0;");
+    expect_same_output("var a; a();");
+    expect_same_output("fun f(a) {} f();");
+    expect_same_output("print x;");
+    expect_same_output("x = 1;");
+    expect_same_output("var o = 1; print o.x;");
+    expect_same_output("var o = 1; o.x = 2;");
+    expect_same_output("class A {} A().m();");
+    expect_same_output("class A {} A(1);");
+    expect_same_output("var N = 1; class A < N {}");
+    expect_same_output("var o = nil;\no\n.m(\n);");
+}
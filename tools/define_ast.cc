@@ -21,6 +21,13 @@ std::string to_lower(std::string s) {
     return s;
 }
 
+std::string to_upper(std::string s) {
+    for (char &c : s) {
+        c = std::toupper(c);
+    }
+    return s;
+}
+
 // trim from start (in place)
 inline void ltrim(std::string &s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) {
@@ -47,6 +54,12 @@ using FieldName = std::string;
 using Field = std::pair<FieldType, FieldName>;
 using SubclassData = std::pair<SubclassName, std::vector<Field>>;
 
+// Fields declared "mutable Type name" are caches the interpreter fills in:
+// they are not constructor parameters and can change on a const node.
+bool is_mutable(const Field &field) {
+    return field.first.starts_with("mutable ");
+}
+
 SubclassData parse_string(const std::string &subclass_str) {
     std::stringstream subclass_stream(subclass_str);
     SubclassName subclass_name;
@@ -56,7 +69,7 @@ SubclassData parse_string(const std::string &subclass_str) {
     std::vector<Field> fields;
     while (std::getline(subclass_stream, field_str, ',')) {
         trim(field_str);
-        size_t delim_idx = field_str.find(' ');
+        size_t delim_idx = field_str.rfind(' ');
         FieldType field_type = field_str.substr(0, delim_idx);
         FieldName field_name = field_str.substr(delim_idx + 1);
         fields.emplace_back(field_type, field_name);
@@ -77,19 +90,30 @@ struct AstData {
             std::vector<std::string> subclass_strs)
         : base_name(base_name),
           subclasses(parse_subclasses(std::move(subclass_strs))),
-          visitor_name(fmt::format("{}Visitor", base_name)) {}
+          visitor_name(fmt::format("{}Visitor", base_name)),
+          kind_name(fmt::format("{}Kind", base_name)) {}
 
     std::string base_name;
     std::vector<SubclassData> subclasses;
     std::string visitor_name;
+    std::string kind_name;
 };
 
+void define_kind(std::ostream &os, const AstData &ast_data) {
+    os << fmt::format("enum class {} : uint8_t {{", ast_data.kind_name)
+       << std::endl;
+    for (const auto &[subclass_name, _] : ast_data.subclasses) {
+        os << fmt::format("    {},", to_upper(subclass_name)) << std::endl;
+    }
+    os << "};" << std::endl << std::endl;
+}
+
 void define_base_class(std::ostream &os, const AstData &ast_data) {
     os << fmt::format(
         R"###(struct {0} {{ 
     virtual void accept({1} &visitor) const = 0;
     
-    {0}() = default;
+    explicit {0}({2} kind) : kind(kind) {{}}
     {0}(const {0} &) = default;
     {0} &operator=(const {0} &) = default;
     {0}({0} &&) = default;
@@ -97,8 +121,11 @@ void define_base_class(std::ostream &os, const AstData &ast_data) {
     
     virtual ~{0}() = default;
 
+    // The concrete type of the node, for dispatch().
+    {2} kind;
+
 )###",
-        ast_data.base_name, ast_data.visitor_name);
+        ast_data.base_name, ast_data.visitor_name, ast_data.kind_name);
     for (const auto &[subclass_name, _] : ast_data.subclasses) {
         os << fmt::format("    struct {};", subclass_name) << std::endl;
     }
@@ -108,15 +135,17 @@ void define_base_class(std::ostream &os, const AstData &ast_data) {
 void define_subclass(std::ostream &os_h, std::ostream &os_cc,
                      const std::string &base_class,
                      const std::string &visitor_name,
+                     const std::string &kind_name,
                      const SubclassData subclass_data) {
     auto [subclass_name, fields] = subclass_data;
 
     const std::string &scoped_name =
         fmt::format("{}::{}", base_class, subclass_name);
 
+    // Children are owned by the AstArena, so they are plain pointers.
     for (auto &[field_type, field_name] : fields) {
-        if (field_type == base_class) {
-            field_type = fmt::format("std::shared_ptr<{}>", field_type);
+        if (field_type == "Expr" or field_type == "Stmt") {
+            field_type += " *";
         }
     }
     os_h << fmt::format("struct {} : {} {{", scoped_name, base_class)
@@ -127,6 +156,9 @@ void define_subclass(std::ostream &os_h, std::ostream &os_cc,
 
     bool first_iter = true;
     for (const auto &field : fields) {
+        if (is_mutable(field)) {
+            continue;
+        }
         if (!first_iter) {
             os_h << ", ";
         }
@@ -138,22 +170,25 @@ void define_subclass(std::ostream &os_h, std::ostream &os_cc,
     // Define constructor
     os_cc << fmt::format("{}::{}(", scoped_name, subclass_name);
     first_iter = true;
-    for (const auto &[field_type, field_name] : fields) {
+    for (const auto &field : fields) {
+        if (is_mutable(field)) {
+            continue;
+        }
+        const auto &[field_type, field_name] = field;
         if (!first_iter) {
             os_cc << ", ";
         }
         os_cc << field_type << " " << field_name;
         first_iter = false;
     }
-    os_cc << ") : ";
+    os_cc << fmt::format(") : {}({}::{})", base_class, kind_name,
+                         to_upper(subclass_name));
 
-    first_iter = true;
-    for (const auto &[field_type, field_name] : fields) {
-        if (!first_iter) {
-            os_cc << ", ";
+    for (const auto &field : fields) {
+        if (is_mutable(field)) {
+            continue;
         }
-        os_cc << fmt::format("{0}(std::move({0}))", field_name);
-        first_iter = false;
+        os_cc << fmt::format(", {0}(std::move({0}))", field.second);
     }
     os_cc << "{}" << std::endl << std::endl;
 
@@ -171,9 +206,12 @@ void define_subclass(std::ostream &os_h, std::ostream &os_cc,
           << std::endl
           << std::endl;
 
-    // Define subclass fields
-    for (const auto &[field_type, field_name] : fields) {
-        os_h << "    " << field_type << " " << field_name << ";" << std::endl;
+    // Define subclass fields. Mutable fields are value-initialized, since no
+    // constructor sets them.
+    for (const auto &field : fields) {
+        const auto &[field_type, field_name] = field;
+        os_h << "    " << field_type << " " << field_name
+             << (is_mutable(field) ? "{};" : ";") << std::endl;
     }
     os_h << "};" << std::endl << std::endl;
 }
@@ -182,7 +220,7 @@ void define_subclasses(std::ostream &os_h, std::ostream &os_cc,
                        const AstData &ast_data) {
     for (const SubclassData &subclass_data : ast_data.subclasses) {
         define_subclass(os_h, os_cc, ast_data.base_name, ast_data.visitor_name,
-                        subclass_data);
+                        ast_data.kind_name, subclass_data);
     }
 }
 
@@ -199,6 +237,30 @@ void define_visitor(std::ostream &os_h, std::ostream &os_cc,
     os_h << "};" << std::endl << std::endl;
 }
 
+// dispatch() switches on the node's kind and calls the visitor's method
+// directly. For a final visitor the call is resolved at compile time and can
+// be inlined, where accept() costs two virtual calls. Visitors with private
+// visit methods befriend it.
+void define_dispatch(std::ostream &os_h, const AstData &ast_data) {
+    const std::string param_name = to_lower(ast_data.base_name);
+    os_h << fmt::format(R"###(// Calls the visit method for the concrete type of `{1}`.
+template <typename Visitor>
+void dispatch(const {0} &{1}, Visitor &visitor) {{
+    switch ({1}.kind) {{
+)###",
+                        ast_data.base_name, param_name);
+    for (const auto &[subclass_name, _] : ast_data.subclasses) {
+        os_h << fmt::format(R"###(    case {0}::{1}:
+        visitor.visit_{2}_{3}(static_cast<const {4}::{5} &>({3}));
+        return;
+)###",
+                            ast_data.kind_name, to_upper(subclass_name),
+                            to_lower(subclass_name), param_name,
+                            ast_data.base_name, subclass_name);
+    }
+    os_h << "    }" << std::endl << "}" << std::endl;
+}
+
 void define_ast(const fs::path &file_h, const fs::path &file_cc,
                 const std::string &base_name,
                 const std::vector<std::string> &subclass_strs,
@@ -226,7 +288,7 @@ void define_ast(const fs::path &file_h, const fs::path &file_cc,
     for (const auto &include : includes) {
         ofile_h << fmt::format("#include {}", include) << std::endl;
     }
-    ofile_h << "#include <memory>" << std::endl << std::endl;
+    ofile_h << "#include <cstdint>" << std::endl << std::endl;
 
     // Headers of .cc
     ofile_cc << fmt::format("#include \"src/syntactics/{}.h\"",
@@ -238,11 +300,15 @@ void define_ast(const fs::path &file_h, const fs::path &file_cc,
     ofile_h << fmt::format("struct {};", ast_data.visitor_name) << std::endl
             << std::endl;
 
+    define_kind(ofile_h, ast_data);
+
     define_base_class(ofile_h, ast_data);
 
     define_subclasses(ofile_h, ofile_cc, ast_data);
 
     define_visitor(ofile_h, ofile_cc, ast_data);
+
+    define_dispatch(ofile_h, ast_data);
 }
 
 void define_and_format_ast(fs::path output_dir, const std::string &base_name,
@@ -274,46 +340,57 @@ int main(int argc, char **argv) {
     define_and_format_ast(
         output_dir, "Expr",
         {
-            "Assign   : Token name, Expr value",
-            "Binary   : Expr left, Token op, Expr right",
+            "Assign   : Token name, Expr value, mutable GlobalCache global",
+            "Binary   : Expr left, Token op, Expr right, "
+            "mutable BinarySpecialization specialization",
             "Call     : Expr callee, Token paren, "
-            "std::vector<std::shared_ptr<Expr>> arguments",
-            "Get        : Expr object, Token name",
+            "std::pmr::vector<Expr*> arguments",
+            "Get        : Expr object, Token name, "
+            "mutable PropertyCache cache",
             "Grouping : Expr expression",
-            "Lambda   : Token keyword, std::vector<Token> params, "
-            "std::vector<std::shared_ptr<Stmt>> body",
-            "Literal  : Token value",
+            "Lambda   : Token keyword, std::pmr::vector<Token> params, "
+            "std::pmr::vector<Stmt*> body",
+            "Literal  : Token value, mutable ConstantCache constant",
             "Logical  : Expr left, Token op, Expr right",
-            "Set      : Expr object, Token name, Expr value",
+            "Set      : Expr object, Token name, Expr value, "
+            "mutable PropertyCache cache",
             "Super    : Token keyword, Token method",
             "This     : Token keyword",
             "Unary    : Token op, Expr right",
-            "Variable : Token name",
+            "Variable : Token name, mutable GlobalCache global",
         },
         {
             "\"src/syntactics/token.h\"",
             "\"src/syntactics/stmt.fwd.h\"",
+            "\"src/syntactics/property_cache.h\"",
+            "\"src/syntactics/global_cache.h\"",
+            "\"src/syntactics/constant_cache.h\"",
+            "\"src/syntactics/binary_specialization.h\"",
+            "<memory_resource>",
             "<vector>",
         });
 
     define_and_format_ast(
         output_dir, "Stmt",
         {
-            "Block      : std::vector<std::shared_ptr<Stmt>> statements",
-            "Class      : Token name, std::shared_ptr<Expr::Variable> "
-            "superclass, std::vector<std::shared_ptr<Stmt::Function>> methods",
-            "Expression : std::shared_ptr<Expr> expression",
-            "If         : std::shared_ptr<Expr> condition, Stmt then_branch,"
-            "   Stmt else_branch",
-            "Function   : Token name, std::vector<Token> params, "
-            "std::vector<std::shared_ptr<Stmt>> body",
-            "Print      : std::shared_ptr<Expr> expression",
-            "Return     : Token keyword, std::shared_ptr<Expr> value",
-            "Var        : Token name, std::shared_ptr<Expr> initializer",
-            "While      : std::shared_ptr<Expr> condition, Stmt body",
+            "Block      : std::pmr::vector<Stmt*> statements",
+            "Class      : Token name, Expr::Variable* superclass, "
+            "std::pmr::vector<Stmt::Function*> methods",
+            "Expression : Expr expression",
+            "If         : Expr condition, Stmt then_branch, Stmt else_branch",
+            "Function   : Token name, std::pmr::vector<Token> params, "
+            "std::pmr::vector<Stmt*> body",
+            "Print      : Expr expression",
+            "Return     : Token keyword, Expr value",
+            "Var        : Token name, Expr initializer",
+            "While      : Expr condition, Stmt body, "
+            "mutable std::optional<CountedLoop> counted",
         },
         {
             "\"src/syntactics/expr.h\"",
+            "\"src/syntactics/counted_loop.h\"",
+            "<memory_resource>",
+            "<optional>",
             "<vector>",
         },
         true);
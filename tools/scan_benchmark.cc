@@ -0,0 +1,53 @@
+#include "src/syntactics/scanner.h"
+#include "src/syntactics/source.h"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+// Scans a script a number of times and prints how fast the fastest run went,
+// on 1, 2, 4 and so on up to `max_threads` threads.
+int main(int argc, char **argv) {
+    if (argc < 2 or argc > 4) {
+        fmt::print(stderr,
+                   "Usage: scan_benchmark script [runs] [max_threads]\n");
+        return 64;
+    }
+    int runs = argc >= 3 ? std::atoi(argv[2]) : 10;
+    size_t max_threads = argc == 4 ? std::atoi(argv[3]) : 1;
+    std::string text(Source::open(argv[1])->text());
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double best_seconds = 0;
+        size_t tokens = 0;
+        for (int run = 0; run < runs; ++run) {
+            // Scanning takes its source, so every run copies the text first.
+            auto source = std::make_unique<const Source>(text);
+            auto start = std::chrono::steady_clock::now();
+            Scanner scanner(std::move(source));
+            scanner.scan_ahead(threads);
+            std::chrono::duration<double> seconds =
+                std::chrono::steady_clock::now() - start;
+
+            tokens = 1;
+            while (scanner.next_token().type != END_OF_FILE) {
+                ++tokens;
+            }
+            if (scanner.had_error) {
+                return 65;
+            }
+            if (run == 0 or seconds.count() < best_seconds) {
+                best_seconds = seconds.count();
+            }
+        }
+
+        double megabytes = text.size() / 1e6;
+        fmt::print("{:2} threads: {:.1f} MB, {} tokens in {:.3f} s: "
+                   "{:.1f} MB/s, {:.1f} M tokens/s\n",
+                   threads, megabytes, tokens, best_seconds,
+                   megabytes / best_seconds, tokens / best_seconds / 1e6);
+    }
+}